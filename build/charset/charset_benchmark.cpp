@@ -0,0 +1,139 @@
+/*
+ *	Charset Benchmark
+ *	Nana C++ Library(http://www.nanapro.org)
+ *	Copyright(C) 2003-2020 Jinhao(cnjinhao@hotmail.com)
+ *
+ *	Distributed under the Boost Software License, Version 1.0.
+ *	(See accompanying file LICENSE_1_0.txt or copy at
+ *	http://www.boost.org/LICENSE_1_0.txt)
+ *
+ *	@file: build/charset/charset_benchmark.cpp
+ *	@brief: Measures the throughput of the conversions between UTF-8 and wide strings, and between
+ *	UTF-8 and UTF-16 through nana::charset, for ASCII, Latin/CJK mixed, CJK and emoji texts.
+ *	The figures are megabytes of UTF-8 per second.
+ *
+ *	It is not a part of the library. Build it against the library and run it from the root of the repository:
+ *		c++ -std=c++17 -O2 -I include -o charset_benchmark build/charset/charset_benchmark.cpp
+ *			-L<build dir> -lnana -lXft -lfontconfig -lfreetype -lXext -lX11 -lpthread
+ *		./charset_benchmark
+ */
+
+#include <nana/charset.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+using namespace nana;
+
+namespace
+{
+	const std::size_t text_bytes = 8 * 1024 * 1024;
+	const int rounds = 5;
+
+	volatile std::size_t sink;	//Keeps the results from being optimized away
+
+	void put_utf8(std::string& s, unsigned long c)
+	{
+		if (c < 0x80)
+			s += static_cast<char>(c);
+		else if (c < 0x800)
+		{
+			s += static_cast<char>(0xC0 | (c >> 6));
+			s += static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else if (c < 0x10000)
+		{
+			s += static_cast<char>(0xE0 | (c >> 12));
+			s += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			s += static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else
+		{
+			s += static_cast<char>(0xF0 | (c >> 18));
+			s += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+			s += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			s += static_cast<char>(0x80 | (c & 0x3F));
+		}
+	}
+
+	/// Makes a UTF-8 text, cjk_percent of characters are CJK ideographs and emoji_percent are emoji.
+	std::string make_text(unsigned cjk_percent, unsigned emoji_percent)
+	{
+		std::mt19937 rng(cjk_percent * 100 + emoji_percent);
+		std::string text;
+		while (text.size() < text_bytes)
+		{
+			auto const dice = rng() % 100;
+			if (dice < cjk_percent)
+				put_utf8(text, 0x4E00 + rng() % 0x5000);
+			else if (dice < cjk_percent + emoji_percent)
+				put_utf8(text, 0x1F600 + rng() % 0x50);
+			else
+				put_utf8(text, (rng() % 8 ? 'a' + rng() % 26 : ' '));
+		}
+		return text;
+	}
+
+	template<typename Function>
+	double megabytes_per_second(std::size_t bytes, Function fn)
+	{
+		auto const start = std::chrono::steady_clock::now();
+		for (int r = 0; r < rounds; ++r)
+			fn();
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		return bytes * rounds / elapsed.count() / (1024 * 1024);
+	}
+}
+
+int main()
+{
+	struct sample
+	{
+		const char* name;
+		std::string text;
+	} samples[] = {
+		{ "ascii", make_text(0, 0) },
+		{ "mixed", make_text(30, 0) },
+		{ "cjk", make_text(100, 0) },
+		{ "emoji", make_text(0, 100) }
+	};
+
+	std::printf("%-8s %14s %14s %14s %14s %14s\n", "text", "to wide MB/s", "reused MB/s", "to utf8 MB/s", "to utf16 MB/s", "from utf16 MB/s");
+	for (auto & sm : samples)
+	{
+		auto const & text = sm.text;
+		auto const wide = utf::utf8_to_wide(text.data(), text.size());
+		auto const utf16 = charset(text, unicode::utf8).to_bytes(unicode::utf16);
+
+		auto to_wide = megabytes_per_second(text.size(), [&]
+		{
+			sink = sink + utf::utf8_to_wide(text.data(), text.size()).size();
+		});
+
+		std::wstring reused;
+		auto to_wide_reused = megabytes_per_second(text.size(), [&]
+		{
+			utf::utf8_to_wide(text.data(), text.size(), reused);
+			sink = sink + reused.size();
+		});
+
+		auto to_utf8 = megabytes_per_second(text.size(), [&]
+		{
+			sink = sink + utf::wide_to_utf8(wide.data(), wide.size()).size();
+		});
+
+		auto to_utf16 = megabytes_per_second(text.size(), [&]
+		{
+			sink = sink + charset(text, unicode::utf8).to_bytes(unicode::utf16).size();
+		});
+
+		auto from_utf16 = megabytes_per_second(text.size(), [&]
+		{
+			sink = sink + charset(utf16, unicode::utf16).to_bytes(unicode::utf8).size();
+		});
+
+		std::printf("%-8s %14.1f %14.1f %14.1f %14.1f %14.1f\n", sm.name, to_wide, to_wide_reused, to_utf8, to_utf16, from_utf16);
+	}
+	return 0;
+}
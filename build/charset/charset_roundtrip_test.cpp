@@ -0,0 +1,383 @@
+/*
+ *	Charset Round-trip Test
+ *	Nana C++ Library(http://www.nanapro.org)
+ *	Copyright(C) 2003-2020 Jinhao(cnjinhao@hotmail.com)
+ *
+ *	Distributed under the Boost Software License, Version 1.0.
+ *	(See accompanying file LICENSE_1_0.txt or copy at
+ *	http://www.boost.org/LICENSE_1_0.txt)
+ *
+ *	@file: build/charset/charset_roundtrip_test.cpp
+ *	@brief: Checks the transcoder between UTF-8, UTF-16, UTF-32 and wide strings. The ill-formed inputs,
+ *	overlong sequences, encoded surrogates, truncated sequences and the values above U+10FFFF, are fed in
+ *	both directions, then random valid texts are converted round trip and random bytes are fuzzed.
+ *	It returns the number of failed checks.
+ *
+ *	The ill-formed UTF-8 sequences are passed to the encoding error police, so the test doesn't expect a
+ *	specified replacement for them. It only checks that no ill-formed sequence is decoded to a character,
+ *	that the output is valid and that the decoder resynchronizes at the next character.
+ *
+ *	It is not a part of the library. Build it against the library and run it from the root of the repository:
+ *		c++ -std=c++17 -I include -o charset_roundtrip_test build/charset/charset_roundtrip_test.cpp
+ *			-L<build dir> -lnana -lXft -lfontconfig -lfreetype -lXext -lX11 -lpthread
+ *		./charset_roundtrip_test [iterations]
+ */
+
+#include <nana/charset.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+using namespace nana;
+
+namespace
+{
+	int failures = 0;
+
+	void check(bool cond, const char* what)
+	{
+		if (!cond)
+		{
+			++failures;
+			std::printf("FAIL: %s\n", what);
+		}
+	}
+
+	void put_utf8(std::string& s, unsigned long c)
+	{
+		if (c < 0x80)
+			s += static_cast<char>(c);
+		else if (c < 0x800)
+		{
+			s += static_cast<char>(0xC0 | (c >> 6));
+			s += static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else if (c < 0x10000)
+		{
+			s += static_cast<char>(0xE0 | (c >> 12));
+			s += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			s += static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else
+		{
+			s += static_cast<char>(0xF0 | (c >> 18));
+			s += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+			s += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			s += static_cast<char>(0x80 | (c & 0x3F));
+		}
+	}
+
+	void put_utf16(std::string& s, unsigned long c)
+	{
+		auto put = [&s](unsigned long u)
+		{
+			unsigned short unit = static_cast<unsigned short>(u);
+			s.append(reinterpret_cast<const char*>(&unit), 2);
+		};
+
+		if (c < 0x10000)
+			put(c);
+		else
+		{
+			put(0xD800 + ((c - 0x10000) >> 10));
+			put(0xDC00 + ((c - 0x10000) & 0x3FF));
+		}
+	}
+
+	void put_utf32(std::string& s, unsigned long c)
+	{
+		unsigned unit = static_cast<unsigned>(c);
+		s.append(reinterpret_cast<const char*>(&unit), 4);
+	}
+
+	void put_wide(std::wstring& s, unsigned long c)
+	{
+		if (sizeof(wchar_t) == 2 && c >= 0x10000)
+		{
+			s += static_cast<wchar_t>(0xD800 + ((c - 0x10000) >> 10));
+			s += static_cast<wchar_t>(0xDC00 + ((c - 0x10000) & 0x3FF));
+		}
+		else
+			s += static_cast<wchar_t>(c);
+	}
+
+	/// Returns true if the wide string has neither an unpaired surrogate nor a value above U+10FFFF.
+	bool valid_wide(const std::wstring& s)
+	{
+		for (std::size_t i = 0; i < s.size(); ++i)
+		{
+			const unsigned long c = static_cast<std::make_unsigned<wchar_t>::type>(s[i]);
+			if (0xD800 <= c && c <= 0xDBFF && sizeof(wchar_t) == 2 && i + 1 < s.size())
+			{
+				const unsigned long low = static_cast<std::make_unsigned<wchar_t>::type>(s[i + 1]);
+				if (0xDC00 <= low && low <= 0xDFFF)
+				{
+					++i;
+					continue;
+				}
+			}
+
+			if ((0xD800 <= c && c <= 0xDFFF) || c > 0x10FFFF)
+				return false;
+		}
+		return true;
+	}
+
+	/// Returns true if the string is well-formed UTF-8.
+	bool valid_utf8(const std::string& s)
+	{
+		auto w = utf::utf8_to_wide(s.data(), s.size());
+		return valid_wide(w) && (utf::wide_to_utf8(w.data(), w.size()) == s);
+	}
+
+	/// Returns a random code point which is not a surrogate. The BOMs are excluded, since a leading BOM of
+	/// UTF-16/UTF-32 bytes is taken as the byte order mark rather than a character.
+	unsigned long random_char(std::mt19937& rng)
+	{
+		switch (rng() % 4)
+		{
+		case 0:	return rng() % 0x80;
+		case 1: return 0x80 + rng() % 0x780;
+		case 2:
+			for (;;)
+			{
+				unsigned long c = 0x800 + rng() % 0xF800;
+				if ((c < 0xD800 || c > 0xDFFF) && c != 0xFEFF && c != 0xFFFE)
+					return c;
+			}
+		}
+		return 0x10000 + rng() % 0x100000;
+	}
+
+	/// Decodes an ill-formed UTF-8 sequence followed by 'x' in every way the library offers.
+	void check_ill_formed_utf8(const char* seq, unsigned long forbidden, const char* what)
+	{
+		const std::string s = std::string(seq) + "x";
+
+		std::wstring outputs[] = {
+			utf::utf8_to_wide(s.data(), s.size()),
+			std::wstring(charset(s, unicode::utf8))
+		};
+
+		for (auto & w : outputs)
+		{
+			bool decoded = false;
+			for (auto c : w)
+				decoded |= (static_cast<unsigned long>(c) == forbidden);
+
+			check(!decoded, what);
+			check(valid_wide(w), what);
+			check(w.size() <= s.size(), what);
+			check(!w.empty() && w.back() == L'x', what);
+		}
+
+		//The UTF-16 and UTF-32 outputs must not contain the forbidden character or an invalid unit.
+		auto u32 = charset(s, unicode::utf8).to_bytes(unicode::utf32);
+		check(u32.size() % 4 == 0, what);
+		for (std::size_t i = 0; i + 4 <= u32.size(); i += 4)
+		{
+			unsigned c;
+			std::memcpy(&c, u32.data() + i, 4);
+			check(c != forbidden && c <= 0x10FFFF && (c < 0xD800 || c > 0xDFFF), what);
+		}
+
+		auto u16 = charset(s, unicode::utf8).to_bytes(unicode::utf16);
+		check(u16.size() % 2 == 0, what);
+		check(std::wstring(charset(u16, unicode::utf16)).back() == L'x', what);
+	}
+
+	void check_ill_formed_utf8()
+	{
+		check_ill_formed_utf8("\xC0\xAF", '/', "overlong 2-byte '/' is not decoded");
+		check_ill_formed_utf8("\xC1\xBF", 0x7F, "overlong 2-byte U+007F is not decoded");
+		check_ill_formed_utf8("\xE0\x80\xAF", '/', "overlong 3-byte '/' is not decoded");
+		check_ill_formed_utf8("\xE0\x9F\xBF", 0x7FF, "overlong 3-byte U+07FF is not decoded");
+		check_ill_formed_utf8("\xF0\x80\x80\xAF", '/', "overlong 4-byte '/' is not decoded");
+		check_ill_formed_utf8("\xF0\x8F\xBF\xBF", 0xFFFF, "overlong 4-byte U+FFFF is not decoded");
+		check_ill_formed_utf8("\xED\xA0\x80", 0xD800, "encoded high surrogate is not decoded");
+		check_ill_formed_utf8("\xED\xBF\xBF", 0xDFFF, "encoded low surrogate is not decoded");
+		check_ill_formed_utf8("\xED\xA0\xBD\xED\xB8\x80", 0x1F600, "encoded surrogate pair is not decoded");
+		check_ill_formed_utf8("\xF4\x90\x80\x80", 0x110000, "U+110000 is not decoded");
+		check_ill_formed_utf8("\xF7\xBF\xBF\xBF", 0x1FFFFF, "U+1FFFFF is not decoded");
+		check_ill_formed_utf8("\xF8\x88\x80\x80\x80", 0x200000, "5-byte sequence is not decoded");
+		check_ill_formed_utf8("\xFC\x84\x80\x80\x80\x80", 0x4000000, "6-byte sequence is not decoded");
+		check_ill_formed_utf8("\xC3", 0xC0, "truncated 2-byte sequence is not decoded");
+		check_ill_formed_utf8("\xE2\x82", 0x20AC, "truncated 3-byte sequence is not decoded");
+		check_ill_formed_utf8("\xF0\x9F\x98", 0x1F600, "truncated 4-byte sequence is not decoded");
+		check_ill_formed_utf8("\x80\xBF", 0x3F, "stray continuation bytes are not decoded");
+		check_ill_formed_utf8("\xFE\xFF", 0xFEFF, "0xFE and 0xFF are not decoded");
+
+		//A truncated sequence at the very end must not read past the end of the input.
+		const char truncated[] = { 'a', '\xF0', '\x9F', '\x98', '\x80' };
+		auto w = utf::utf8_to_wide(truncated, 4);
+		bool decoded = false;
+		for (auto c : w)
+			decoded |= (static_cast<unsigned long>(c) == 0x1F600);
+		check(!decoded && w.size() <= 4 && w[0] == L'a', "truncated sequence at the end is not completed by the next byte");
+	}
+
+	void check_ill_formed_wide()
+	{
+		const std::string fffd = "\xEF\xBF\xBD";
+
+		//Lone surrogates in a wide string
+		const wchar_t lone_high[] = { L'a', static_cast<wchar_t>(0xD800), L'b' };
+		check(utf::wide_to_utf8(lone_high, 3) == "a" + fffd + "b", "lone high surrogate of wide string is replaced with U+FFFD");
+
+		const wchar_t lone_low[] = { L'a', static_cast<wchar_t>(0xDC00), L'b' };
+		check(utf::wide_to_utf8(lone_low, 3) == "a" + fffd + "b", "lone low surrogate of wide string is replaced with U+FFFD");
+
+		const wchar_t trailing_high[] = { L'a', static_cast<wchar_t>(0xDBFF) };
+		check(utf::wide_to_utf8(trailing_high, 2) == "a" + fffd, "high surrogate at the end of wide string is replaced with U+FFFD");
+
+		if (sizeof(wchar_t) == 4)
+		{
+			const wchar_t pair[] = { static_cast<wchar_t>(0xD83D), static_cast<wchar_t>(0xDE00) };
+			check(utf::wide_to_utf8(pair, 2) == fffd + fffd, "surrogate pair of UTF-32 wide string is replaced with U+FFFD");
+
+			const wchar_t above[] = { static_cast<wchar_t>(0x110000), L'b' };
+			check(utf::wide_to_utf8(above, 2) == fffd + "b", "U+110000 of wide string is replaced with U+FFFD");
+
+			const wchar_t negative[] = { static_cast<wchar_t>(-1), L'b' };
+			check(utf::wide_to_utf8(negative, 2) == fffd + "b", "0xFFFFFFFF of wide string is replaced with U+FFFD");
+		}
+
+		//Lone surrogates of UTF-16 bytes
+		std::string u16;
+		put_utf16(u16, 'a');
+		put_utf16(u16, 0xD800);
+		put_utf16(u16, 'b');
+		put_utf16(u16, 0xDC00);
+		check(charset(u16, unicode::utf16).to_bytes(unicode::utf8) == "a" + fffd + "b" + fffd, "lone surrogates of UTF-16 are replaced with U+FFFD");
+
+		std::string u16_truncated;
+		put_utf16(u16_truncated, 'a');
+		u16_truncated += 'b';	//An odd byte
+		auto odd = charset(u16_truncated, unicode::utf16).to_bytes(unicode::utf8);
+		check(odd.size() >= 1 && odd[0] == 'a' && valid_utf8(odd), "odd byte of UTF-16 doesn't produce an invalid output");
+
+		//Surrogates and values above U+10FFFF of UTF-32 bytes
+		std::string u32;
+		put_utf32(u32, 'a');
+		put_utf32(u32, 0xD800);
+		put_utf32(u32, 0x110000);
+		put_utf32(u32, 0xFFFFFFFF);
+		put_utf32(u32, 'b');
+		check(charset(u32, unicode::utf32).to_bytes(unicode::utf8) == "a" + fffd + fffd + fffd + "b", "invalid code points of UTF-32 are replaced with U+FFFD");
+
+		auto u32_to_16 = charset(u32, unicode::utf32).to_bytes(unicode::utf16);
+		check(std::wstring(charset(u32_to_16, unicode::utf16)) == L"a\xFFFD\xFFFD\xFFFD" L"b", "invalid code points of UTF-32 are replaced with U+FFFD in UTF-16");
+	}
+
+	void check_round_trip(std::mt19937& rng, int iterations)
+	{
+		int failed = 0;
+		for (int i = 0; i < iterations; ++i)
+		{
+			std::string u8, u16, u32;
+			std::wstring wide;
+
+			for (auto n = rng() % 80; n; --n)
+			{
+				//Long ASCII runs take the fast path of the transcoder.
+				if (rng() % 3 == 0)
+				{
+					for (auto r = rng() % 40; r; --r)
+					{
+						const unsigned long c = 'a' + rng() % 26;
+						put_utf8(u8, c);
+						put_utf16(u16, c);
+						put_utf32(u32, c);
+						put_wide(wide, c);
+					}
+				}
+
+				const auto c = random_char(rng);
+				put_utf8(u8, c);
+				put_utf16(u16, c);
+				put_utf32(u32, c);
+				put_wide(wide, c);
+			}
+
+			bool ok = (utf::utf8_to_wide(u8.data(), u8.size()) == wide);
+			ok = ok && (utf::wide_to_utf8(wide.data(), wide.size()) == u8);
+			ok = ok && (charset(u8, unicode::utf8).to_bytes(unicode::utf16) == u16);
+			ok = ok && (charset(u8, unicode::utf8).to_bytes(unicode::utf32) == u32);
+			ok = ok && (charset(u16, unicode::utf16).to_bytes(unicode::utf8) == u8);
+			ok = ok && (charset(u16, unicode::utf16).to_bytes(unicode::utf32) == u32);
+			ok = ok && (charset(u32, unicode::utf32).to_bytes(unicode::utf8) == u8);
+			ok = ok && (charset(u32, unicode::utf32).to_bytes(unicode::utf16) == u16);
+			ok = ok && (std::wstring(charset(u8, unicode::utf8)) == wide);
+			ok = ok && (std::wstring(charset(u16, unicode::utf16)) == wide);
+			ok = ok && (std::wstring(charset(u32, unicode::utf32)) == wide);
+			ok = ok && (charset(wide).to_bytes(unicode::utf8) == u8);
+
+			std::wstring reused = L"a reused string which is longer than some of the texts";
+			utf::utf8_to_wide(u8.data(), u8.size(), reused);
+			std::string reused8 = "a reused string which is longer than some of the texts";
+			utf::wide_to_utf8(wide.data(), wide.size(), reused8);
+			ok = ok && (reused == wide) && (reused8 == u8);
+
+			if (!ok)
+				++failed;
+		}
+		check(failed == 0, "random valid texts are converted round trip");
+	}
+
+	void check_garbage(std::mt19937& rng, int iterations)
+	{
+		int failed = 0;
+		for (int i = 0; i < iterations; ++i)
+		{
+			std::string bytes;
+			for (auto n = rng() % 64; n; --n)
+			{
+				//Mostly the bytes which start or continue multi-byte sequences
+				bytes += static_cast<char>(rng() % 4 ? 0x80 + rng() % 0x80 : rng() % 0x100);
+			}
+
+			auto w = utf::utf8_to_wide(bytes.data(), bytes.size());
+			bool ok = valid_wide(w) && (w.size() <= bytes.size());
+			ok = ok && valid_wide(std::wstring(charset(bytes, unicode::utf16)));
+			ok = ok && valid_wide(std::wstring(charset(bytes, unicode::utf32)));
+
+			ok = ok && valid_utf8(utf::wide_to_utf8(w.data(), w.size()));
+
+			//A string is copied without validation if it is converted to its own encoding.
+			for (auto from : { unicode::utf16, unicode::utf32 })
+			{
+				auto u8 = charset(bytes, from).to_bytes(unicode::utf8);
+				ok = ok && valid_utf8(u8);
+				ok = ok && (charset(u8, unicode::utf8).to_bytes(unicode::utf32) == charset(charset(u8, unicode::utf8).to_bytes(unicode::utf16), unicode::utf16).to_bytes(unicode::utf32));
+			}
+
+			std::wstring wide;
+			for (auto n = rng() % 64; n; --n)
+				wide += static_cast<wchar_t>(rng() % 2 ? 0xD800 + rng() % 0x800 : rng());
+
+			auto u8 = utf::wide_to_utf8(wide.data(), wide.size());
+			auto back = utf::utf8_to_wide(u8.data(), u8.size());
+			ok = ok && valid_wide(back) && (utf::wide_to_utf8(back.data(), back.size()) == u8);
+
+			if (!ok)
+				++failed;
+		}
+		check(failed == 0, "random bytes and wide units are converted to valid texts");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const int iterations = (argc > 1 ? std::atoi(argv[1]) : 20000);
+	std::mt19937 rng(20200101);
+
+	check_ill_formed_utf8();
+	check_ill_formed_wide();
+	check_round_trip(rng, iterations);
+	check_garbage(rng, iterations);
+
+	std::printf("%d failed\n", failures);
+	return failures;
+}
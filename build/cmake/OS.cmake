@@ -55,6 +55,20 @@ if(UNIX)
             PUBLIC ${X11_INCLUDE_DIR}
             )
 
+    # MIT-SHM - the pixels of pixel_buffer are transferred through shared memory
+    option(NANA_CMAKE_ENABLE_XSHM "Enable the MIT-SHM transport of pixel_buffer if the extension is available" ON)
+    if(NANA_CMAKE_ENABLE_XSHM AND X11_XShm_FOUND)
+        target_compile_definitions(nana PRIVATE NANA_ENABLE_XSHM)
+        target_link_libraries(nana PUBLIC ${X11_Xext_LIB})
+    endif()
+
+    # Headless - graphics is rendered into a memory surface and the text is rasterized by FreeType,
+    # it is also enabled at runtime by the environment variable NANA_HEADLESS or if there is no X server.
+    option(NANA_CMAKE_HEADLESS "Always render graphics without a X server, the windows are unavailable" OFF)
+    if(NANA_CMAKE_HEADLESS)
+        target_compile_definitions(nana PRIVATE NANA_HEADLESS)
+    endif()
+
     find_package(Freetype)                # Freetype - todo test PRIVATE
     if (FREETYPE_FOUND)
         find_package(Fontconfig REQUIRED)
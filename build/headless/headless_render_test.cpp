@@ -0,0 +1,126 @@
+/*
+ *	Headless Rendering Test
+ *	Nana C++ Library(http://www.nanapro.org)
+ *	Copyright(C) 2003-2020 Jinhao(cnjinhao@hotmail.com)
+ *
+ *	Distributed under the Boost Software License, Version 1.0.
+ *	(See accompanying file LICENSE_1_0.txt or copy at
+ *	http://www.boost.org/LICENSE_1_0.txt)
+ *
+ *	@file: build/headless/headless_render_test.cpp
+ *	@brief: Draws shapes, text, blends, gradients and a stretch into paint::graphics without an X server,
+ *	and checks the pixels of the memory surface. It returns the number of failed checks.
+ *
+ *	It is not a part of the library. Build the library with NANA_CMAKE_HEADLESS, or set the environment
+ *	variable NANA_HEADLESS, and run it from the root of the repository:
+ *		c++ -std=c++17 -I include -o headless_render_test build/headless/headless_render_test.cpp -L<build dir> -lnana
+ *			-lXft -lfontconfig -lfreetype -lXext -lX11 -lpthread
+ *		NANA_HEADLESS=1 ./headless_render_test [output.ppm]
+ *	The rendered image is written to output.ppm if it is specified.
+ */
+
+#include <nana/paint/graphics.hpp>
+#include <nana/paint/pixel_buffer.hpp>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace nana;
+
+namespace
+{
+	int failures = 0;
+
+	void check(bool cond, const char* what)
+	{
+		if (!cond)
+			++failures;
+		std::printf("%s: %s\n", (cond ? "ok  " : "FAIL"), what);
+	}
+
+	unsigned rgb(const paint::pixel_buffer& pxbuf, unsigned x, unsigned y)
+	{
+		return (pxbuf.raw_ptr(y)[x].value & 0xFFFFFF);
+	}
+
+	bool near_rgb(unsigned a, unsigned b, unsigned tolerance)
+	{
+		for (int shift = 0; shift < 24; shift += 8)
+		{
+			const int ca = (a >> shift) & 0xFF, cb = (b >> shift) & 0xFF;
+			if (static_cast<unsigned>(std::abs(ca - cb)) > tolerance)
+				return false;
+		}
+		return true;
+	}
+
+	bool dark(unsigned px)
+	{
+		return ((px & 0xFF) < 0x50) && (((px >> 8) & 0xFF) < 0x50) && (((px >> 16) & 0xFF) < 0x50);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	paint::graphics graph({ 200, 60 });
+	check(!graph.empty(), "graphics is created without an X server");
+
+	graph.rectangle(true, colors::white);
+	graph.rectangle(rectangle{ 10, 10, 50, 20 }, false, colors::red);
+	graph.line({ 0, 0 }, { 199, 59 }, colors::blue);
+
+	const char* text = "Hello headless";
+	graph.string({ 20, 34 }, text, colors::black);
+
+	const auto extent = graph.text_extent_size(text);
+	check(extent.width > 0 && extent.height > 0, "text extent is measured by FreeType");
+
+	paint::graphics green({ 40, 15 });
+	green.rectangle(true, colors::green);
+	graph.bitblt(rectangle{ 150, 40, 40, 15 }, green);
+
+	graph.blend(rectangle{ 100, 0, 20, 10 }, colors::yellow, 0.5);
+	graph.gradual_rectangle(rectangle{ 130, 0, 20, 30 }, colors::red, colors::blue, true);
+
+	paint::pixel_buffer pxbuf(graph.handle(), 0, 0);
+	check(pxbuf.size() == nana::size(200, 60), "pixel buffer is opened from the memory surface");
+
+	check(rgb(pxbuf, 5, 50) == 0xFFFFFF, "solid rectangle");
+	check(rgb(pxbuf, 30, 10) == 0xFF0000 && rgb(pxbuf, 30, 20) == 0xFFFFFF, "outlined rectangle");
+	check(rgb(pxbuf, 0, 0) == 0x0000FF, "line");
+	check(rgb(pxbuf, 160, 45) == 0x008000, "bitblt");
+	check(near_rgb(rgb(pxbuf, 110, 5), 0xFFFF7F, 2), "blend");
+	check(near_rgb(rgb(pxbuf, 140, 0), 0xFF0000, 16) && near_rgb(rgb(pxbuf, 140, 29), 0x0000FF, 16), "gradual rectangle");
+
+	unsigned text_pixels = 0;
+	for (unsigned y = 34; y < 34 + extent.height && y < 60; ++y)
+		for (unsigned x = 20; x < 20 + extent.width && x < 200; ++x)
+			text_pixels += (dark(rgb(pxbuf, x, y)) ? 1 : 0);
+	check(text_pixels > 50, "text is rasterized");
+
+	paint::graphics stretched({ 400, 120 });
+	pxbuf.stretch(rectangle{ 0, 0, 200, 60 }, stretched.handle(), rectangle{ 0, 0, 400, 120 });
+	paint::pixel_buffer stretched_pxbuf(stretched.handle(), 0, 0);
+	check(rgb(stretched_pxbuf, 10, 100) == 0xFFFFFF && rgb(stretched_pxbuf, 320, 90) == 0x008000, "stretch");
+
+	if (argc > 1)
+	{
+		auto file = std::fopen(argv[1], "wb");
+		if (file)
+		{
+			std::fprintf(file, "P6 %u %u 255\n", pxbuf.size().width, pxbuf.size().height);
+			for (unsigned y = 0; y < pxbuf.size().height; ++y)
+			{
+				for (unsigned x = 0; x < pxbuf.size().width; ++x)
+				{
+					auto px = pxbuf.raw_ptr(y)[x];
+					unsigned char c[3] = { px.element.red, px.element.green, px.element.blue };
+					std::fwrite(c, 1, 3, file);
+				}
+			}
+			std::fclose(file);
+		}
+	}
+
+	std::printf("%d failed\n", failures);
+	return failures;
+}
@@ -0,0 +1,131 @@
+/*
+ *	Listbox Append Benchmark
+ *	Nana C++ Library(http://www.nanapro.org)
+ *	Copyright(C) 2003-2020 Jinhao(cnjinhao@hotmail.com)
+ *
+ *	Distributed under the Boost Software License, Version 1.0.
+ *	(See accompanying file LICENSE_1_0.txt or copy at
+ *	http://www.boost.org/LICENSE_1_0.txt)
+ *
+ *	@file: build/listbox/append_range_benchmark.cpp
+ *	@brief: Measures the time of appending items to a shown listbox one by one, one by one with auto_draw
+ *	disabled, and by cat_proxy::append_range, without and with a sorted column. It checks that the three
+ *	ways produce the same items and returns the number of mismatches.
+ *
+ *	It is not a part of the library. It creates a window, so it requires an X server on Linux. Build it
+ *	against the library and run it from the root of the repository:
+ *		c++ -std=c++17 -O2 -I include -o append_range_benchmark build/listbox/append_range_benchmark.cpp
+ *			-L<build dir> -lnana -lXft -lfontconfig -lfreetype -lXext -lX11 -lpthread
+ *		./append_range_benchmark [items]
+ */
+
+#include <nana/gui.hpp>
+#include <nana/gui/widgets/listbox.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace nana;
+
+namespace
+{
+	struct row
+	{
+		std::string name;
+		int number;
+		double value;
+	};
+
+	listbox::oresolver& operator<<(listbox::oresolver& ores, const row& r)
+	{
+		return ores << r.name << r.number << r.value;
+	}
+
+	std::vector<row> make_rows(std::size_t n)
+	{
+		std::mt19937 rng(1);
+		std::vector<row> rows;
+		for (std::size_t i = 0; i < n; ++i)
+			rows.push_back({ "item " + std::to_string(rng() % 100000), static_cast<int>(rng() % 1000), (rng() % 10000) / 100.0 });
+		return rows;
+	}
+
+	/// Collects the texts of the items in the display order
+	std::vector<std::string> texts(listbox& lb)
+	{
+		std::vector<std::string> result;
+		for (auto & item : lb.at(0))
+			result.push_back(item.text(0) + '|' + item.text(1) + '|' + item.text(2));
+		return result;
+	}
+
+	template<typename Function>
+	double milliseconds(Function fn)
+	{
+		auto const start = std::chrono::steady_clock::now();
+		fn();
+		const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const std::size_t n = (argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000);
+	const auto rows = make_rows(n);
+
+	form fm{ API::make_center(640, 480) };
+	fm.show();
+
+	int mismatches = 0;
+	std::printf("%zu items\n%-8s %14s %20s %18s\n", n, "sorted", "append ms", "append no-draw ms", "append_range ms");
+	for (bool sorted : { false, true })
+	{
+		std::vector<std::string> results[3];
+		double times[3];
+		for (int way = 0; way < 3; ++way)
+		{
+			listbox lb{ fm, rectangle{ 0, 0, 640, 480 } };
+			lb.append_header("name", 200);
+			lb.append_header("number", 100);
+			lb.append_header("value", 100);
+			if (sorted)
+				lb.sort_col(0);
+
+			auto cat = lb.at(0);
+			times[way] = milliseconds([&]
+			{
+				switch (way)
+				{
+				case 0:
+					for (auto & r : rows)
+						cat.append(r);
+					break;
+				case 1:
+					lb.auto_draw(false);
+					for (auto & r : rows)
+						cat.append(r);
+					lb.auto_draw(true);
+					break;
+				default:
+					cat.append_range(rows.begin(), rows.end());
+				}
+			});
+			results[way] = texts(lb);
+		}
+
+		for (int way = 1; way < 3; ++way)
+		{
+			if (results[way] != results[0])
+			{
+				++mismatches;
+				std::printf("mismatch: way %d of %s listbox\n", way, (sorted ? "sorted" : "unsorted"));
+			}
+		}
+		std::printf("%-8s %14.1f %20.1f %18.1f\n", (sorted ? "yes" : "no"), times[0], times[1], times[2]);
+	}
+	return mismatches;
+}
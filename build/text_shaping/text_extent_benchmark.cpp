@@ -0,0 +1,131 @@
+/*
+ *	Text Extent Benchmark
+ *	Nana C++ Library(http://www.nanapro.org)
+ *	Copyright(C) 2003-2020 Jinhao(cnjinhao@hotmail.com)
+ *
+ *	Distributed under the Boost Software License, Version 1.0.
+ *	(See accompanying file LICENSE_1_0.txt or copy at
+ *	http://www.boost.org/LICENSE_1_0.txt)
+ *
+ *	@file: build/text_shaping/text_extent_benchmark.cpp
+ *	@brief: Measures the throughput of text_extent_size and glyph_pixels for Latin, mixed Latin/Arabic
+ *	and Arabic texts, and the cost of unicode_reorder which is skipped for the texts that only consist
+ *	of left-to-right characters. The shaped run cache is disabled, so that every text is shaped.
+ *
+ *	It is not a part of the library. Build it against the library and run it from the root of the repository:
+ *		c++ -std=c++17 -O2 -I include -o text_extent_benchmark build/text_shaping/text_extent_benchmark.cpp
+ *			-L<build dir> -lnana -lXft -lfontconfig -lfreetype -lXext -lX11 -lpthread
+ *		./text_extent_benchmark
+ *	The Xft text path is measured if an X server is available, otherwise the headless path is measured.
+ */
+
+#include <nana/paint/graphics.hpp>
+#include <nana/paint/text_cache.hpp>
+#include <nana/unicode_bidi.hpp>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace nana;
+
+namespace
+{
+	const std::size_t texts = 2000;
+	const int rounds = 5;
+
+	volatile std::size_t sink;	//Keeps the results from being optimized away
+
+	std::wstring latin_word(std::mt19937& rng)
+	{
+		std::wstring word;
+		for (auto n = 2 + rng() % 8; n; --n)
+			word += static_cast<wchar_t>(L'a' + rng() % 26);
+		return word;
+	}
+
+	std::wstring arabic_word(std::mt19937& rng)
+	{
+		std::wstring word;
+		for (auto n = 2 + rng() % 6; n; --n)
+			word += static_cast<wchar_t>(0x0627 + rng() % 26);	//ALEF ... GHAIN
+		return word;
+	}
+
+	/// Makes the distinct texts of 8 words, arabic_percent of words are Arabic.
+	std::vector<std::wstring> make_texts(unsigned arabic_percent)
+	{
+		std::mt19937 rng(arabic_percent + 1);
+		std::vector<std::wstring> result;
+		for (std::size_t i = 0; i < texts; ++i)
+		{
+			std::wstring text;
+			for (int w = 0; w < 8; ++w)
+			{
+				if (w)
+					text += L' ';
+				text += (rng() % 100 < arabic_percent ? arabic_word(rng) : latin_word(rng));
+			}
+			result.push_back(text);
+		}
+		return result;
+	}
+
+	template<typename Function>
+	double chars_per_second(const std::vector<std::wstring>& strs, Function fn)
+	{
+		std::size_t chars = 0;
+		auto const start = std::chrono::steady_clock::now();
+		for (int r = 0; r < rounds; ++r)
+		{
+			for (auto & s : strs)
+			{
+				fn(s);
+				chars += s.size();
+			}
+		}
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		return chars / elapsed.count();
+	}
+}
+
+int main()
+{
+	paint::shaped_run_cache_capacity(0);
+
+	paint::graphics graph({ 16, 16 });
+
+	struct script
+	{
+		const char* name;
+		std::vector<std::wstring> strs;
+	} scripts[] = {
+		{ "latin", make_texts(0) },
+		{ "mixed", make_texts(25) },
+		{ "arabic", make_texts(100) }
+	};
+
+	std::printf("%-8s %16s %16s %16s\n", "text", "extent Mchar/s", "pixels Mchar/s", "reorder Mchar/s");
+	for (auto & sc : scripts)
+	{
+		auto extent = chars_per_second(sc.strs, [&](const std::wstring& s)
+		{
+			sink = sink + graph.text_extent_size(s).width;
+		});
+
+		auto pixels = chars_per_second(sc.strs, [&](const std::wstring& s)
+		{
+			if (auto pxbuf = graph.glyph_pixels(s))
+				sink = sink + pxbuf[0];
+		});
+
+		auto reorder = chars_per_second(sc.strs, [&](const std::wstring& s)
+		{
+			sink = sink + unicode_reorder(s.c_str(), s.size()).size();
+		});
+
+		std::printf("%-8s %16.2f %16.2f %16.2f\n", sc.name, extent / 1e6, pixels / 1e6, reorder / 1e6);
+	}
+	return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ *	Unicode Character Property Table Generator
+ *	Nana C++ Library(http://www.nanapro.org)
+ *	Copyright(C) 2003-2020 Jinhao(cnjinhao@hotmail.com)
+ *
+ *	Distributed under the Boost Software License, Version 1.0.
+ *	(See accompanying file LICENSE_1_0.txt or copy at
+ *	http://www.boost.org/LICENSE_1_0.txt)
+ *
+ *	@file: build/unicode_tables/generate_unicode_tables.cpp
+ *	@brief: Generates source/detail/unicode_tables.hpp. The bidi classes and the word break classes are
+ *	defined by the range checks of unicode_ranges.hpp, the program evaluates them for every BMP character
+ *	and writes the two-stage tables to the standard output.
+ *
+ *	It is not a part of the library. Run it from the root of the repository after the ranges are changed:
+ *		c++ -std=c++11 -o generate_unicode_tables build/unicode_tables/generate_unicode_tables.cpp
+ *		./generate_unicode_tables > source/detail/unicode_tables.hpp
+ */
+
+#include "unicode_ranges.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+int main()
+{
+	using namespace nana;
+
+	constexpr unsigned long block_size = 32;
+
+	std::vector<std::vector<unsigned char>> blocks;
+	std::map<std::vector<unsigned char>, std::size_t> block_pos;
+	std::vector<std::size_t> index;
+
+	for (unsigned long first = 0; first < 0x10000; first += block_size)
+	{
+		std::vector<unsigned char> block;
+		for (auto ch = first; ch < first + block_size; ++ch)
+		{
+			auto bidi = static_cast<unsigned>(bidi_charmap::bidi_char_type(static_cast<wchar_t>(ch)));
+			auto word_break = static_cast<unsigned>(unicode_char_type(ch));
+			block.push_back(static_cast<unsigned char>(bidi | (word_break << 5)));
+		}
+
+		auto i = block_pos.find(block);
+		if (i == block_pos.end())
+		{
+			i = block_pos.emplace(block, blocks.size()).first;
+			blocks.push_back(block);
+		}
+		index.push_back(i->second);
+	}
+
+	std::printf("%s",
+		"/*\n"
+		" *\tUnicode Character Property Tables\n"
+		" *\tNana C++ Library(http://www.nanapro.org)\n"
+		" *\tCopyright(C) 2003-2020 Jinhao(cnjinhao@hotmail.com)\n"
+		" *\n"
+		" *\tDistributed under the Boost Software License, Version 1.0.\n"
+		" *\t(See accompanying file LICENSE_1_0.txt or copy at\n"
+		" *\thttp://www.boost.org/LICENSE_1_0.txt)\n"
+		" *\n"
+		" *\t@file: nana/detail/unicode_tables.hpp\n"
+		" *\t@brief: The two-stage lookup tables of the bidi class and the word break class of the BMP characters.\n"
+		" *\tThe tables are generated by build/unicode_tables/generate_unicode_tables.cpp, they are not supposed to be\n"
+		" *\tedited by hand. To change a property, edit the ranges of build/unicode_tables/unicode_ranges.hpp and run\n"
+		" *\tthe generator from the root of the repository:\n"
+		" *\t\tc++ -std=c++11 -o generate_unicode_tables build/unicode_tables/generate_unicode_tables.cpp\n"
+		" *\t\t./generate_unicode_tables > source/detail/unicode_tables.hpp\n"
+		" *\n"
+		" *\tThe properties of a character are packed into a byte, the low 5 bits are the bidi class(bidi_charmap::t)\n"
+		" *\tand the high 3 bits are the word break class(unicode_character_type). The characters are grouped in\n"
+		" *\tblocks of 32 characters, the blocks which have the same properties are shared.\n"
+		" *\n"
+		" *\tThis file should not be included by any header files.\n"
+		" */\n"
+		"\n"
+		"#ifndef NANA_DETAIL_UNICODE_TABLES_HPP\n"
+		"#define NANA_DETAIL_UNICODE_TABLES_HPP\n"
+		"\n"
+		"namespace nana\n"
+		"{\n"
+		"\tnamespace unicode_tables\n"
+		"\t{\n"
+		"\t\t/// The index of block of every 32 characters\n");
+
+	std::printf("\t\tconstexpr unsigned char index[%u] = {\n", static_cast<unsigned>(index.size()));
+	for (std::size_t i = 0; i < index.size(); ++i)
+		std::printf("%s%u,%s", (i % 16 ? " " : "\t\t\t"), static_cast<unsigned>(index[i]), (i % 16 == 15 ? "\n" : ""));
+
+	std::printf("\t\t};\n\n\t\t/// The properties of the distinct blocks\n");
+	std::printf("\t\tconstexpr unsigned char blocks[%u * %u] = {\n", static_cast<unsigned>(blocks.size()), static_cast<unsigned>(block_size));
+	for (std::size_t n = 0; n < blocks.size(); ++n)
+	{
+		for (std::size_t i = 0; i < block_size; ++i)
+		{
+			std::printf("%s0x%02X,", (i % 16 ? " " : "\t\t\t"), static_cast<unsigned>(blocks[n][i]));
+			if (i == 15)
+				std::printf("\t//%u\n", static_cast<unsigned>(n));
+			else if (i % 16 == 15)
+				std::printf("\n");
+		}
+	}
+
+	std::printf("%s",
+		"\t\t};\n"
+		"\n"
+		"\t\t/// Returns the packed properties of a BMP character.\n"
+		"\t\tinline unsigned char property(unsigned long ch)\n"
+		"\t\t{\n"
+		"\t\t\treturn blocks[index[ch >> 5] * 32 + (ch & 31)];\n"
+		"\t\t}\n"
+		"\t}//end namespace unicode_tables\n"
+		"}//end namespace nana\n"
+		"\n"
+		"#endif\n");
+	return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ *	Unicode Character Property Table Benchmark
+ *	Nana C++ Library(http://www.nanapro.org)
+ *	Copyright(C) 2003-2020 Jinhao(cnjinhao@hotmail.com)
+ *
+ *	Distributed under the Boost Software License, Version 1.0.
+ *	(See accompanying file LICENSE_1_0.txt or copy at
+ *	http://www.boost.org/LICENSE_1_0.txt)
+ *
+ *	@file: build/unicode_tables/unicode_tables_benchmark.cpp
+ *	@brief: Checks that the two-stage tables of source/detail/unicode_tables.hpp give the same bidi class and
+ *	word break class as the range checks of unicode_ranges.hpp for every BMP character, then measures both
+ *	lookups for Latin, Arabic, CJK and random BMP texts. It returns the number of mismatched characters.
+ *
+ *	The tables are generated from the range checks, so the check only proves that the tables are up to date
+ *	with the ranges, not that the ranges follow the current Unicode Character Database.
+ *
+ *	It is not a part of the library. Run it from the root of the repository:
+ *		c++ -std=c++11 -O2 -o unicode_tables_benchmark build/unicode_tables/unicode_tables_benchmark.cpp
+ *		./unicode_tables_benchmark
+ */
+
+#include "unicode_ranges.hpp"
+#include "../../source/detail/unicode_tables.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace nana;
+
+namespace
+{
+	const std::size_t text_chars = 1 << 20;
+	const int rounds = 20;
+
+	volatile std::size_t sink;	//Keeps the results from being optimized away
+
+	std::vector<wchar_t> make_text(unsigned long first, unsigned long last, unsigned seed)
+	{
+		std::mt19937 rng(seed);
+		std::vector<wchar_t> text;
+		text.reserve(text_chars);
+		while (text.size() < text_chars)
+		{
+			//Separate the words with spaces, like the texts which are broken into words
+			text.push_back(static_cast<wchar_t>(rng() % 6 ? first + rng() % (last - first + 1) : L' '));
+		}
+		return text;
+	}
+
+	template<typename Function>
+	double chars_per_second(const std::vector<wchar_t>& text, Function fn)
+	{
+		auto const start = std::chrono::steady_clock::now();
+		for (int r = 0; r < rounds; ++r)
+		{
+			std::size_t sum = 0;
+			for (auto ch : text)
+				sum += fn(ch);
+			sink = sink + sum;
+		}
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		return static_cast<double>(text.size()) * rounds / elapsed.count();
+	}
+}
+
+int main()
+{
+	unsigned mismatches = 0;
+	for (unsigned long ch = 0; ch < 0x10000; ++ch)
+	{
+		auto const prop = unicode_tables::property(ch);
+		if (((prop & 0x1F) != static_cast<unsigned>(bidi_charmap::bidi_char_type(static_cast<wchar_t>(ch)))) ||
+			((prop >> 5) != static_cast<unsigned>(unicode_char_type(ch))))
+		{
+			if (mismatches++ < 10)
+				std::printf("mismatch: U+%04lX\n", ch);
+		}
+	}
+	std::printf("%u of 65536 BMP characters mismatch\n\n", mismatches);
+
+	struct sample
+	{
+		const char* name;
+		std::vector<wchar_t> text;
+	} samples[] = {
+		{ "latin", make_text(L'a', L'z', 1) },
+		{ "arabic", make_text(0x0621, 0x064A, 2) },
+		{ "cjk", make_text(0x4E00, 0x9FA5, 3) },
+		{ "bmp", make_text(0x0000, 0xFFFF, 4) }
+	};
+
+	std::printf("%-8s %20s %20s %20s %20s\n", "text", "bidi ranges Mchar/s", "bidi table Mchar/s", "word ranges Mchar/s", "word table Mchar/s");
+	for (auto & sm : samples)
+	{
+		auto bidi_ranges = chars_per_second(sm.text, [](wchar_t ch)
+		{
+			return static_cast<std::size_t>(bidi_charmap::bidi_char_type(ch));
+		});
+
+		auto bidi_table = chars_per_second(sm.text, [](wchar_t ch)
+		{
+			return static_cast<std::size_t>(unicode_tables::property(ch) & 0x1F);
+		});
+
+		auto word_ranges = chars_per_second(sm.text, [](wchar_t ch)
+		{
+			return static_cast<std::size_t>(unicode_char_type(ch));
+		});
+
+		auto word_table = chars_per_second(sm.text, [](wchar_t ch)
+		{
+			return static_cast<std::size_t>(unicode_tables::property(ch) >> 5);
+		});
+
+		std::printf("%-8s %20.1f %20.1f %20.1f %20.1f\n", sm.name, bidi_ranges / 1e6, bidi_table / 1e6, word_ranges / 1e6, word_table / 1e6);
+	}
+	return static_cast<int>(mismatches);
+}
@@ -13,6 +13,7 @@
 #ifndef NANA_CHARSET_HPP
 #define NANA_CHARSET_HPP
 #include <string>
+#include <cstddef>
 
 namespace nana
 {
@@ -32,6 +33,63 @@ namespace nana
 		/// @returns A unicode character. '\0' if pos is out of range.
 		wchar_t char_at(const char* text_utf8, unsigned pos, unsigned * len);
 		wchar_t char_at(const ::std::string& text_utf8, unsigned pos, unsigned * len);
+
+		/// Converts a UTF-8 string to a wide string, it is UTF-16 on Windows and UTF-32 on other platforms.
+		/// The ill-formed sequences are handled in the same way as nana::charset.
+		std::wstring utf8_to_wide(const char* text_utf8, std::size_t len);
+
+		/// Converts a wide string to UTF-8. An unpaired surrogate or an invalid code point is replaced with U+FFFD.
+		std::string wide_to_utf8(const wchar_t* text, std::size_t len);
+
+		/// Converts a UTF-8 string to a wide string which replaces the content of wstr.
+		/// It doesn't allocate memory if the capacity of wstr is large enough, so a reused wstr avoids the allocations.
+		void utf8_to_wide(const char* text_utf8, std::size_t len, std::wstring& wstr);
+
+		/// Converts a wide string to UTF-8 which replaces the content of str.
+		/// It doesn't allocate memory if the capacity of str is large enough, so a reused str avoids the allocations.
+		void wide_to_utf8(const wchar_t* text, std::size_t len, std::string& str);
+
+		/// A wide string converted from UTF-8 into a scratch buffer of the calling thread.
+		/**
+		 * The buffer is taken from a pool of the thread and it is given back when the object is destroyed.
+		 * The pool keeps the capacity of the buffers, so the text which is converted for every redraw doesn't
+		 * allocate memory once the pool is warmed up. The object must be destroyed on the thread which creates it.
+		 */
+		class scratch_wstring
+		{
+		public:
+			scratch_wstring(const char* text_utf8, std::size_t len);
+			scratch_wstring(const ::std::string& text_utf8);
+			~scratch_wstring();
+
+			scratch_wstring(const scratch_wstring&) = delete;
+			scratch_wstring& operator=(const scratch_wstring&) = delete;
+
+			const ::std::wstring& str() const noexcept;
+			const wchar_t* data() const noexcept;
+			std::size_t size() const noexcept;
+		private:
+			::std::wstring* buf_;
+		};
+
+		/// A UTF-8 string converted from a wide string into a scratch buffer of the calling thread.
+		/// \see scratch_wstring
+		class scratch_string
+		{
+		public:
+			scratch_string(const wchar_t* text, std::size_t len);
+			scratch_string(const ::std::wstring& text);
+			~scratch_string();
+
+			scratch_string(const scratch_string&) = delete;
+			scratch_string& operator=(const scratch_string&) = delete;
+
+			const ::std::string& str() const noexcept;
+			const char* data() const noexcept;
+			std::size_t size() const noexcept;
+		private:
+			::std::string* buf_;
+		};
 	}
 
 	enum class unicode
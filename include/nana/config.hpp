@@ -69,6 +69,24 @@
 //
 //#define NANA_ENABLE_AUDIO
 
+///////////////////
+//  Support of MIT-SHM
+//	  Define the NANA_ENABLE_XSHM to transfer the pixels of pixel_buffer through
+//	  shared memory on X11. It requires linking with libXext, and it falls back to
+//	  XGetImage/XPutImage when the X server doesn't support the extension.
+//	  The environment variable NANA_DISABLE_XSHM disables it at runtime.
+//
+//#define NANA_ENABLE_XSHM
+
+///////////////////
+//  Headless rendering
+//	  Define the NANA_HEADLESS to render paint::graphics into a memory surface without
+//	  a X server, the text is rasterized by FreeType. The windows are unavailable.
+//	  The headless mode is also enabled by the environment variable NANA_HEADLESS, or
+//	  when the X display can't be opened.
+//
+//#define NANA_HEADLESS
+
 ///////////////////
 //  Support for PNG
 //	  Define the NANA_ENABLE_PNG to enable the support of PNG.
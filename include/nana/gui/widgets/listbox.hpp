@@ -91,6 +91,8 @@ namespace nana
 				/// Adjusts the width to fit the content
 				/**
 				 * The priority of max: maximum, ranged width, scheme's max_fit_content.
+				 * The measured widths of the cells are cached until the cells or the font are changed, and the number of
+				 * measured items is limited by scheme's max_fit_rows.
 				 * @param maximum Sets the width of column to the maximum if the width of content is larger than maximum
 				 */
 				virtual void fit_content(unsigned maximum = 0) noexcept = 0;
@@ -650,6 +652,19 @@ namespace nana
 				std::unique_ptr<container_interface> container_ptr_;
 			};
 
+			/// The function which fills the cells of a row for a virtual category, the cells vector is empty when it is called.
+			using virtual_fetcher = std::function<void(std::size_t row, std::vector<cell>& cells)>;
+
+			/// The predicate which determines whether a row is displayed when the listbox is filtered.
+			using filter_predicate = std::function<bool(const std::vector<cell>& cells)>;
+
+			/// The kind of keys which the items are sorted by when the sort column has no sort compare.
+			enum class sort_key
+			{
+				text,		///< Compares the texts byte by byte
+				numeric,	///< Compares the texts as numbers, the texts which are not numbers follow the numbers
+				collation	///< Compares the texts by the collation of the global locale
+			};
 
 			/// useful for both absolute and display (sorted) positions
 			struct index_pair
@@ -1032,6 +1047,30 @@ namespace nana
 					return iter;
 				}
 
+				/// Appends the objects of a range at the end of this category, using the oresolver to generate the texts of each item.
+				/**
+				 * The listbox is sorted and refreshed only once for the whole range.
+				 */
+				template<typename InputIt>
+				void append_range(InputIt first, InputIt last)
+				{
+					std::vector<std::vector<cell>> rows;
+					for (; first != last; ++first)
+					{
+						oresolver ores(ess_);
+						ores << *first;
+						rows.emplace_back(ores.move_cells());
+					}
+					append_range(std::move(rows));
+				}
+
+				/// Appends items at the end of this category, the cells of each item are moved into the listbox.
+				/**
+				 * The listbox is sorted and refreshed only once for all the items.
+				 * If the category has a model, the cells are assigned to the new elements of the model.
+				 */
+				void append_range(std::vector<std::vector<cell>> rows);
+
 				template<typename T>
 				void append_model(const T& t)
 				{
@@ -1060,6 +1099,25 @@ namespace nana
 
 				model_guard model();
 
+				/// Makes the category virtual, the rows are owned by the application and only the visible rows are fetched.
+				/**
+				 * The listbox keeps the selection and check states of each row, and the rows that are fetched recently are cached.
+				 * A virtual category is immutable, the items can't be inserted, appended or erased through the listbox.
+				 * @param rows The number of rows.
+				 * @param fetcher The function which fills the cells of a specified row.
+				 * @param cache_rows The maximum number of fetched rows which are cached.
+				 */
+				void virtual_model(std::size_t rows, virtual_fetcher fetcher, std::size_t cache_rows = 1024);
+
+				/// Changes the number of rows of a virtual category, the states of remaining rows are kept.
+				void virtual_size(std::size_t rows);
+
+				/// Discards the cached rows of a virtual category, it should be called when the data of rows are changed.
+				void virtual_refresh();
+
+				/// Determines whether the category is virtual.
+				bool is_virtual() const;
+
 				/// Appends one item at the end of this category with the specifies texts in the column fields
 				void append(std::initializer_list<std::string> texts_utf8);
 				void append(std::initializer_list<std::wstring> texts);
@@ -1186,6 +1244,25 @@ namespace nana
 		arg_listbox_category(const drawerbase::listbox::cat_proxy&) noexcept;
 	};
 
+	/// The event parameter type for listbox's selection_changed
+	struct arg_listbox_selection
+		: public event_arg
+	{
+		/// The items [first, last) of a category, they are absolute positions.
+		struct range
+		{
+			std::size_t cat;
+			std::size_t first;
+			std::size_t last;
+		};
+
+		::nana::listbox & widget;
+		std::vector<range> selected;	///< The items which are selected by the operation
+		std::vector<range> deselected;	///< The items which are deselected by the operation
+
+		arg_listbox_selection(::nana::listbox&) noexcept;
+	};
+
 	namespace drawerbase
 	{
 		namespace listbox
@@ -1197,8 +1274,14 @@ namespace nana
 				basic_event<arg_listbox> checked;
 
 				/// An event occurs when a listbox item is clicked.
+				/**
+				 * It is emitted for every item whose selection is changed, the selection_changed is preferred for a large listbox.
+				 */
 				basic_event<arg_listbox> selected;
 
+				/// An event occurs once for an operation which changes the selection, e.g. selecting all or a range of items.
+				basic_event<arg_listbox_selection> selection_changed;
+
 				/// An event occurs when a listbox category is double clicking.
 				basic_event<arg_listbox_category> category_dbl_click;
 			};
@@ -1221,6 +1304,10 @@ namespace nana
 				/// The max column width which is generated by fit_content is allowed. It is ignored when it is 0, or a max value is passed to fit_content.
 				unsigned max_fit_content{ 0 };
 
+				/// The max number of items which are measured by fit_content. When there are more items, the items with the longest texts are measured,
+				/// and the items of a virtual category are sampled evenly. It is ignored when it is 0.
+				std::size_t max_fit_rows{ 0 };
+
 				unsigned min_column_width{ 20 };  ///< def=20 . non counting suspension_width
 
 				unsigned text_margin{ 5 };  ///<  def= 5. Additional or extended with added (before) to the text width to determine the cell width. cell_w = text_w + ext_w +1
@@ -1326,6 +1413,15 @@ the nana::detail::basic_window member pointer scheme
 		/// The representation of an item cell
 		using cell		= drawerbase::listbox::cell;
 
+		/// The function which fetches the cells of a row of virtual category
+		using virtual_fetcher = drawerbase::listbox::virtual_fetcher;
+
+		/// The predicate which determines whether a row is displayed
+		using filter_predicate = drawerbase::listbox::filter_predicate;
+
+		/// The kind of keys which the items are sorted by
+		using sort_key = drawerbase::listbox::sort_key;
+
 		/// The options for exporting items into a string variable
 		using export_options = drawerbase::listbox::export_options;
 
@@ -1549,6 +1645,21 @@ the nana::detail::basic_window member pointer scheme
 								std::function<bool(const std::string&, nana::any*,
 								                   const std::string&, nana::any*, bool reverse)> strick_ordering);
 
+		/// Sets the kind of keys which a column is sorted by, it is used when the column has no sort compare.
+		/**
+		 * The keys are extracted once for every item before sorting. Large categories are sorted on the thread pool.
+		 */
+		void set_sort_key(size_type col, sort_key);
+
+		/// Enables/disables sorting in background.
+		/**
+		 * If it is enabled, a large category which is sorted by a sort key is sorted in a background thread, the items
+		 * remain in the previous order until the sorting is finished. A column which has a sort compare is always sorted
+		 * in the calling thread, because the sort compare is not required to be thread-safe.
+		 */
+		void async_sort(bool enable);
+		bool async_sort() const;
+
 		/// Sort the items using the specified column.
 		///
 		/// Invalidates any existing reference from display position to absolute item,
@@ -1565,6 +1676,26 @@ the nana::detail::basic_window member pointer scheme
 		///< Prevent sorting until `freeze` is set to false.
 		bool freeze_sort(bool freeze);
 
+		/// Displays only the items whose text of the specified column contains the specified text.
+		/**
+		 * If the text contains the text of the previous query of the same column, only the items which are displayed are
+		 * tested again. A large listbox is filtered in a background thread, it keeps the previous result until the filtering
+		 * is finished, and a new query cancels the one in progress. An empty text removes the filter.
+		 * The hidden items are still accessed by the absolute positions, they have no display position.
+		 */
+		void filter(size_type col, std::string text, bool case_sensitive = false);
+
+		/// Displays only the items which satisfy the predicate.
+		/**
+		 * The predicate is invoked in a background thread for a large listbox, it should not access the listbox.
+		 * @param narrowing Indicates the predicate only accepts the items which are accepted by the previous filter, then only
+		 * the displayed items are tested.
+		 */
+		void filter(filter_predicate pred, bool narrowing = false);
+
+		void unfilter();		///< Removes the filter, all the items are displayed.
+		bool filtered() const;	///< Determines whether the listbox is filtered.
+
 		index_pairs selected() const;		///<Get the absolute indexes of all the selected items
 
 		void show_header(bool);
@@ -0,0 +1,72 @@
+/*
+ *	A memory mapped text file
+ *	Nana C++ Library(http://www.nanapro.org)
+ *	Copyright(C) 2003-2019 Jinhao(cnjinhao@hotmail.com)
+ *
+ *	Distributed under the Boost Software License, Version 1.0.
+ *	(See accompanying file LICENSE_1_0.txt or copy at
+ *	http://www.boost.org/LICENSE_1_0.txt)
+ *
+ *	@file: nana/gui/widgets/skeletons/mapped_text_file.hpp
+ *	@description: A read-only memory mapped file whose lines are indexed by a background
+ *	thread. It is used by textbase for loading a large file lazily.
+ */
+
+#ifndef NANA_GUI_WIDGET_DETAIL_MAPPED_TEXT_FILE_HPP
+#define NANA_GUI_WIDGET_DETAIL_MAPPED_TEXT_FILE_HPP
+
+#include <nana/traits.hpp>
+#include <nana/filesystem/filesystem.hpp>
+#include <vector>
+#include <cstddef>
+
+namespace nana
+{
+namespace widgets
+{
+namespace skeletons
+{
+	class mapped_text_file
+		: public ::nana::noncopyable
+	{
+		struct implementation;
+	public:
+		using path_type = std::filesystem::path;
+
+		mapped_text_file();
+		~mapped_text_file();
+
+		/// Maps the file and starts indexing the lines.
+		/**
+		 * The file is scanned chunk by chunk before it returns until a line break is found, so that
+		 * the first lines are available immediately. The rest is scanned by a background thread.
+		 * @param skip The number of bytes to skip at the beginning of the file, e.g. the BOM.
+		 */
+		bool open(const path_type& file, std::size_t skip);
+
+		/// Stops the indexing and unmaps the file.
+		void close();
+
+		const char* data() const;
+		std::size_t size() const;
+
+		/// Moves the offsets of the line beginnings which are found since last call into the vector.
+		/**
+		 * The offset of the first line is not reported.
+		 * @return true if the whole file is indexed and all the offsets are fetched.
+		 */
+		bool fetch(std::vector<std::size_t>& line_begins);
+
+		/// Blocks until the whole file is indexed.
+		void wait() const;
+
+		/// Returns the indexed proportion of the file, in range [0, 1].
+		double progress() const;
+	private:
+		implementation * impl_;
+	};
+}//end namespace skeletons
+}//end namespace widgets
+}//end namespace nana
+
+#endif
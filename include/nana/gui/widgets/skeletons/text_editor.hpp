@@ -44,13 +44,14 @@ namespace nana{	namespace widgets
 			class behavior_linewrapped;
 
 			enum class command{
-				backspace, input_text, move_text,
+				backspace, input_text, move_text, replace_text,
 			};
 			//Commands for undoable
 			template<typename EnumCommand> class basic_undoable;
 			class undo_backspace;
 			class undo_input_text;
 			class undo_move_text;
+			class undo_replace_text;
 
 			class keyword_parser;
 			class helper_pencil;
@@ -94,6 +95,21 @@ namespace nana{	namespace widgets
 			void set_keyword(const ::std::wstring& kw, const std::string& name, bool case_sensitive, bool whole_word_matched);
 			void erase_keyword(const ::std::wstring& kw);
 
+			/// Finds the text and selects the match. The search starts from the selection or the caret, and wraps around.
+			bool find(const ::std::wstring& text, bool case_sensitive, bool whole_word, bool forward);
+
+			/// Returns the positions of all the matches.
+			std::vector<upoint> find_all(const ::std::wstring& text, bool case_sensitive, bool whole_word) const;
+
+			/// Replaces all the matches, the replacements are undone in a single step.
+			/**
+			 * @return the number of replacements. It returns 0 if the replacement contains a line break.
+			 */
+			std::size_t replace_all(const ::std::wstring& text, const ::std::wstring& replacement, bool case_sensitive, bool whole_word);
+
+			/// Highlights the matches of text when the lines are drawn. It stops highlighting if the text is empty.
+			void highlight_matches(const ::std::wstring& text, bool case_sensitive, bool whole_word, const ::nana::color& fgcolor, const ::nana::color& bgcolor);
+
 			colored_area_access_interface& colored_area();
 
 			void set_accept(std::function<bool(char_type)>);
@@ -109,6 +125,12 @@ namespace nana{	namespace widgets
 
 			bool load(const path_type& file);
 
+			/// Loads a file lazily, the lines are appended while they are indexed by a background thread.
+			bool load_lazily(const path_type& file);
+
+			/// Returns the progress of lazy loading in range [0, 1].
+			double load_progress() const;
+
 			void text_align(::nana::align alignment);
 
 			/// Sets the text area.
@@ -140,6 +162,8 @@ namespace nana{	namespace widgets
 			void undo_clear();
 			void undo_max_steps(std::size_t);
 			std::size_t undo_max_steps() const;
+			void undo_max_bytes(std::size_t);
+			std::size_t undo_max_bytes() const;
 
 			renderers& customized_renderers();
 
@@ -189,6 +213,9 @@ namespace nana{	namespace widgets
 			void select_behavior(bool move_to_end);
 
 			std::size_t line_count(bool text_lines) const;
+
+			/// Returns the frame time and the effect of the render cache.
+			text_render_statistics render_statistics() const;
 		public:
 			void draw_corner();
 			void render(bool focused);
@@ -225,6 +252,7 @@ namespace nana{	namespace widgets
 		private:
 			nana::color _m_draw_colored_area(paint::graphics& graph, const std::pair<std::size_t,std::size_t>& row, bool whole_line);
 			std::vector<upoint> _m_render_text(const ::nana::color& text_color);
+			void _m_fetch_lines();
 			void _m_pre_calc_lines(std::size_t line_off, std::size_t lines);
 
 			//Caret to screen coordinate or context coordiate(in pixels)
@@ -33,6 +33,16 @@ namespace nana
 				parameters::mouse_wheel mouse_wheel;	///< The number of lines/characters to scroll when the vertical/horizontal mouse wheel is moved.
 			};
 
+			/// The statistics of rendering text
+			struct text_render_statistics
+			{
+				std::size_t frames;				///< The number of rendered frames
+				double last_frame_ms;			///< The time of rendering the last frame, in milliseconds
+				double average_frame_ms;		///< The average time of rendering a frame, in milliseconds
+				std::size_t cached_sections;	///< The number of text sections which are copied from the render cache
+				std::size_t drawn_sections;		///< The number of text sections which are drawn
+			};
+
 			class text_editor_event_interface
 			{
 			public:
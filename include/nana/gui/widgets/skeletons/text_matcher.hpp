@@ -0,0 +1,177 @@
+/*
+ *	A text matcher
+ *	Nana C++ Library(http://www.nanapro.org)
+ *	Copyright(C) 2003-2019 Jinhao(cnjinhao@hotmail.com)
+ *
+ *	Distributed under the Boost Software License, Version 1.0.
+ *	(See accompanying file LICENSE_1_0.txt or copy at
+ *	http://www.boost.org/LICENSE_1_0.txt)
+ *
+ *	@file: nana/gui/widgets/skeletons/text_matcher.hpp
+ *	@description: A Boyer-Moore-Horspool matcher which searches a pattern in the lines of textbase
+ *	without copying them. The shifts of characters are indexed by their low byte, the characters
+ *	which share a low byte share the smallest shift of them.
+ */
+
+#ifndef NANA_GUI_WIDGET_DETAIL_TEXT_MATCHER_HPP
+#define NANA_GUI_WIDGET_DETAIL_TEXT_MATCHER_HPP
+
+#include <string>
+#include <algorithm>
+#include <cwctype>
+#include <cstddef>
+
+namespace nana
+{
+namespace widgets
+{
+namespace skeletons
+{
+	template<typename CharT>
+	class basic_text_matcher
+	{
+	public:
+		using char_type = CharT;
+		using string_type = std::basic_string<CharT>;
+
+		static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+		basic_text_matcher(const string_type& pattern, bool case_sensitive, bool whole_word)
+			: pattern_(pattern), case_sensitive_(case_sensitive), whole_word_(whole_word)
+		{
+			if (!case_sensitive)
+			{
+				for (auto & chr : pattern_)
+					chr = _m_fold(chr);
+			}
+
+			const auto len = pattern_.size();
+			std::fill(std::begin(shifts_), std::end(shifts_), len);
+
+			//The last character is excluded, a later character overrides the shift with a smaller one.
+			for (std::size_t i = 0; i + 1 < len; ++i)
+				shifts_[_m_slot(pattern_[i])] = len - 1 - i;
+		}
+
+		std::size_t size() const noexcept
+		{
+			return pattern_.size();
+		}
+
+		bool empty() const noexcept
+		{
+			return pattern_.empty();
+		}
+
+		/// Returns the number of bytes the matcher occupies, including its table of shifts and the pattern.
+		std::size_t bytes() const noexcept
+		{
+			return sizeof(*this) + pattern_.capacity() * sizeof(char_type);
+		}
+
+		/// Finds the first match which begins at or after pos.
+		/**
+		 * @return the position of the match, or npos if it is not found.
+		 */
+		std::size_t find(const char_type* text, std::size_t len, std::size_t pos = 0) const
+		{
+			if (pattern_.empty())
+				return npos;
+
+			while (true)
+			{
+				pos = (case_sensitive_ ? _m_search<false>(text, len, pos) : _m_search<true>(text, len, pos));
+				if (npos == pos || !whole_word_ || _m_whole_word(text, len, pos))
+					return pos;
+
+				++pos;
+			}
+		}
+
+		std::size_t find(const string_type& text, std::size_t pos = 0) const
+		{
+			return find(text.data(), text.size(), pos);
+		}
+
+		/// Calls fn(pos) with every match, the matches are not overlapped.
+		template<typename Function>
+		void for_each(const char_type* text, std::size_t len, Function fn) const
+		{
+			for (auto pos = find(text, len); pos != npos; pos = find(text, len, pos + pattern_.size()))
+				fn(pos);
+		}
+	private:
+		static char_type _m_fold(char_type chr)
+		{
+			if (chr < 0x80)
+				return (('a' <= chr && chr <= 'z') ? static_cast<char_type>(chr - 'a' + 'A') : chr);
+
+			return static_cast<char_type>(std::towupper(static_cast<std::wint_t>(chr)));
+		}
+
+		static std::size_t _m_slot(char_type chr)
+		{
+			return static_cast<std::size_t>(chr) & 0xFF;
+		}
+
+		template<bool Fold>
+		static char_type _m_char(char_type chr)
+		{
+			return (Fold ? _m_fold(chr) : chr);
+		}
+
+		template<bool Fold>
+		std::size_t _m_search(const char_type* text, std::size_t len, std::size_t pos) const
+		{
+			const auto plen = pattern_.size();
+			if (len < plen)
+				return npos;
+
+			const auto last = plen - 1;
+			const auto pat = pattern_.data();
+			const auto tail = pat[last];
+
+			for (const auto end = len - plen; pos <= end; )
+			{
+				auto const chr = _m_char<Fold>(text[pos + last]);
+				if (chr == tail)
+				{
+					std::size_t i = 0;
+					while (i < last && _m_char<Fold>(text[pos + i]) == pat[i])
+						++i;
+
+					if (i == last)
+						return pos;
+				}
+
+				pos += shifts_[_m_slot(chr)];
+			}
+			return npos;
+		}
+
+		static bool _m_is_word_char(char_type chr)
+		{
+			return (std::iswalnum(static_cast<std::wint_t>(chr)) || chr == '_');
+		}
+
+		bool _m_whole_word(const char_type* text, std::size_t len, std::size_t pos) const
+		{
+			if (pos && _m_is_word_char(text[pos - 1]))
+				return false;
+
+			const auto end = pos + pattern_.size();
+			return !((end < len) && _m_is_word_char(text[end]));
+		}
+	private:
+		string_type pattern_;	//It is folded to uppercase if it is case-insensitive
+		bool case_sensitive_;
+		bool whole_word_;
+		std::size_t shifts_[256];
+	};
+
+	using text_matcher = basic_text_matcher<wchar_t>;
+}//end namespace skeletons
+}//end namespace widgets
+}//end namespace nana
+
+#endif
@@ -21,9 +21,12 @@
 #include <nana/filesystem/filesystem.hpp>
 
 #include "textbase_export_interface.hpp"
+#include "textbase_lines.hpp"
+#include "mapped_text_file.hpp"
+#include "text_matcher.hpp"
 
-#include <deque>
 #include <fstream>
+#include <memory>
 #include <stdexcept>
 
 namespace nana
@@ -44,7 +47,6 @@ namespace skeletons
 
 		textbase()
 		{
-			attr_max_.reset();
 			//Insert an empty string for the first line of empty text.
 			text_cont_.emplace_back();
 		}
@@ -126,18 +128,15 @@ namespace skeletons
 			ifs.seekg(0, std::ios::beg);
 
 			text_cont_.clear();		//Clear only if the file can be opened.
-			attr_max_.reset();
+			++revision_;
+			lazy_.reset();
+			crlf_ = true;
 
 			std::string str_mbs;
 			while(ifs.good())
 			{
 				std::getline(ifs, str_mbs);
-				text_cont_.emplace_back(static_cast<string_type&&>(nana::charset{ str_mbs }));
-				if (text_cont_.back().size() > attr_max_.size)
-				{
-					attr_max_.size = text_cont_.back().size();
-					attr_max_.line = text_cont_.size() - 1;
-				}
+				_m_push_loaded(static_cast<string_type&&>(nana::charset{ str_mbs }), !ifs.eof());
 			}
 
 			_m_saved(file);
@@ -185,7 +184,9 @@ namespace skeletons
 			if(ifs.good())
 			{
 				text_cont_.clear();		//Clear only if the file can be opened.
-				attr_max_.reset();
+				++revision_;
+				lazy_.reset();
+				crlf_ = true;
 
 				std::getline(ifs, str);
 
@@ -212,9 +213,7 @@ namespace skeletons
 						byte_order_translate_4bytes(str);
 				}
 
-				text_cont_.emplace_back(static_cast<string_type&&>(nana::charset{ str, encoding }));
-				attr_max_.size = text_cont_.back().size();
-				attr_max_.line = 0;
+				_m_push_loaded(static_cast<string_type&&>(nana::charset{ str, encoding }), !ifs.eof());
 			}
 
 			while(ifs.good())
@@ -229,26 +228,109 @@ namespace skeletons
 						byte_order_translate_4bytes(str);
 				}
 
-				text_cont_.emplace_back(static_cast<string_type&&>(nana::charset{ str, encoding }));
-				if (text_cont_.back().size() > attr_max_.size)
-				{
-					attr_max_.size = text_cont_.back().size();
-					attr_max_.line = text_cont_.size() - 1;
-				}
+				_m_push_loaded(static_cast<string_type&&>(nana::charset{ str, encoding }), !ifs.eof());
 			}
 
 			_m_saved(file);
 			return true;
 		}
 
-		void store(const path_type& filename, bool is_unicode, ::nana::unicode encoding) const
+		/// Loads a text file lazily
+		/**
+		 * The file is memory mapped and its lines are indexed by a background thread. The indexed lines are
+		 * appended by fetch_lines(), and they are decoded when they are accessed. A file encoded in UTF-16 or
+		 * UTF-32 is loaded by load().
+		 */
+		bool load_lazily(const path_type& file)
+		{
+			std::ifstream ifs{ file.string(), std::ios::binary };
+			if (!ifs)
+				return false;
+
+			char bom[4] = {};
+			ifs.read(bom, 4);
+			auto const bytes = static_cast<std::size_t>(ifs.gcount());
+			ifs.close();
+
+			if ((bytes >= 2) && (('\xFF' == bom[0] && '\xFE' == bom[1]) || ('\xFE' == bom[0] && '\xFF' == bom[1])))
+				return load(file);	//UTF-16 or UTF-32
+
+			if ((bytes >= 4) && (0 == bom[0] && 0 == bom[1] && '\xFE' == bom[2] && '\xFF' == bom[3]))
+				return load(file);	//UTF-32(big-endian)
+
+			bool const utf8 = ((bytes >= 3) && ('\xEF' == bom[0] && '\xBB' == bom[1] && '\xBF' == bom[2]));
+
+			std::unique_ptr<lazy_loading> lazy{ new lazy_loading };
+			if (!lazy->file.open(file, (utf8 ? 3 : 0)))
+				return false;
+
+			lazy->utf8 = utf8;
+			lazy->line_begin = (utf8 ? 3 : 0);
+
+			text_cont_.clear();		//Clear only if the file can be opened.
+			++revision_;
+			lazy_.swap(lazy);
+			crlf_ = true;
+
+			text_cont_.decoder([this](size_type, std::size_t begin, std::size_t end){
+				return _m_decode(begin, end);
+			});
+
+			//The first line is always available when the file is opened.
+			_m_fetch_lines();
+			lazy_->unreported = 0;
+
+			_m_saved(file);
+			return true;
+		}
+
+		/// Appends the lines which are indexed since last call while a file is being loaded lazily.
+		/// @return The number of lines which are appended to the end since last call.
+		size_type fetch_lines()
+		{
+			if (!lazy_)
+				return 0;
+
+			_m_fetch_lines();
+
+			auto const lines = lazy_->unreported;
+			lazy_->unreported = 0;
+			return lines;
+		}
+
+		/// Returns true if a file is being loaded lazily and not all its lines are appended.
+		bool loading() const
 		{
+			return (lazy_ && !lazy_->indexed);
+		}
+
+		/// Returns the progress of loading in range [0, 1]. It returns 1 if a file is not being loaded.
+		double load_progress() const
+		{
+			return (loading() ? lazy_->file.progress() : 1.0);
+		}
+
+		/// Returns true if the line is decoded. Only the lines of a lazily loaded file may be undecoded.
+		bool decoded(size_type pos) const
+		{
+			return text_cont_.decoded(pos);
+		}
+
+		/// Stores the text to a file. If a file is being loaded lazily, it waits until the whole file is loaded.
+		void store(const path_type& filename, bool is_unicode, ::nana::unicode encoding)
+		{
+			//The mapped file would be truncated if it is overwritten, so all lines are decoded before writing.
+			_m_finish_loading();
+
 			std::ofstream ofs(filename.string(), std::ios::binary);
 			if(ofs && text_cont_.size())
 			{
-				auto i = text_cont_.cbegin();
 				auto const count = text_cont_.size() - 1;
 
+				//The lines are ended as the loaded file is.
+				const char* const eol = (crlf_ ? "\r\n" : "\n");
+				const std::streamsize eol_bytes = (crlf_ ? 2 : 1);
+
 				std::string last_mbs;
 
 				if (is_unicode)
@@ -270,9 +352,9 @@ namespace skeletons
 
 					for (std::size_t pos = 0; pos < count; ++pos)
 					{
-						auto mbs = nana::charset(*(i++)).to_bytes(encoding);
+						auto mbs = nana::charset(text_cont_[pos]).to_bytes(encoding);
 						ofs.write(mbs.c_str(), static_cast<std::streamsize>(mbs.size()));
-						ofs.write("\r\n", 2);
+						ofs.write(eol, eol_bytes);
 					}
 
 					last_mbs = nana::charset(text_cont_.back()).to_bytes(encoding);
@@ -281,9 +363,9 @@ namespace skeletons
 				{
 					for (std::size_t pos = 0; pos < count; ++pos)
 					{
-						std::string mbs = nana::charset(*(i++));
+						std::string mbs = nana::charset(text_cont_[pos]);
 						ofs.write(mbs.c_str(), mbs.size());
-						ofs.write("\r\n", 2);
+						ofs.write(eol, eol_bytes);
 					}
 					last_mbs = nana::charset(text_cont_.back());
 				}
@@ -328,23 +410,109 @@ namespace skeletons
 			return nullstr_;
 		}
 
+		/// Returns the position and the number of characters of the longest line, it takes O(log n).
+		/**
+		 * The lines which are not decoded by a lazy loading are not taken into account.
+		 */
 		std::pair<size_t, size_t> max_line() const
 		{
-			return std::make_pair(attr_max_.line, attr_max_.size);
+			return text_cont_.longest();
+		}
+
+		/// Finds the text in the lines, it doesn't wrap around.
+		/**
+		 * @param pos Specifies where the search starts, and it returns the position of the match.
+		 * @param forward Finds the first match which begins at or after pos if it is true, otherwise finds the last match which begins before pos.
+		 * @return true if a match is found.
+		 */
+		bool find(const basic_text_matcher<CharT>& matcher, upoint& pos, bool forward) const
+		{
+			if (matcher.empty() || (pos.y >= text_cont_.size()))
+				return false;
+
+			if (forward)
+			{
+				std::size_t offset = pos.x;
+				for (auto line = pos.y; line < text_cont_.size(); ++line, offset = 0)
+				{
+					auto & str = text_cont_[line];
+					if (offset > str.size())
+						continue;
+
+					auto found = matcher.find(str.data(), str.size(), offset);
+					if (found != matcher.npos)
+					{
+						pos.x = static_cast<unsigned>(found);
+						pos.y = static_cast<unsigned>(line);
+						return true;
+					}
+				}
+				return false;
+			}
+
+			std::size_t limit = pos.x;
+			for (auto line = static_cast<std::size_t>(pos.y) + 1; line; --line, limit = matcher.npos)
+			{
+				auto & str = text_cont_[line - 1];
+
+				//The matches may overlap, the next match is searched from the character after a hit, so that
+				//the hit nearest to the limit is not skipped.
+				auto last = matcher.npos;
+				for (auto found = matcher.find(str.data(), str.size()); (found != matcher.npos) && (found < limit); found = matcher.find(str.data(), str.size(), found + 1))
+					last = found;
+
+				if (last != matcher.npos)
+				{
+					pos.x = static_cast<unsigned>(last);
+					pos.y = static_cast<unsigned>(line - 1);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/// Calls fn(pos) with the position of every match in order.
+		template<typename Function>
+		void find_all(const basic_text_matcher<CharT>& matcher, Function fn) const
+		{
+			if (matcher.empty())
+				return;
+
+			for (size_type line = 0; line < text_cont_.size(); ++line)
+			{
+				auto & str = text_cont_[line];
+				matcher.for_each(str.data(), str.size(), [&fn, line](std::size_t found)
+				{
+					fn(upoint{ static_cast<unsigned>(found), static_cast<unsigned>(line) });
+				});
+			}
+		}
+
+		/// Returns the revision of text, it is changed whenever the text is edited or loaded.
+		std::size_t revision() const
+		{
+			return revision_;
+		}
+
+		/// Returns the revision of a line, it is unique among the lines and it is changed whenever the line is edited.
+		/// It returns 0 if the line doesn't exist.
+		std::size_t revision(size_type pos) const
+		{
+			return (pos < text_cont_.size() ? text_cont_.revision(pos) : 0);
 		}
 	public:
 		void replace(size_type pos, string_type && text)
 		{
 			if (text_cont_.size() <= pos)
-			{
 				text_cont_.emplace_back(std::move(text));
-				pos = text_cont_.size() - 1;
-			}
 			else
+			{
 				_m_at(pos).swap(text);
+				text_cont_.updated(pos);
+			}
 
-			_m_make_max(pos);
 			edited_ = true;
+			++revision_;
 		}
 
 		void insert(upoint pos, string_type && str)
@@ -357,6 +525,8 @@ namespace skeletons
 					lnstr.insert(pos.x, str);
 				else
 					lnstr += str;
+
+				text_cont_.updated(pos.y);
 			}
 			else
 			{
@@ -364,19 +534,16 @@ namespace skeletons
 				pos.y = static_cast<unsigned>(text_cont_.size() - 1);
 			}
 
-			_m_make_max(pos.y);
 			edited_ = true;
+			++revision_;
 		}
 
 		void insertln(size_type pos, string_type&& str)
 		{
-			if (pos < text_cont_.size())
-				text_cont_.emplace(_m_iat(pos), std::move(str));
-			else
-				text_cont_.emplace_back(std::move(str));
+			text_cont_.insert(pos, std::move(str));
 
-			_m_make_max(pos);
 			edited_ = true;
+			++revision_;
 		}
 
 		void erase(size_type line, size_type pos, size_type count)
@@ -389,10 +556,10 @@ namespace skeletons
 				else
 					lnstr.erase(pos, count);
 
-				if (attr_max_.line == line)
-					_m_scan_for_max();
+				text_cont_.updated(line);
 
 				edited_ = true;
+				++revision_;
 			}
 		}
 
@@ -405,21 +572,18 @@ namespace skeletons
 			if (pos + n > text_cont_.size())
 				n = text_cont_.size() - pos;
 
-			text_cont_.erase(_m_iat(pos), _m_iat(pos + n));
-
-			if (pos <= attr_max_.line && attr_max_.line < pos + n)
-				_m_scan_for_max();
-			else if (pos < attr_max_.line)
-				attr_max_.line -= n;
+			text_cont_.erase(pos, n);
 
 			edited_ = true;
+			++revision_;
 			return true;
 		}
 
 		void erase_all()
 		{
 			text_cont_.clear();
-			attr_max_.reset();
+			++revision_;
+			lazy_.reset();
 			text_cont_.emplace_back(); //text_cont_ must not be empty
 
 			_m_saved({});
@@ -429,19 +593,13 @@ namespace skeletons
 		{
 			if(pos + 1 < text_cont_.size())
 			{
-				auto i = _m_iat(pos + 1);
-				_m_at(pos) += *i;
+				_m_at(pos) += text_cont_[pos + 1];
 
-				text_cont_.erase(i);
-				_m_make_max(pos);
-
-				//If the maxline is behind the pos line,
-				//decrease the maxline. Because a line between maxline and pos line
-				//has been deleted.
-				if(pos < attr_max_.line)
-					--attr_max_.line;
+				text_cont_.erase(pos + 1, 1);
+				text_cont_.updated(pos);
 
 				edited_ = true;
+				++revision_;
 			}
 		}
 
@@ -470,29 +628,88 @@ namespace skeletons
 	private:
 		string_type& _m_at(size_type pos)
 		{
-			return *_m_iat(pos);
+			return text_cont_[pos];
 		}
 
-		typename std::deque<string_type>::iterator _m_iat(size_type pos)
+		void _m_fetch_lines()
 		{
-			return text_cont_.begin() + pos;
+			if (!lazy_ || lazy_->indexed)
+				return;
+
+			auto & lz = *lazy_;
+			bool const finished = lz.file.fetch(lz.line_begins);
+
+			auto const before = text_cont_.size();
+			for (auto begin : lz.line_begins)
+			{
+				//The line ending of the file is determined by its first line, the line breaks are excluded by _m_decode().
+				if (text_cont_.empty())
+					crlf_ = (begin - lz.line_begin >= 2) && ('\r' == lz.file.data()[begin - 2]);
+
+				text_cont_.emplace_back(lz.line_begin, begin);
+				lz.line_begin = begin;
+			}
+			lz.line_begins.clear();
+
+			if (finished)
+			{
+				//The last line ends at the end of file
+				text_cont_.emplace_back(lz.line_begin, lz.file.size());
+				lz.indexed = true;
+			}
+
+			lz.unreported += text_cont_.size() - before;
 		}
 
-		void _m_make_max(std::size_t pos)
+		/// Appends a loaded line without its carriage return, the line breaks of a file are either LF or CRLF.
+		/// @param terminated Indicates whether the line is terminated by a line break, the line ending of the file is determined by its first line.
+		void _m_push_loaded(string_type&& str, bool terminated)
 		{
-			const string_type& str = _m_at(pos);
-			if(str.size() > attr_max_.size)
+			bool const cr = (!str.empty() && ('\r' == str.back()));
+			if (cr)
+				str.pop_back();
+
+			if (terminated && text_cont_.empty())
+				crlf_ = cr;
+
+			text_cont_.emplace_back(std::move(str));
+		}
+
+		void _m_finish_loading()
+		{
+			if (!lazy_)
+				return;
+
+			if (!lazy_->indexed)
 			{
-				attr_max_.size = str.size();
-				attr_max_.line = pos;
+				lazy_->file.wait();
+				_m_fetch_lines();
 			}
+
+			text_cont_.decode_all();
+			lazy_->file.close();
 		}
 
-		void _m_scan_for_max()
+		string_type _m_decode(std::size_t begin, std::size_t end)
 		{
-			attr_max_.reset();
-			for (std::size_t i = 0; i < text_cont_.size(); ++i)
-				_m_make_max(i);
+			auto const data = lazy_->file.data();
+
+			//Excludes the line break
+			if ((end > begin) && ('\n' == data[end - 1]))
+				--end;
+
+			if ((end > begin) && ('\r' == data[end - 1]))
+				--end;
+
+			std::string mbs{ data + begin, data + end };
+
+			string_type str;
+			if (lazy_->utf8)
+				str = static_cast<string_type&&>(nana::charset{ mbs, nana::unicode::utf8 });
+			else
+				str = static_cast<string_type&&>(nana::charset{ mbs });
+
+			return str;
 		}
 
 		void _m_emit_first_change() const
@@ -512,25 +729,26 @@ namespace skeletons
 			changed_ = false;
 		}
 	private:
-		std::deque<string_type> text_cont_;
+		textbase_lines<string_type> text_cont_;
+
+		struct lazy_loading
+		{
+			mapped_text_file file;
+			bool utf8{ false };
+			bool indexed{ false };			///< Indicates whether all lines are appended to text_cont_
+			std::size_t line_begin{ 0 };	///< The offset of the line which is going to be appended
+			size_type unreported{ 0 };		///< The number of appended lines which are not reported by fetch_lines()
+			std::vector<std::size_t> line_begins;
+		};
+		std::unique_ptr<lazy_loading> lazy_;	///< The state of lazy loading, it is empty if the text is not loaded lazily
 		textbase_event_agent_interface* evt_agent_{ nullptr };
 
 		mutable bool		changed_{ false };
 		mutable bool		edited_{ false };
+		bool				crlf_{ true };	///< Indicates whether the lines are ended with CRLF, it is determined by the loaded file
+		std::size_t			revision_{ 0 };
 		mutable path_type filename_;	///< The saved filename
 		const string_type nullstr_;
-
-		struct attr_max
-		{
-			std::size_t line; ///< The line number of max line
-			std::size_t size; ///< The number of characters in max line
-
-			void reset()
-			{
-				line = 0;
-				size = 0;
-			}
-		}attr_max_;
 	};
 
 }//end namespace detail
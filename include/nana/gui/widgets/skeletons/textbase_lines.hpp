@@ -0,0 +1,487 @@
+/*
+ *	A line container of textbase
+ *	Nana C++ Library(http://www.nanapro.org)
+ *	Copyright(C) 2003-2019 Jinhao(cnjinhao@hotmail.com)
+ *
+ *	Distributed under the Boost Software License, Version 1.0.
+ *	(See accompanying file LICENSE_1_0.txt or copy at
+ *	http://www.boost.org/LICENSE_1_0.txt)
+ *
+ *	@file: nana/gui/widgets/skeletons/textbase_lines.hpp
+ *	@description: The lines of text are stored in blocks, and the blocks are indexed by a
+ *	Fenwick tree of their line counts. Locating a line takes O(log n), inserting or erasing
+ *	a line only moves the lines of a block instead of the lines behind it.
+ *	A block may be undecoded, it only keeps the offsets of its lines in a source, and it is
+ *	decoded by the decoder when one of its lines is accessed.
+ *	Every block keeps its longest line, and the blocks are indexed by a max segment tree of
+ *	their longest lines, so that the longest line is updated in O(log n) without rescanning
+ *	the whole text.
+ *	Every decoded line has a revision which is unique in the container, it is renewed whenever
+ *	the line is inserted, modified or decoded, so that a line can be identified by its revision.
+ */
+
+#ifndef NANA_GUI_WIDGET_DETAIL_TEXTBASE_LINES_HPP
+#define NANA_GUI_WIDGET_DETAIL_TEXTBASE_LINES_HPP
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <cstddef>
+
+namespace nana
+{
+namespace widgets
+{
+namespace skeletons
+{
+	template<typename StringType>
+	class textbase_lines
+	{
+		/// The maximum number of lines in a block, a block is split into halves when it exceeds.
+		static constexpr std::size_t block_lines = 1024;
+
+		struct block
+		{
+			std::vector<StringType> lines;
+			std::vector<std::size_t> revisions;	///< The revisions of the decoded lines
+			std::vector<std::size_t> source;	///< The offsets of undecoded lines, line i is [source[i], source[i + 1]). It is empty if the block is decoded.
+			std::size_t longest{ 0 };			///< The length of the longest decoded line
+			std::size_t longest_pos{ 0 };		///< The position of the longest decoded line in the block
+
+			std::size_t size() const
+			{
+				return (source.empty() ? lines.size() : source.size() - 1);
+			}
+
+			void measure()
+			{
+				longest = longest_pos = 0;
+				for (std::size_t i = 0; i < lines.size(); ++i)
+				{
+					if (lines[i].size() > longest)
+					{
+						longest = lines[i].size();
+						longest_pos = i;
+					}
+				}
+			}
+		};
+	public:
+		using value_type = StringType;
+		using size_type = std::size_t;
+
+		/// Decodes the line in [begin, end) of the source.
+		using decoder_type = std::function<value_type(size_type line, std::size_t begin, std::size_t end)>;
+
+		size_type size() const
+		{
+			return size_;
+		}
+
+		bool empty() const
+		{
+			return (0 == size_);
+		}
+
+		/// Removes all lines. The revisions are not reused, a new line never has the revision of a removed one.
+		void clear()
+		{
+			blocks_.clear();
+			tree_.clear();
+			longest_tree_.clear();
+			size_ = 0;
+			tree_dirty_ = false;
+		}
+
+		void decoder(decoder_type fn)
+		{
+			decoder_ = std::move(fn);
+		}
+
+		value_type& operator[](size_type pos)
+		{
+			auto loc = _m_locate(pos);
+			return _m_decode(loc.first).lines[loc.second];
+		}
+
+		const value_type& operator[](size_type pos) const
+		{
+			auto loc = _m_locate(pos);
+			return _m_decode(loc.first).lines[loc.second];
+		}
+
+		value_type& front()
+		{
+			return _m_decode(0).lines.front();
+		}
+
+		const value_type& front() const
+		{
+			return _m_decode(0).lines.front();
+		}
+
+		value_type& back()
+		{
+			return _m_decode(blocks_.size() - 1).lines.back();
+		}
+
+		const value_type& back() const
+		{
+			return _m_decode(blocks_.size() - 1).lines.back();
+		}
+
+		/// Returns the position and the length of the longest decoded line.
+		std::pair<size_type, size_type> longest() const
+		{
+			if (blocks_.empty())
+				return{};
+
+			if (tree_dirty_)
+				_m_build_tree();
+
+			//Descends to the leftmost block whose longest line is the longest
+			auto const leaves = longest_tree_.size() / 2;
+			size_type node = 1;
+			while (node < leaves)
+			{
+				node *= 2;
+				if (longest_tree_[node] < longest_tree_[node + 1])
+					++node;
+			}
+
+			auto const blk_pos = node - leaves;
+			auto & blk = blocks_[blk_pos];
+			return{ _m_first_line(blk_pos) + blk.longest_pos, blk.longest };
+		}
+
+		/// Returns the revision of the line specified by pos, the line is decoded if it is undecoded.
+		std::size_t revision(size_type pos) const
+		{
+			auto loc = _m_locate(pos);
+			return _m_decode(loc.first).revisions[loc.second];
+		}
+
+		/// Renews the revision and updates the longest line after the line specified by pos is modified through operator[].
+		void updated(size_type pos)
+		{
+			auto loc = _m_locate(pos);
+			auto & blk = blocks_[loc.first];
+			if (!blk.source.empty())
+				return;
+
+			blk.revisions[loc.second] = ++revision_;
+
+			auto const len = blk.lines[loc.second].size();
+			if (len > blk.longest || (len == blk.longest && loc.second < blk.longest_pos))
+			{
+				blk.longest = len;
+				blk.longest_pos = loc.second;
+			}
+			else if (loc.second == blk.longest_pos)
+				blk.measure();	//The longest line is shortened
+			else
+				return;
+
+			_m_update_longest(loc.first);
+		}
+
+		/// Returns true if the line is decoded.
+		bool decoded(size_type pos) const
+		{
+			return (pos < size_) && blocks_[_m_locate(pos).first].source.empty();
+		}
+
+		void emplace_back(value_type&& str)
+		{
+			if (blocks_.empty() || (blocks_.back().size() >= block_lines) || !blocks_.back().source.empty())
+				_m_append_block();
+			else
+				_m_adjust(blocks_.size() - 1, 1);
+
+			auto & blk = blocks_.back();
+			blk.lines.emplace_back(std::move(str));
+			blk.revisions.push_back(++revision_);
+			++size_;
+
+			if (blk.lines.back().size() > blk.longest)
+			{
+				blk.longest = blk.lines.back().size();
+				blk.longest_pos = blk.lines.size() - 1;
+				_m_update_longest(blocks_.size() - 1);
+			}
+		}
+
+		void emplace_back()
+		{
+			emplace_back(value_type{});
+		}
+
+		/// Appends an undecoded line in [begin, end) of the source.
+		void emplace_back(std::size_t begin, std::size_t end)
+		{
+			if (blocks_.empty() || (blocks_.back().size() >= block_lines) || blocks_.back().source.empty() || (blocks_.back().source.back() != begin))
+			{
+				_m_append_block();
+				blocks_.back().source.push_back(begin);
+			}
+			else
+				_m_adjust(blocks_.size() - 1, 1);
+
+			blocks_.back().source.push_back(end);
+			++size_;
+		}
+
+		/// Decodes all lines.
+		void decode_all() const
+		{
+			for (size_type i = 0; i < blocks_.size(); ++i)
+				_m_decode(i);
+		}
+
+		/// Inserts a line before the line specified by pos. It appends the line if pos is not less than size().
+		void insert(size_type pos, value_type&& str)
+		{
+			if (pos >= size_)
+				return emplace_back(std::move(str));
+
+			auto loc = _m_locate(pos);
+			auto & dst = _m_decode(loc.first);
+			auto & blk = dst.lines;
+			blk.emplace(blk.begin() + loc.second, std::move(str));
+			dst.revisions.insert(dst.revisions.begin() + loc.second, ++revision_);
+			++size_;
+
+			if (blk.size() > block_lines)
+			{
+				//Split the block into halves. The strings are moved, but the blocks which
+				//contain them are not reallocated.
+				auto const half = blk.size() / 2;
+				block tail;
+				tail.lines.reserve(block_lines);
+				for (auto i = blk.begin() + half; i != blk.end(); ++i)
+					tail.lines.emplace_back(std::move(*i));
+				blk.erase(blk.begin() + half, blk.end());
+
+				tail.revisions.assign(dst.revisions.begin() + half, dst.revisions.end());
+				dst.revisions.erase(dst.revisions.begin() + half, dst.revisions.end());
+
+				dst.measure();
+				tail.measure();
+
+				blocks_.emplace(blocks_.begin() + loc.first + 1, std::move(tail));
+				tree_dirty_ = true;
+				return;
+			}
+
+			_m_adjust(loc.first, 1);
+
+			auto const len = blk[loc.second].size();
+			if (loc.second <= dst.longest_pos && dst.longest)
+				++dst.longest_pos;
+
+			if (len > dst.longest || (len == dst.longest && loc.second < dst.longest_pos))
+			{
+				dst.longest = len;
+				dst.longest_pos = loc.second;
+				_m_update_longest(loc.first);
+			}
+		}
+
+		/// Erases n lines starting from pos.
+		void erase(size_type pos, size_type n)
+		{
+			if (pos >= size_)
+				return;
+
+			if (n > size_ - pos)
+				n = size_ - pos;
+
+			auto loc = _m_locate(pos);
+			auto blk_pos = loc.first;
+			auto offset = loc.second;
+			size_ -= n;
+
+			while (n)
+			{
+				auto const count = (std::min)(n, blocks_[blk_pos].size() - offset);
+				n -= count;
+
+				if (count == blocks_[blk_pos].size())
+				{
+					//The whole block is erased, it is unnecessary to decode it.
+					blocks_.erase(blocks_.begin() + blk_pos);
+					tree_dirty_ = true;
+				}
+				else
+				{
+					auto & dst = _m_decode(blk_pos);
+					auto & blk = dst.lines;
+					blk.erase(blk.begin() + offset, blk.begin() + (offset + count));
+					dst.revisions.erase(dst.revisions.begin() + offset, dst.revisions.begin() + (offset + count));
+					_m_adjust(blk_pos, -static_cast<std::ptrdiff_t>(count));
+
+					if (offset <= dst.longest_pos && dst.longest_pos < offset + count)
+					{
+						dst.measure();	//The longest line is erased
+						_m_update_longest(blk_pos);
+					}
+					else if (offset < dst.longest_pos)
+						dst.longest_pos -= count;
+
+					++blk_pos;
+				}
+
+				offset = 0;
+			}
+		}
+
+		/// Calls the function with every decoded line and its position in order. The undecoded lines are skipped.
+		template<typename Function>
+		void for_each_decoded(Function fn) const
+		{
+			size_type pos = 0;
+			for (auto & blk : blocks_)
+			{
+				if (blk.source.empty())
+				{
+					for (auto & str : blk.lines)
+						fn(pos++, str);
+				}
+				else
+					pos += blk.size();
+			}
+		}
+	private:
+		void _m_append_block()
+		{
+			blocks_.emplace_back();
+			tree_dirty_ = true;
+		}
+
+		block& _m_decode(size_type blk_pos) const
+		{
+			auto & blk = blocks_[blk_pos];
+			if (blk.source.empty())
+				return blk;
+
+			auto const line = _m_first_line(blk_pos);
+
+			auto const count = blk.size();
+			blk.lines.reserve(count);
+			blk.revisions.reserve(count);
+			for (size_type i = 0; i < count; ++i)
+			{
+				blk.lines.emplace_back(decoder_(line + i, blk.source[i], blk.source[i + 1]));
+				blk.revisions.push_back(++revision_);
+			}
+
+			blk.source.clear();
+			blk.source.shrink_to_fit();
+
+			blk.measure();
+			_m_update_longest(blk_pos);
+			return blk;
+		}
+
+		/// Returns the position of the first line of the block.
+		size_type _m_first_line(size_type blk_pos) const
+		{
+			if (tree_dirty_)
+				_m_build_tree();
+
+			size_type line = 0;
+			for (auto i = blk_pos; i; i -= (i & (~i + 1)))
+				line += tree_[i - 1];
+			return line;
+		}
+
+		/// Returns the block and the offset in the block of the line specified by pos
+		std::pair<size_type, size_type> _m_locate(size_type pos) const
+		{
+			if (tree_dirty_)
+				_m_build_tree();
+
+			auto const count = tree_.size();
+
+			size_type mask = 1;
+			while ((mask << 1) <= count)
+				mask <<= 1;
+
+			//Search the Fenwick tree for the last block whose preceding lines are not more than pos.
+			size_type blk = 0;
+			for (; mask; mask >>= 1)
+			{
+				auto const next = blk + mask;
+				if (next <= count && tree_[next - 1] <= pos)
+				{
+					blk = next;
+					pos -= tree_[next - 1];
+				}
+			}
+
+			return{ blk, pos };
+		}
+
+		void _m_adjust(size_type blk, std::ptrdiff_t delta)
+		{
+			if (tree_dirty_)
+				return;
+
+			for (auto i = blk + 1; i <= tree_.size(); i += (i & (~i + 1)))
+				tree_[i - 1] += static_cast<size_type>(delta);
+		}
+
+		void _m_update_longest(size_type blk) const
+		{
+			if (tree_dirty_)
+				return;
+
+			auto node = longest_tree_.size() / 2 + blk;
+			longest_tree_[node] = blocks_[blk].longest;
+			for (node /= 2; node; node /= 2)
+				longest_tree_[node] = (std::max)(longest_tree_[node * 2], longest_tree_[node * 2 + 1]);
+		}
+
+		void _m_build_tree() const
+		{
+			auto const count = blocks_.size();
+			tree_.resize(count);
+			for (size_type i = 0; i < count; ++i)
+				tree_[i] = blocks_[i].size();
+
+			for (size_type i = 1; i <= count; ++i)
+			{
+				auto parent = i + (i & (~i + 1));
+				if (parent <= count)
+					tree_[parent - 1] += tree_[i - 1];
+			}
+
+			//The leaves of the segment tree are the blocks, they are padded to a power of 2.
+			size_type leaves = 1;
+			while (leaves < count)
+				leaves <<= 1;
+
+			longest_tree_.assign(leaves * 2, 0);
+			for (size_type i = 0; i < count; ++i)
+				longest_tree_[leaves + i] = blocks_[i].longest;
+
+			for (auto node = leaves - 1; node; --node)
+				longest_tree_[node] = (std::max)(longest_tree_[node * 2], longest_tree_[node * 2 + 1]);
+
+			tree_dirty_ = false;
+		}
+	private:
+		mutable std::vector<block> blocks_;	//The undecoded blocks are decoded when they are accessed
+		mutable std::vector<size_type> tree_;	///< The Fenwick tree of the line counts of blocks
+		mutable std::vector<size_type> longest_tree_;	///< The max segment tree of the longest lines of blocks, node 1 is the root
+		mutable bool tree_dirty_{ false };
+		mutable std::size_t revision_{ 0 };	///< The last revision which is given to a line
+		size_type size_{ 0 };
+		decoder_type decoder_;
+	};
+}//end namespace skeletons
+}//end namespace widgets
+}//end namespace nana
+
+#endif
@@ -140,6 +140,15 @@ namespace nana
 
         ///  \brief Loads a text file. When attempt to load a unicode encoded text file, be sure the file have a BOM header.
 		void load(const path_type& file);
+
+		/// \brief Loads a text file lazily. The textbox is interactive while the file is being loaded.
+		/// The file is memory mapped and its lines are indexed by a background thread, only the displayed or accessed lines are decoded.
+		/// A file encoded in UTF-16 or UTF-32 is loaded by load().
+		void load_lazily(const path_type& file);
+
+		/// Returns the progress of loading a file lazily in range [0, 1]. It returns 1 if no file is being loaded.
+		double load_progress() const;
+
 		void store(const path_type& file);
 		void store(const path_type& file, nana::unicode encoding);
 
@@ -256,6 +265,24 @@ namespace nana
 		void set_keywords(const std::string& name, bool case_sensitive, bool whole_word_match, std::initializer_list<std::string> kw_list_utf8);
 		void erase_keyword(const std::string& kw);
 
+		/// Finds the text and selects the match. The search starts from the selection or the caret, and wraps around.
+		/// @return true if the text is found.
+		bool find(const std::string& text, bool case_sensitive = true, bool whole_word = false, bool forward = true);
+
+		/// Returns the text positions of all the matches.
+		std::vector<upoint> find_all(const std::string& text, bool case_sensitive = true, bool whole_word = false) const;
+
+		/// Replaces all the matches. The replacements are undone in a single step and the textbox is refreshed once.
+		/**
+		 * @param replacement The replacement of matches, it can't contain a line break.
+		 * @return the number of replacements.
+		 */
+		std::size_t replace_all(const std::string& text, const std::string& replacement, bool case_sensitive = true, bool whole_word = false);
+
+		/// Highlights the matches of the text. The matches are found when the lines are drawn.
+		/// @param text The text to highlight. The highlighting is removed if it is empty.
+		void highlight_matches(const std::string& text, bool case_sensitive, bool whole_word, const ::nana::color& fgcolor, const ::nana::color& bgcolor);
+
 		/// Sets the text alignment
 		textbox& text_align(::nana::align alignment);
 
@@ -282,6 +309,14 @@ namespace nana
 		 */
 		void set_undo_queue_length(std::size_t len);
 
+		/// Sets the maximum memory the undo/redo queue occupies
+		/**
+		 * The oldest commands are discarded when the queue exceeds the limit. It works with the queue length,
+		 * whichever is reached first limits the queue.
+		 * @param bytes The maximum number of bytes. If this parameter is zero, the memory is unlimited.
+		 */
+		void set_undo_memory_limit(std::size_t bytes);
+
 		/// Returns the number of lines that text are displayed in the screen.
 		/**
 		 * The number of display lines may be not equal to the number of text lines when the textbox
@@ -292,6 +327,9 @@ namespace nana
 
 		/// Returns the number of text lines.
 		std::size_t text_line_count() const noexcept;
+
+		/// Returns the frame time of rendering and the number of text sections copied from the render cache.
+		widgets::skeletons::text_render_statistics render_statistics() const;
 	protected:
 		//Overrides widget's virtual functions
 		native_string_type _m_caption() const noexcept override;
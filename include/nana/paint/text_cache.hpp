@@ -0,0 +1,50 @@
+/*
+ *	Text Cache Statistics
+ *	Nana C++ Library(http://www.nanapro.org)
+ *	Copyright(C) 2003-2019 Jinhao(cnjinhao@hotmail.com)
+ *
+ *	Distributed under the Boost Software License, Version 1.0.
+ *	(See accompanying file LICENSE_1_0.txt or copy at
+ *	http://www.boost.org/LICENSE_1_0.txt)
+ *
+ *	@file: nana/paint/text_cache.hpp
+ *	@brief: The counters and the memory cap of the caches which are used by drawing and measuring texts.
+ */
+
+#ifndef NANA_PAINT_TEXT_CACHE_HPP
+#define NANA_PAINT_TEXT_CACHE_HPP
+
+#include <cstddef>
+
+namespace nana
+{
+	namespace paint
+	{
+		/// The counters of the glyph cache which keeps the glyph indexes and advances of fonts.
+		/// They are always zero if the platform doesn't cache the glyphs.
+		struct glyph_cache_statistics
+		{
+			std::size_t hits{ 0 };
+			std::size_t misses{ 0 };
+			std::size_t fonts{ 0 };	///< The number of fonts which glyphs are cached
+		};
+
+		/// The counters of the shaped run cache which keeps the reordered, reshaped and font fallback results of texts.
+		/// They are always zero if the platform doesn't cache the shaped runs.
+		struct shaped_run_cache_statistics
+		{
+			std::size_t hits{ 0 };
+			std::size_t misses{ 0 };
+			std::size_t runs{ 0 };		///< The number of cached texts
+			std::size_t bytes{ 0 };		///< The approximate memory used by the cached texts
+			std::size_t capacity{ 0 };	///< The memory cap in bytes
+		};
+
+		glyph_cache_statistics glyph_cache_stats();
+		shaped_run_cache_statistics shaped_run_cache_stats();
+
+		/// Sets the memory cap of the shaped run cache in bytes, 0 disables the cache.
+		void shaped_run_cache_capacity(std::size_t bytes);
+	}//end namespace paint
+}//end namespace nana
+#endif
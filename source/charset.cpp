@@ -24,9 +24,13 @@
 #include <memory>
 #include <locale>	//Added by crillion
 
-//GCC 4.7.0 does not implement the <codecvt> and codecvt_utfx classes
-#ifndef STD_CODECVT_NOT_SUPPORTED
-	#include <codecvt>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#	define NANA_CHARSET_SSE2
+#	include <emmintrin.h>
 #endif
 
 #if defined(NANA_WINDOWS)
@@ -308,40 +312,6 @@ namespace nana
 			return true;
 		}
 
-		/// convert a char C string from The system default Windows ANSI code page CP_ACP or LC_CTYPE c locale (-nix) into utf16 std::string
-		bool mb2wc(std::string& wcstr, const char* s)
-		{
-			if(nullptr == s || *s == 0)
-			{
-				wcstr.clear();
-				return true;
-			}
-#if defined(NANA_WINDOWS)
-			int chars = ::MultiByteToWideChar(CP_ACP, 0, s, -1, 0, 0);
-			if(chars > 1)
-			{
-				wcstr.resize((chars - 1) * sizeof(wchar_t));
-				::MultiByteToWideChar(CP_ACP, 0, s, -1, reinterpret_cast<wchar_t*>(&wcstr[0]), chars - 1);
-				                                      // ^ the trick !
-			}
-#else
-			locale_initializer::init();
-			std::mbstate_t mbstate = std::mbstate_t();
-			std::size_t len = std::mbsrtowcs(nullptr, &s, 0, &mbstate);
-			if(len == static_cast<std::size_t>(-1))
-				return false;
-
-			if(len)
-			{
-				wcstr.resize(sizeof(wchar_t) * len);
-				std::mbsrtowcs(reinterpret_cast<wchar_t*>(&wcstr[0]), &s, len, &mbstate);
-			}
-			else
-				wcstr.clear();
-#endif
-			return true;
-		}
-
 		class charset_encoding_interface
 		{
 		public:
@@ -419,10 +389,11 @@ namespace nana
 		/// buggie?
 		struct utf8_error_police_system : public encoding_error_police
 		{
-			unsigned long next_code_point(const unsigned char*& current_code_unit, const unsigned char* /*end*/) override
+			unsigned long next_code_point(const unsigned char*& current_code_unit, const unsigned char* end) override
 			{
+				//The string may be not null-terminated
 				std::wstring wc;
-				mb2wc(wc, reinterpret_cast<const char*>(current_code_unit));
+				mb2wc(wc, std::string(reinterpret_cast<const char*>(current_code_unit), end - current_code_unit).c_str());
 				current_code_unit++;
 
 				return wc[0];      // use utf16char but what endian?
@@ -438,623 +409,466 @@ namespace nana
 
 
 
-#ifndef STD_CODECVT_NOT_SUPPORTED
-		class charset_string
-			: public charset_encoding_interface
+		/// The transcoder between UTF-8, UTF-16, UTF-32 and wide strings.
+		/**
+		 * The sequences are validated. An ill-formed UTF-8 sequence is passed to the encoding error police,
+		 * an unpaired surrogate or an invalid code point of UTF-16/UTF-32 is replaced with U+FFFD.
+		 * The ASCII characters are converted 16 characters at a time when SSE2 is available, the other
+		 * characters are converted one by one.
+		 */
+		namespace transcoder
 		{
-		public:
-			charset_string(const std::string& s)
-				: data_(s)
-			{}
+			constexpr unsigned long replacement_char = 0xFFFD;
 
-			charset_string(std::string&& s)
-				: data_(std::move(s))
-			{}
+			using wide_unit = std::make_unsigned<wchar_t>::type;
 
-			charset_string(const std::string& s, unicode encoding)
-				: data_(s), is_unicode_(true), utf_x_(encoding)
-			{}
-
-			charset_string(std::string&& s, unicode encoding)
-				: data_(std::move(s)), is_unicode_(true), utf_x_(encoding)
-			{}
-		private:
-			virtual charset_encoding_interface * clone() const
+			/// Decodes a multi-byte sequence of UTF-8, it returns the length of sequence, or 0 if the sequence is ill-formed.
+			inline unsigned decode_utf8(const unsigned char* p, const unsigned char* end, unsigned long& code)
 			{
-				return new charset_string(*this);
-			}
+				const unsigned long lead = *p;
+				const auto bytes = end - p;
 
-			virtual std::string str() const
-			{
-				if(is_unicode_)
+				if (lead < 0xC2)	//A continuation byte or an overlong 2-byte sequence
+					return 0;
+
+				if (lead < 0xE0)
 				{
-					std::wstring wcstr;
-					switch(utf_x_)
-					{
-					case unicode::utf8:
-						wcstr = std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(data_);
-						break;
-					case unicode::utf16:
-						wcstr = std::wstring_convert<std::codecvt_utf16<wchar_t, 0x10FFFF, std::little_endian>>().from_bytes(data_);
-						break;
-					case unicode::utf32:
-						wcstr.append(reinterpret_cast<const wchar_t*>(data_.c_str()), data_.size() / sizeof(wchar_t));
-						break;
-					}
+					if ((bytes < 2) || ((p[1] & 0xC0) != 0x80))
+						return 0;
 
-					std::string mbstr;
-					wc2mb(mbstr, wcstr.c_str());
-					return mbstr;
+					code = ((lead & 0x1F) << 6) | (p[1] & 0x3F);
+					return 2;
 				}
-				return data_;
-			}
 
-			virtual std::string&& str_move()
-			{
-				if(is_unicode_)
-					data_ = str();
-				return std::move(data_);
-			}
-
-			virtual std::string str(unicode encoding) const
-			{
-				if(is_unicode_ && (utf_x_ != encoding))
+				if (lead < 0xF0)
 				{
-					switch(utf_x_)
-					{
-					case unicode::utf8:
-						switch(encoding)
-						{
-						case unicode::utf16:
-							return std::wstring_convert<std::codecvt_utf16<char16_t>, char16_t>().to_bytes(
-								std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t>().from_bytes(data_)
-								);
-						case unicode::utf32:
-							{
-								std::u32string u32str = std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t>().from_bytes(data_);
-								return std::string(reinterpret_cast<const char*>(u32str.c_str()), u32str.size() * sizeof(char32_t));
-							}
-						default:
-							break;	//no conversion
-						}
-						break;
-					case unicode::utf16:
-						switch(encoding)
-						{
-						case unicode::utf8:
-							return std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t>().to_bytes(
-								std::wstring_convert<std::codecvt_utf16<char16_t>, char16_t>().from_bytes(data_)
-								);
-						case unicode::utf32:
-							{
-								std::u32string u32str = std::wstring_convert<std::codecvt_utf16<char32_t>, char32_t>().from_bytes(data_);
-								return std::string(reinterpret_cast<const char*>(u32str.c_str()), u32str.size() * sizeof(char32_t));
-							}
-						default:
-							break;	//no conversion
-						}
-						break;
-					case unicode::utf32:
-						switch(encoding)
-						{
-						case unicode::utf8:
-							return std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t>().to_bytes(
-									std::u32string(reinterpret_cast<const char32_t*>(data_.c_str()), data_.size() / sizeof(char32_t))
-								);
-						case unicode::utf16:
-							return std::wstring_convert<std::codecvt_utf16<char32_t>, char32_t>().to_bytes(
-									std::u32string(reinterpret_cast<const char32_t*>(data_.c_str()), data_.size() / sizeof(char32_t))
-								);
-						default:
-							break; //no conversion
-						}
-						break;
-					}
-					return{};
+					if ((bytes < 3) || ((p[1] & 0xC0) != 0x80) || ((p[2] & 0xC0) != 0x80))
+						return 0;
+
+					code = ((lead & 0xF) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+
+					//Overlong sequence or surrogate
+					if ((code < 0x800) || (0xD800 <= code && code <= 0xDFFF))
+						return 0;
+					return 3;
 				}
 
-				std::wstring wcstr;
-				if(mb2wc(wcstr, data_.c_str()))
+				if (lead < 0xF5)
 				{
-					switch(encoding)
-					{
-					case unicode::utf8:
-						return std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes(wcstr);
-					case unicode::utf16:
-						return std::wstring_convert<std::codecvt_utf16<wchar_t, 0x10FFFF, std::little_endian>>().to_bytes(wcstr);
-					case unicode::utf32:
-	#if defined(NANA_WINDOWS)
-						{
-							const char * bytes = reinterpret_cast<const char*>(wcstr.c_str());
-							std::u32string utf32str = std::wstring_convert<std::codecvt_utf16<char32_t>, char32_t>().from_bytes(bytes, bytes + sizeof(wchar_t) * wcstr.size());
-							return std::string(reinterpret_cast<const char*>(utf32str.c_str()), sizeof(char32_t) * utf32str.size());
-						}
-	#elif defined(NANA_POSIX)
-						return std::string(reinterpret_cast<const char*>(wcstr.c_str()), sizeof(wchar_t) * wcstr.size());
-	#else
-						throw std::runtime_error("Bad charset");
-	#endif
-					}
+					if ((bytes < 4) || ((p[1] & 0xC0) != 0x80) || ((p[2] & 0xC0) != 0x80) || ((p[3] & 0xC0) != 0x80))
+						return 0;
+
+					code = ((lead & 0x7) << 18) | ((p[1] & 0x3F) << 12) | ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+					if ((code < 0x10000) || (code > 0x10FFFF))
+						return 0;
+					return 4;
 				}
-				return{};
+				return 0;
 			}
 
-			virtual std::wstring wstr() const
+			/// Encodes a code point to UTF-8, it returns the number of bytes written.
+			inline unsigned encode_utf8(char* p, unsigned long code)
 			{
-				if(is_unicode_)
+				if (code < 0x80)
 				{
-					switch(utf_x_)
-					{
-					case unicode::utf8:
-						return std::wstring_convert<std::codecvt_utf8<wchar_t, 0x10FFFF, std::little_endian>>().from_bytes(data_);
-					case unicode::utf16:
-						return std::wstring_convert<std::codecvt_utf16<wchar_t, 0x10FFFF, std::little_endian>>().from_bytes(data_);
-					case unicode::utf32:
-						return std::wstring(reinterpret_cast<const wchar_t*>(data_.c_str()), data_.size() * sizeof(wchar_t));
-					}
-					return{};
+					p[0] = static_cast<char>(code);
+					return 1;
 				}
-
-				std::wstring wcstr;
-				mb2wc(wcstr, data_.c_str());
-				return wcstr;
-			}
-
-			virtual std::wstring && wstr_move()
-			{
-				wdata_for_move_ = wstr();
-				return std::move(wdata_for_move_);
-			}
-		private:
-			std::string data_;
-			std::wstring wdata_for_move_{};
-			bool is_unicode_{ false };
-			unicode utf_x_{ unicode::utf8 };
-		};
-
-		class charset_wstring
-			: public charset_encoding_interface
-		{
-		public:
-			charset_wstring(const std::wstring& s)
-				: data_(s)
-			{}
-
-			charset_wstring(std::wstring&& s)
-				: data_(std::move(s))
-			{}
-
-			virtual charset_encoding_interface * clone() const
-			{
-				return new charset_wstring(*this);
-			}
-
-			virtual std::string str() const
-			{
-				if(data_.size())
+				else if (code < 0x800)
 				{
-					std::string mbstr;
-					wc2mb(mbstr, data_.c_str());
-					return mbstr;
+					p[0] = static_cast<char>(0xC0 | (code >> 6));
+					p[1] = static_cast<char>(0x80 | (code & 0x3F));
+					return 2;
+				}
+				else if (code < 0x10000)
+				{
+					p[0] = static_cast<char>(0xE0 | (code >> 12));
+					p[1] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+					p[2] = static_cast<char>(0x80 | (code & 0x3F));
+					return 3;
 				}
-				return{};
-			}
 
-			virtual std::string&& str_move()
-			{
-				data_for_move_ = str();
-				return std::move(data_for_move_);
+				p[0] = static_cast<char>(0xF0 | (code >> 18));
+				p[1] = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+				p[2] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+				p[3] = static_cast<char>(0x80 | (code & 0x3F));
+				return 4;
 			}
 
-			virtual std::string str(unicode encoding) const
+			/// Decodes a character of a wide string. The wide string is UTF-16 if wchar_t is 2 bytes, otherwise UTF-32.
+			inline unsigned long decode_wide(const wchar_t*& p, const wchar_t* end)
 			{
-				switch(encoding)
+				const unsigned long code = static_cast<wide_unit>(*p++);
+				if (0xD800 <= code && code <= 0xDFFF)
 				{
-				case unicode::utf8:
-					return std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes(data_);
-				case unicode::utf16:
-					return std::wstring_convert<std::codecvt_utf16<wchar_t, 0x10FFFF, std::little_endian>>().to_bytes(data_);
-				case unicode::utf32:
-	#if defined (NANA_WINDOWS)
+					if ((sizeof(wchar_t) == 2) && (code <= 0xDBFF) && (p != end))
 					{
-						const char* bytes = reinterpret_cast<const char*>(data_.c_str());
-						std::u32string utf32str = std::wstring_convert<std::codecvt_utf16<char32_t>, char32_t>().from_bytes(bytes, bytes + sizeof(wchar_t) * data_.size());
-						return std::string(reinterpret_cast<const char*>(utf32str.c_str()), sizeof(char32_t) * utf32str.size());
+						const unsigned long low = static_cast<wide_unit>(*p);
+						if (0xDC00 <= low && low <= 0xDFFF)
+						{
+							++p;
+							return 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+						}
 					}
-	#elif defined(NANA_POSIX)
-					return std::string(reinterpret_cast<const char*>(data_.c_str()), data_.size() * sizeof(wchar_t));
-	#else
-					throw std::runtime_error("Bad charset");
-	#endif
+					return replacement_char;
 				}
-				return std::string();
+				return (code <= 0x10FFFF ? code : replacement_char);
 			}
 
-			virtual std::wstring wstr() const
+			/// Returns true if the wide string has neither an unpaired surrogate nor an invalid code point.
+			inline bool valid_wide(const wchar_t* p, std::size_t len)
 			{
-				return data_;
-			}
+				for (auto end = p + len; p != end; ++p)
+				{
+					const unsigned long code = static_cast<wide_unit>(*p);
+					if (0xD800 <= code && code <= 0xDFFF)
+					{
+						if ((sizeof(wchar_t) == 4) || (code > 0xDBFF) || (p + 1 == end))
+							return false;
 
-			virtual std::wstring&& wstr_move()
-			{
-				return std::move(data_);
+						const unsigned long low = static_cast<wide_unit>(*++p);
+						if (low < 0xDC00 || 0xDFFF < low)
+							return false;
+					}
+					else if (code > 0x10FFFF)
+						return false;
+				}
+				return true;
 			}
-		private:
-			std::wstring data_;
-			std::string data_for_move_;
-		};
-#else
-
 
-        /// return the first code point and move the pointer to next character, springing to the end by errors
-		unsigned long utf8char(const unsigned char*& p, const unsigned char* end)
-		{
-			if(p != end)
+			/// Encodes a code point to a wide string, it returns the number of units written.
+			inline unsigned encode_wide(wchar_t* p, unsigned long code)
 			{
-				if(*p < 0x80)        // ASCII char   0-127 or 0-0x80
-				{
-					return *(p++);
-				}
-				unsigned ch = *p;
-				unsigned long code;
-				if(ch < 0xC0)       // error? - move to end. Possible ANSI or ISO code-page
-				{
-					//return *(p++); // temp: assume equal
-					//p = end;
-					//return 0;
-					return def_encoding_error_police->next_code_point(p, end);
-				}
-				else if(ch < 0xE0 && (p + 1 <= end))      // two byte character
-				{
-					code = ((ch & 0x1F) << 6) | (p[1] & 0x3F);
-					p += 2;
-				}
-				else if(ch < 0xF0 && (p + 2 <= end))     // 3 byte character
+				if ((sizeof(wchar_t) == 2) && (code > 0xFFFF))
 				{
-					code = ((((ch & 0xF) << 6) | (p[1] & 0x3F)) << 6) | (p[2] & 0x3F);
-					p += 3;
+					p[0] = static_cast<wchar_t>(0xD800 | ((code - 0x10000) >> 10));
+					p[1] = static_cast<wchar_t>(0xDC00 | ((code - 0x10000) & 0x3FF));
+					return 2;
 				}
-				else if(ch < 0x1F && (p + 3 <= end))   // 4 byte character
-				{
-					code = ((((((ch & 0x7) << 6) | (p[1] & 0x3F)) << 6) | (p[2] & 0x3F)) << 6) | (p[3] & 0x3F);
-					p += 4;
-				}
-				else    //  error, go to end
-				{
-					p = end;
-					return 0;
-				}
-				return code;
+				p[0] = static_cast<wchar_t>(code);
+				return 1;
 			}
-			return 0;
-		}
 
-		unsigned long utf16char(const unsigned char* & bytes, const unsigned char* end, bool le_or_be)
-		{
-			unsigned long code;
-			if(le_or_be)
+			/// Decodes a character of UTF-16 bytes. It requires at least 2 bytes.
+			inline unsigned long decode_utf16(const unsigned char*& p, const unsigned char* end, bool le_or_be)
 			{
-				if((end - bytes >= 4) && ((bytes[1] & 0xFC) == 0xD8))
+				auto unit = [le_or_be](const unsigned char* bytes) -> unsigned long
 				{
-					//32bit encoding
-					unsigned long ch0 = bytes[0] | (bytes[1] << 8);
-					unsigned long ch1 = bytes[2] | (bytes[3] << 8);
+					return (le_or_be ? (bytes[0] | (bytes[1] << 8)) : ((bytes[0] << 8) | bytes[1]));
+				};
 
-					code = ((ch0 & 0x3FF) << 10) | (ch1 & 0x3FF);
-					bytes += 4;
-				}
-				else if(end - bytes >= 2)
-				{
-					code = bytes[0] | (bytes[1] << 8);
-					bytes += 2;
-				}
-				else
-				{
-					bytes = end;
-					return 0;
-				}
-			}
-			else
-			{
-				if((end - bytes >= 4) && ((bytes[0] & 0xFC) == 0xD8))
-				{
-					//32bit encoding
-					unsigned long ch0 = (bytes[0] << 8) | bytes[1];
-					unsigned long ch1 = (bytes[2] << 8) | bytes[3];
-					code = (((ch0 & 0x3FF) << 10) | (ch1 & 0x3FF)) + 0x10000;
-					bytes += 4;
-				}
-				else if(end - bytes >= 2)
-				{
-					code = (bytes[0] << 8) | bytes[1];
-					bytes += 2;
-				}
-				else
+				const auto code = unit(p);
+				p += 2;
+				if (0xD800 <= code && code <= 0xDFFF)
 				{
-					bytes = end;
-					return 0;
+					if ((code <= 0xDBFF) && (end - p >= 2))
+					{
+						const auto low = unit(p);
+						if (0xDC00 <= low && low <= 0xDFFF)
+						{
+							p += 2;
+							return 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+						}
+					}
+					return replacement_char;
 				}
+				return code;
 			}
-			return code;
-		}
 
-		unsigned long utf32char(const unsigned char* & bytes, const unsigned char* end, bool le_or_be)
-		{
-			if(end - bytes >= 4)
+			/// Decodes a character of UTF-32 bytes. It requires at least 4 bytes.
+			inline unsigned long decode_utf32(const unsigned char*& p, bool le_or_be)
 			{
 				unsigned long code;
-				if(le_or_be)
-					code = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
+				if (le_or_be)
+					code = p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<unsigned long>(p[3]) << 24);
 				else
-					code = bytes[3] | (bytes[2] << 8) | (bytes[1] << 16) | (bytes[0] << 24);
-				bytes += 4;
-				return code;
-			}
-			bytes = end;
-			return 0;
-		}
+					code = p[3] | (p[2] << 8) | (p[1] << 16) | (static_cast<unsigned long>(p[0]) << 24);
 
-		void put_utf8char(std::string& s, unsigned long code)
-		{
-			if(code < 0x80)
-			{
-				s += static_cast<char>(code);
-			}
-			else if(code < 0x800)
-			{
-				s += static_cast<char>(0xC0 | (code >> 6));
-				s += static_cast<char>(0x80 | (code & 0x3F));
-			}
-			else if(code < 0x10000)
-			{
-				s += static_cast<char>(0xE0 | (code >> 12));
-				s += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
-				s += static_cast<char>(0x80 | (code & 0x3F));
-			}
-			else
-			{
-				s += static_cast<char>(0xF0 | (code >> 18));
-				s += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
-				s += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
-				s += static_cast<char>(0x80 | (code & 0x3F));
+				p += 4;
+				if ((code > 0x10FFFF) || (0xD800 <= code && code <= 0xDFFF))
+					return replacement_char;
+				return code;
 			}
-		}
 
-		//le_or_be, true = le, false = be
-		void put_utf16char(std::string& s, unsigned long code, bool le_or_be)
-		{
-			if(code <= 0xFFFF)
+			/// Appends a code point to a string of bytes in the specified encoding.
+			void put_char(std::string& s, unsigned long code, unicode encoding, bool le_or_be)
 			{
-				if(le_or_be)
+				char buf[4];
+				switch (encoding)
 				{
-					s += static_cast<char>(code & 0xFF);
-					s += static_cast<char>((code & 0xFF00) >> 8);
-				}
-				else
-				{
-					s += static_cast<char>((code & 0xFF00) >> 8);
-					s += static_cast<char>(code & 0xFF);
+				case unicode::utf8:
+					s.append(buf, encode_utf8(buf, code));
+					break;
+				case unicode::utf16:
+					if (code > 0xFFFF)
+					{
+						put_char(s, 0xD800 | ((code - 0x10000) >> 10), encoding, le_or_be);
+						code = 0xDC00 | ((code - 0x10000) & 0x3FF);
+					}
+
+					buf[le_or_be ? 0 : 1] = static_cast<char>(code & 0xFF);
+					buf[le_or_be ? 1 : 0] = static_cast<char>((code >> 8) & 0xFF);
+					s.append(buf, 2);
+					break;
+				case unicode::utf32:
+					for (int i = 0; i < 4; ++i)
+						buf[le_or_be ? i : 3 - i] = static_cast<char>((code >> (i * 8)) & 0xFF);
+					s.append(buf, 4);
+					break;
 				}
 			}
-			else
+
+			/// Calls fn with every character of a unicode string in bytes.
+			/**
+			 * The byte order of UTF-16 and UTF-32 is determined by the BOM, it is little endian if there is
+			 * no BOM. The BOM is kept as U+FEFF. The ill-formed UTF-8 sequences are passed to the police.
+			 * @param le_or_be Receives the byte order of the string, it is set before the first call of fn.
+			 */
+			template<typename Function>
+			void for_each_char(const std::string& s, unicode encoding, bool& le_or_be, Function fn)
 			{
-				unsigned long ch0 = (0xD800 | ((code - 0x10000) >> 10));
-				unsigned long ch1 = (0xDC00 | ((code - 0x10000) & 0x3FF));
+				auto p = reinterpret_cast<const unsigned char*>(s.data());
+				auto const end = p + s.size();
 
-				if(le_or_be)
+				le_or_be = true;
+				switch (encoding)
 				{
-					s += static_cast<char>(ch0 & 0xFF);
-					s += static_cast<char>((ch0 & 0xFF00) >> 8);
+				case unicode::utf8:
+					while (p != end)
+					{
+						unsigned long code = *p;
+						if (code < 0x80)
+							++p;
+						else if (auto len = decode_utf8(p, end, code))
+							p += len;
+						else
+						{
+							auto const begin = p;
+							code = def_encoding_error_police->next_code_point(p, end);
+							if (p == begin)
+								++p;
+						}
+						fn(code);
+					}
+					break;
+				case unicode::utf16:
+					if ((end - p >= 2) && (p[0] == 0xFE) && (p[1] == 0xFF))
+						le_or_be = false;
 
-					s += static_cast<char>(ch1 & 0xFF);
-					s += static_cast<char>((ch1 & 0xFF00) >> 8);
-				}
-				else
-				{
-					s += static_cast<char>((ch0 & 0xFF00) >> 8);
-					s += static_cast<char>(ch0 & 0xFF);
+					while (end - p >= 2)
+						fn(decode_utf16(p, end, le_or_be));
+					break;
+				case unicode::utf32:
+					if ((end - p >= 4) && (p[0] == 0) && (p[1] == 0) && (p[2] == 0xFE) && (p[3] == 0xFF))
+						le_or_be = false;
 
-					s += static_cast<char>((ch1 & 0xFF00) >> 8);
-					s += static_cast<char>(ch1 & 0xFF);
+					while (end - p >= 4)
+						fn(decode_utf32(p, le_or_be));
+					break;
 				}
 			}
-		}
 
-		void put_utf32char(std::string& s, unsigned long code, bool le_or_be)
-		{
-			if(le_or_be)
+			/// Converts UTF-8 to a wide string.
+			void utf8_to_wide(const char* s, std::size_t len, std::wstring& wstr)
 			{
-				s += static_cast<char>(code & 0xFF);
-				s += static_cast<char>((code & 0xFF00) >> 8);
-				s += static_cast<char>((code & 0xFF0000) >> 16);
-				s += static_cast<char>((code & 0xFF000000) >> 24);
-			}
-			else
-			{
-				s += static_cast<char>((code & 0xFF000000) >> 24);
-				s += static_cast<char>((code & 0xFF0000) >> 16);
-				s += static_cast<char>((code & 0xFF00) >> 8);
-				s += static_cast<char>(code & 0xFF);
-			}
-		}
-
-		std::string utf8_to_utf16(const std::string& s, bool le_or_be)
-		{
-			const unsigned char * bytes = reinterpret_cast<const unsigned char*>(s.c_str());
-			const unsigned char * end = bytes + s.size();
+				auto p = reinterpret_cast<const unsigned char*>(s);
+				auto const end = p + len;
 
-			std::string utf16str;
+				//A well-formed sequence is never converted to more units than its bytes, so the length of
+				//the UTF-8 string is enough unless the police returns a character for each byte of a surrogate pair.
+				wstr.resize(len);
+				std::size_t pos = 0;
 
-			//If there is a BOM, ignore it.
-			if(s.size() >= 3)
-			{
-				if(bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF)
+				while (p != end)
 				{
-					bytes += 3;
-					put_utf16char(utf16str, 0xFEFF, le_or_be);
-				}
-			}
+#ifdef NANA_CHARSET_SSE2
+					for (const __m128i zero = _mm_setzero_si128(); (end - p >= 16) && (wstr.size() - pos >= 16); p += 16, pos += 16)
+					{
+						const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+						if (_mm_movemask_epi8(bytes))
+							break;
 
-			while(bytes != end)
-			{
-				put_utf16char(utf16str, utf8char(bytes, end), le_or_be);
-			}
-			return utf16str;
-		}
+						auto dst = reinterpret_cast<__m128i*>(&wstr[pos]);
+						const auto low = _mm_unpacklo_epi8(bytes, zero);
+						const auto high = _mm_unpackhi_epi8(bytes, zero);
+						if (sizeof(wchar_t) == 2)
+						{
+							_mm_storeu_si128(dst, low);
+							_mm_storeu_si128(dst + 1, high);
+						}
+						else
+						{
+							_mm_storeu_si128(dst, _mm_unpacklo_epi16(low, zero));
+							_mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(low, zero));
+							_mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(high, zero));
+							_mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(high, zero));
+						}
+					}
 
-		std::string utf8_to_utf32(const std::string& s, bool le_or_be)
-		{
-			const unsigned char * bytes = reinterpret_cast<const unsigned char*>(s.c_str());
-			const unsigned char * end = bytes + s.size();
+					if (p == end)
+						break;
+#endif
+					if (*p < 0x80)
+					{
+						wstr[pos++] = static_cast<wchar_t>(*p++);
+						continue;
+					}
 
-			std::string utf32str;
-			//If there is a BOM, ignore it.
-			if(s.size() >= 3)
-			{
-				if(bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF)
-				{
-					bytes += 3;
-					put_utf32char(utf32str, 0xFEFF, le_or_be);
+					//Converts the run of non-ASCII characters
+					do
+					{
+						unsigned long code;
+						if (auto bytes = decode_utf8(p, end, code))
+							p += bytes;
+						else
+						{
+							auto const begin = p;
+							code = def_encoding_error_police->next_code_point(p, end);
+							if (p == begin)
+								++p;
+
+							if (wstr.size() - pos < 2)
+								wstr.resize(pos + 2 + static_cast<std::size_t>(end - p));
+						}
+						pos += encode_wide(&wstr[pos], code);
+					} while ((p != end) && (*p >= 0x80));
 				}
+				wstr.resize(pos);
 			}
 
-			while(bytes != end)
+			/// Converts a wide string to UTF-8.
+			void wide_to_utf8(const wchar_t* s, std::size_t len, std::string& str)
 			{
-				put_utf32char(utf32str, utf8char(bytes, end), le_or_be);
-			}
-			return utf32str;
-		}
+				auto p = s;
+				auto const end = s + len;
 
-		std::string utf16_to_utf8(const std::string& s)
-		{
-			const unsigned char * bytes = reinterpret_cast<const unsigned char*>(s.c_str());
-			const unsigned char * end = bytes + s.size();
-			bool le_or_be = true;
-			std::string utf8str;
-			//If there is a BOM, ignore it
-			if(s.size() >= 2)
-			{
-				if(bytes[0] == 0xFF && bytes[1] == 0xFE)
-				{
-					bytes += 2;
-					le_or_be = true;
+				str.resize(len);
+				std::size_t pos = 0;
 
-					utf8str += (char)0xEF;
-					utf8str += (char)0xBB;
-					utf8str += (char)0xBF;
-				}
-				else if(bytes[0] == 0xFE && bytes[1] == 0xFF)
+				while (p != end)
 				{
-					bytes += 2;
-					le_or_be = false;
-					utf8str += (char)(0xEF);
-					utf8str += (char)(0xBB);
-					utf8str += (char)(0xBF);
-				}
-			}
+#ifdef NANA_CHARSET_SSE2
+					//The mask tests the units in the lanes of their own width, a lane of 32 bits holds two units of a 16-bit wchar_t.
+					const __m128i non_ascii = (sizeof(wchar_t) == 2 ? _mm_set1_epi16(~0x7F) : _mm_set1_epi32(~0x7F));
+					for (; (end - p >= 16) && (str.size() - pos >= 16); p += 16, pos += 16)
+					{
+						auto src = reinterpret_cast<const __m128i*>(p);
+						__m128i bytes;
+						if (sizeof(wchar_t) == 2)
+						{
+							const auto a = _mm_loadu_si128(src);
+							const auto b = _mm_loadu_si128(src + 1);
+							if (0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(a, b), non_ascii), _mm_setzero_si128())))
+								break;
 
-			while(bytes != end)
-			{
-				put_utf8char(utf8str, utf16char(bytes, end, le_or_be));
+							bytes = _mm_packus_epi16(a, b);
+						}
+						else
+						{
+							const auto a = _mm_loadu_si128(src);
+							const auto b = _mm_loadu_si128(src + 1);
+							const auto c = _mm_loadu_si128(src + 2);
+							const auto d = _mm_loadu_si128(src + 3);
+							const auto all = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+							if (0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(all, non_ascii), _mm_setzero_si128())))
+								break;
+
+							bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+						}
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(&str[pos]), bytes);
+					}
+
+					if (p == end)
+						break;
+#endif
+					if (static_cast<wide_unit>(*p) < 0x80)
+					{
+						if (pos == str.size())
+							str.resize(pos + 1 + static_cast<std::size_t>(end - p));
+
+						str[pos++] = static_cast<char>(*p++);
+						continue;
+					}
+
+					//Converts the run of non-ASCII characters
+					do
+					{
+						auto code = decode_wide(p, end);
+						if (str.size() - pos < 4)
+							str.resize((std::max)(str.size() * 2, pos + 4 + static_cast<std::size_t>(end - p)));
+
+						pos += encode_utf8(&str[pos], code);
+					} while ((p != end) && (static_cast<wide_unit>(*p) >= 0x80));
+				}
+				str.resize(pos);
 			}
-			return utf8str;
-		}
 
-		std::string utf16_to_utf32(const std::string& s)
-		{
-			const unsigned char * bytes = reinterpret_cast<const unsigned char*>(s.c_str());
-			const unsigned char * end = bytes + s.size();
-			bool le_or_be = true;
-			std::string utf32str;
-			//If there is a BOM, ignore it
-			if(s.size() >= 2)
+			/// Converts a unicode string in bytes to a wide string.
+			std::wstring to_wide(const std::string& s, unicode encoding)
 			{
-				if(bytes[0] == 0xFF && bytes[1] == 0xFE)
-				{
-					bytes += 2;
-					le_or_be = true;
-					put_utf32char(utf32str, 0xFEFF, true);
-				}
-				else if(bytes[0] == 0xFE && bytes[1] == 0xFF)
+				std::wstring wstr;
+				if (unicode::utf8 == encoding)
 				{
-					bytes += 2;
-					le_or_be = false;
-					put_utf32char(utf32str, 0xFEFF, false);
+					utf8_to_wide(s.data(), s.size(), wstr);
+					return wstr;
 				}
-			}
 
-			while(bytes != end)
-			{
-				put_utf32char(utf32str, utf16char(bytes, end, le_or_be), le_or_be);
-			}
-			return utf32str;
-		}
+				wstr.reserve(s.size() / (unicode::utf16 == encoding ? 2 : 4));
 
-		std::string utf32_to_utf8(const std::string& s)
-		{
-			const unsigned char * bytes = reinterpret_cast<const unsigned char*>(s.c_str());
-			const unsigned char * end = bytes + (s.size() & (~4 + 1));
+				bool le_or_be;
+				wchar_t buf[2];
+				for_each_char(s, encoding, le_or_be, [&wstr, &buf](unsigned long code)
+				{
+					wstr.append(buf, encode_wide(buf, code));
+				});
+				return wstr;
+			}
 
-			std::string utf8str;
-			bool le_or_be = true;
-			//If there is a BOM, ignore it
-			if(s.size() >= 4)
+			/// Converts a wide string to a unicode string in bytes, the UTF-16 and UTF-32 are little endian.
+			std::string to_bytes(const std::wstring& wstr, unicode encoding)
 			{
-				if(bytes[0] == 0 && bytes[1] == 0 && bytes[2] == 0xFE && bytes[3] == 0xFF)
+				std::string bytes;
+				if (unicode::utf8 == encoding)
 				{
-					le_or_be = false;
-					bytes += 4;
-					utf8str += (char)0xEF;
-					utf8str += (char)0xBB;
-					utf8str += (char)0xBF;
+					wide_to_utf8(wstr.data(), wstr.size(), bytes);
+					return bytes;
 				}
-				else if(bytes[0] == 0xFF && bytes[1] == 0xFE && bytes[2] == 0 && bytes[3] == 0)
-				{
-					le_or_be = true;
-					bytes += 4;
-					utf8str += (char)0xEF;
-					utf8str += (char)0xBB;
-					utf8str += (char)0xBF;
-				}
-			}
 
-			while(bytes < end)
-			{
-				put_utf8char(utf8str, utf32char(bytes, end, le_or_be));
-			}
-			return utf8str;
-		}
+				//The wide string is copied directly if it is in the encoding and valid, otherwise the invalid units are replaced with U+FFFD.
+				if ((sizeof(wchar_t) == (unicode::utf16 == encoding ? 2 : 4)) && valid_wide(wstr.data(), wstr.size()))
+					return std::string(reinterpret_cast<const char*>(wstr.data()), wstr.size() * sizeof(wchar_t));
 
-		std::string utf32_to_utf16(const std::string& s)
-		{
-			const unsigned char * bytes = reinterpret_cast<const unsigned char*>(s.c_str());
-			const unsigned char * end = bytes + (s.size() & (~4 + 1));
+				bytes.reserve(wstr.size() * (unicode::utf16 == encoding ? 2 : 4));
+				for (auto p = wstr.data(), end = p + wstr.size(); p != end;)
+					put_char(bytes, decode_wide(p, end), encoding, true);
+
+				return bytes;
+			}
 
-			std::string utf16str;
-			bool le_or_be = true;
-			//If there is a BOM, ignore it
-			if(s.size() >= 4)
+			/// Converts a unicode string in bytes to another encoding.
+			/**
+			 * The UTF-16 and UTF-32 strings which are converted from UTF-8 are little endian, the others
+			 * keep the byte order of the source string.
+			 */
+			std::string to_bytes(const std::string& s, unicode from, unicode to)
 			{
-				if(bytes[0] == 0 && bytes[1] == 0 && bytes[2] == 0xFE && bytes[3] == 0xFF)
-				{
-					le_or_be = false;
-					bytes += 4;
-					put_utf16char(utf16str, 0xFEFF, false);
-				}
-				else if(bytes[0] == 0xFF && bytes[1] == 0xFE && bytes[2] == 0 && bytes[3] == 0)
+				if (unicode::utf8 == from)
 				{
-					le_or_be = true;
-					bytes += 4;
-					put_utf16char(utf16str, 0xFEFF, true);
+					//The wide string is UTF-16 or UTF-32, one of them is copied directly.
+					return to_bytes(to_wide(s, from), to);
 				}
-			}
 
-			while(bytes < end)
-			{
-				put_utf16char(utf16str, utf32char(bytes, end, le_or_be), le_or_be);
+				std::string bytes;
+				bytes.reserve(s.size());
+
+				bool le_or_be;
+				for_each_char(s, from, le_or_be, [&bytes, to, &le_or_be](unsigned long code)
+				{
+					put_char(bytes, code, to, le_or_be);
+				});
+				return bytes;
 			}
-			return utf16str;
-		}
+		}//end namespace transcoder
 
 		class charset_string
 			: public charset_encoding_interface
@@ -1085,40 +899,8 @@ namespace nana
 			{
 				if(is_unicode_)
 				{
-					std::string strbuf;
-					switch(utf_x_)
-					{
-					case unicode::utf8:
-#if defined(NANA_WINDOWS)
-						strbuf = detail::utf8_to_utf16(data_, true);
-						detail::put_utf16char(strbuf, 0, true);
-#else
-						strbuf = detail::utf8_to_utf32(data_, true);
-						detail::put_utf32char(strbuf, 0, true);
-#endif
-						break;
-					case unicode::utf16:
-#if defined(NANA_WINDOWS)
-						strbuf = data_;
-						detail::put_utf16char(strbuf, 0, true);
-#else
-						strbuf = detail::utf16_to_utf32(data_);
-						detail::put_utf32char(strbuf, 0, true);
-#endif
-						break;
-					case unicode::utf32:
-#if defined(NANA_WINDOWS)
-						strbuf = detail::utf32_to_utf16(data_);
-						detail::put_utf16char(strbuf, 0, true);
-#else
-						strbuf = data_;
-						detail::put_utf32char(strbuf, 0, true);
-#endif
-						break;
-					}
-
 					std::string mbstr;
-					wc2mb(mbstr, reinterpret_cast<const wchar_t*>(strbuf.c_str()));
+					wc2mb(mbstr, transcoder::to_wide(data_, utf_x_).c_str());
 					return mbstr;
 				}
 				return data_;
@@ -1127,108 +909,31 @@ namespace nana
 			virtual std::string && str_move()
 			{
 				if(is_unicode_)
-					data_ = std::move(str());
+					data_ = str();
 				return std::move(data_);
 			}
 
 			virtual std::string str(unicode encoding) const
 			{
-				if(is_unicode_ && (utf_x_ != encoding))
+				if(is_unicode_)
 				{
-					switch(utf_x_)
-					{
-					case unicode::utf8:
-						switch(encoding)
-						{
-						case unicode::utf16:
-							return detail::utf8_to_utf16(data_, true);
-						case unicode::utf32:
-							return detail::utf8_to_utf32(data_, true);
-						default:
-							break;
-						}
-						break;
-					case unicode::utf16:
-						switch(encoding)
-						{
-						case unicode::utf8:
-							return detail::utf16_to_utf8(data_);
-						case unicode::utf32:
-							return detail::utf16_to_utf32(data_);
-						default:
-							break;
-						}
-						break;
-					case unicode::utf32:
-						switch(encoding)
-						{
-						case unicode::utf8:
-							return detail::utf32_to_utf8(data_);
-						case unicode::utf16:
-							return detail::utf32_to_utf16(data_);
-						default:
-							break;
-						}
-						break;
-					}
-					return {};
+					if(utf_x_ == encoding)
+						return data_;
+
+					return transcoder::to_bytes(data_, utf_x_, encoding);
 				}
-				std::string wcstr;
+
+				std::wstring wcstr;
 				if(mb2wc(wcstr, data_.c_str()))
-				{
-					switch(encoding)
-					{
-#if defined(NANA_WINDOWS)
-					case unicode::utf8:
-						return utf16_to_utf8(wcstr);
-					case unicode::utf32:
-						return utf16_to_utf32(wcstr);
-					case unicode::utf16:
-						return wcstr;
-#else //POSIX
-					case unicode::utf8:
-						return utf32_to_utf8(wcstr);
-					case unicode::utf16:
-						return utf32_to_utf16(wcstr);
-					case unicode::utf32:
-						return wcstr;
-#endif
-					}
-				}
+					return transcoder::to_bytes(wcstr, encoding);
+
 				return {};
 			}
 
 			virtual std::wstring wstr() const
 			{
 				if(is_unicode_)
-				{
-					std::string bytes;
-					switch(utf_x_)
-					{
-					case unicode::utf8:
-#if defined(NANA_WINDOWS)
-						bytes = detail::utf8_to_utf16(data_, true);
-#else
-						bytes = detail::utf8_to_utf32(data_, true);
-#endif
-						break;
-					case unicode::utf16:
-#if defined(NANA_WINDOWS)
-						bytes = data_;
-#else
-						bytes = detail::utf16_to_utf32(data_);
-#endif
-						break;
-					case unicode::utf32:
-#if defined(NANA_WINDOWS)
-						bytes = detail::utf32_to_utf16(data_);
-#else
-						bytes = data_;
-#endif
-						break;
-					}
-					return std::wstring(reinterpret_cast<const wchar_t*>(bytes.c_str()), bytes.size() / sizeof(wchar_t));
-				}
+					return transcoder::to_wide(data_, utf_x_);
 
 				std::wstring wcstr;
 				mb2wc(wcstr, data_.c_str());
@@ -1237,7 +942,7 @@ namespace nana
 
 			virtual std::wstring&& wstr_move()
 			{
-				wdata_for_move_ = std::move(wstr());
+				wdata_for_move_ = wstr();
 				return std::move(wdata_for_move_);
 			}
 		private:
@@ -1256,6 +961,10 @@ namespace nana
 				: data_(s)
 			{}
 
+			charset_wstring(std::wstring&& s)
+				: data_(std::move(s))
+			{}
+
 			virtual charset_encoding_interface * clone() const
 			{
 				return new charset_wstring(*this);
@@ -1274,34 +983,13 @@ namespace nana
 
 			virtual std::string && str_move()
 			{
-				data_for_move_ = std::move(str());
+				data_for_move_ = str();
 				return std::move(data_for_move_);
 			}
 
 			virtual std::string str(unicode encoding) const
 			{
-				switch(encoding)
-				{
-				case unicode::utf8:
-#if defined(NANA_WINDOWS)
-					return detail::utf16_to_utf8(std::string(reinterpret_cast<const char*>(data_.c_str()), data_.size() * sizeof(wchar_t)));
-#else
-					return detail::utf32_to_utf8(std::string(reinterpret_cast<const char*>(data_.c_str()), data_.size() * sizeof(wchar_t)));
-#endif
-				case unicode::utf16:
-#if defined(NANA_WINDOWS)
-					return std::string(reinterpret_cast<const char*>(data_.c_str()), data_.size() * sizeof(wchar_t));
-#else
-					return detail::utf32_to_utf16(std::string(reinterpret_cast<const char*>(data_.c_str()), data_.size() * sizeof(wchar_t)));
-#endif
-				case unicode::utf32:
-#if defined(NANA_WINDOWS)
-					return detail::utf16_to_utf32(std::string(reinterpret_cast<const char*>(data_.c_str()), data_.size() * sizeof(wchar_t)));
-#else
-					return std::string(reinterpret_cast<const char*>(data_.c_str()), data_.size() * sizeof(wchar_t));
-#endif
-				}
-				return {};
+				return transcoder::to_bytes(data_, encoding);
 			}
 
 			virtual std::wstring wstr() const
@@ -1317,8 +1005,155 @@ namespace nana
 			std::wstring data_;
 			std::string data_for_move_{};
 		};
-#endif
 	}
+
+	namespace utf
+	{
+		std::wstring utf8_to_wide(const char* text_utf8, std::size_t len)
+		{
+			std::wstring wstr;
+			detail::transcoder::utf8_to_wide(text_utf8, len, wstr);
+			return wstr;
+		}
+
+		std::string wide_to_utf8(const wchar_t* text, std::size_t len)
+		{
+			std::string str;
+			detail::transcoder::wide_to_utf8(text, len, str);
+			return str;
+		}
+
+		void utf8_to_wide(const char* text_utf8, std::size_t len, std::wstring& wstr)
+		{
+			detail::transcoder::utf8_to_wide(text_utf8, len, wstr);
+		}
+
+		void wide_to_utf8(const wchar_t* text, std::size_t len, std::string& str)
+		{
+			detail::transcoder::wide_to_utf8(text, len, str);
+		}
+
+		/// The scratch buffers of a thread
+		template<typename String>
+		class scratch_pool
+		{
+			/// The buffers which are larger than it are freed instead of being kept by the pool.
+			static constexpr std::size_t max_capacity = 64 * 1024;
+			static constexpr std::size_t max_buffers = 8;
+
+			struct buffers
+			{
+				std::vector<std::unique_ptr<String>> idle;
+			};
+
+			static std::vector<std::unique_ptr<String>>& _m_idle()
+			{
+				thread_local buffers bufs;
+				return bufs.idle;
+			}
+		public:
+			static String* acquire()
+			{
+				auto & idle = _m_idle();
+				if (idle.empty())
+					return new String;
+
+				auto buf = idle.back().release();
+				idle.pop_back();
+				return buf;
+			}
+
+			static void release(String* buf)
+			{
+				std::unique_ptr<String> ptr{ buf };
+
+				auto & idle = _m_idle();
+				if ((ptr->capacity() <= max_capacity) && (idle.size() < max_buffers))
+					idle.emplace_back(std::move(ptr));
+			}
+		};
+
+		//class scratch_wstring
+		scratch_wstring::scratch_wstring(const char* text_utf8, std::size_t len)
+			: buf_(scratch_pool<std::wstring>::acquire())
+		{
+			try
+			{
+				detail::transcoder::utf8_to_wide(text_utf8, len, *buf_);
+			}
+			catch (...)
+			{
+				scratch_pool<std::wstring>::release(buf_);
+				throw;
+			}
+		}
+
+		scratch_wstring::scratch_wstring(const std::string& text_utf8)
+			: scratch_wstring(text_utf8.data(), text_utf8.size())
+		{}
+
+		scratch_wstring::~scratch_wstring()
+		{
+			scratch_pool<std::wstring>::release(buf_);
+		}
+
+		const std::wstring& scratch_wstring::str() const noexcept
+		{
+			return *buf_;
+		}
+
+		const wchar_t* scratch_wstring::data() const noexcept
+		{
+			return buf_->data();
+		}
+
+		std::size_t scratch_wstring::size() const noexcept
+		{
+			return buf_->size();
+		}
+		//end class scratch_wstring
+
+		//class scratch_string
+		scratch_string::scratch_string(const wchar_t* text, std::size_t len)
+			: buf_(scratch_pool<std::string>::acquire())
+		{
+			try
+			{
+				detail::transcoder::wide_to_utf8(text, len, *buf_);
+			}
+			catch (...)
+			{
+				scratch_pool<std::string>::release(buf_);
+				throw;
+			}
+		}
+
+		scratch_string::scratch_string(const std::wstring& text)
+			: scratch_string(text.data(), text.size())
+		{}
+
+		scratch_string::~scratch_string()
+		{
+			scratch_pool<std::string>::release(buf_);
+		}
+
+		const std::string& scratch_string::str() const noexcept
+		{
+			return *buf_;
+		}
+
+		const char* scratch_string::data() const noexcept
+		{
+			return buf_->data();
+		}
+
+		std::size_t scratch_string::size() const noexcept
+		{
+			return buf_->size();
+		}
+		//end class scratch_string
+	}
+
 	//class charset
 		charset::charset(const charset& rhs)
 			: impl_(rhs.impl_ ? rhs.impl_->clone() : 0)
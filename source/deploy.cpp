@@ -178,25 +178,22 @@ namespace nana
 #ifdef _nana_std_has_string_view
 	std::string to_utf8(std::wstring_view text)
 	{
-		return ::nana::charset(std::wstring{text}).to_bytes(::nana::unicode::utf8);
+		return ::nana::utf::wide_to_utf8(text.data(), text.size());
 	}
 
 	std::wstring to_wstring(std::string_view utf8_str)
 	{
-		if (utf8_str.empty())
-			return{};
-
-		return ::nana::charset(std::string{ utf8_str.data(), utf8_str.size() }, unicode::utf8);
+		return ::nana::utf::utf8_to_wide(utf8_str.data(), utf8_str.size());
 	}
 #else
 	std::string to_utf8(const std::wstring& text)
 	{
-		return ::nana::charset(text).to_bytes(::nana::unicode::utf8);
+		return ::nana::utf::wide_to_utf8(text.data(), text.size());
 	}
 
 	std::wstring to_wstring(const std::string& utf8_str)
 	{
-		return ::nana::charset(utf8_str, ::nana::unicode::utf8);
+		return ::nana::utf::utf8_to_wide(utf8_str.data(), utf8_str.size());
 	}
 #endif
 
@@ -1,5 +1,6 @@
 #include "platform_abstraction.hpp"
 #include <set>
+#include <type_traits>
 #include <nana/deploy.hpp>
 #include "../paint/truetype.hpp"
 #ifdef _nana_std_has_string_view
@@ -152,33 +153,319 @@ IsWindows8OrGreater()
 #		include <nana/unicode_bidi.hpp>
 #		include "text_reshaping.hpp"
 #		include <X11/Xft/Xft.h>
+#		include "posix/headless_surface.hpp"
 #		include <iconv.h>
 #		include <fstream>
+#		include <mutex>
+#		include <list>
+#		include <unordered_map>
+#		if defined(__SSE2__) || defined(_M_X64)
+#			include <emmintrin.h>
+#		endif
 #	endif
 #endif
 
 namespace nana
 {
 #ifdef NANA_USE_XFT
+	/// The glyph cache of XftFonts
+	/**
+	 * XftCharIndex and XftGlyphExtents are too expensive to be called for every character
+	 * whenever a text is measured, so the glyph index and the advance of a character are cached
+	 * per XftFont. The characters of BMP are stored in the pages of a dense table and the
+	 * others are stored in a hash map. The glyphs of a font are discarded when the font is closed.
+	 */
+	class glyph_cache
+	{
+	public:
+		using statistics = platform_abstraction::glyph_cache_statistics;
+
+		struct glyph
+		{
+			FT_UInt index;
+			int advance;	//It is -1 if the glyph is not cached.
+		};
+
+		class font_glyphs
+		{
+			static constexpr std::size_t page_size = 0x100;
+		public:
+			font_glyphs(statistics& stats, ::XftFont* xft):
+				stats_(stats),
+				xft_(xft)
+			{}
+
+			const glyph& get(Display* disp, wchar_t ch)
+			{
+				auto const code = static_cast<unsigned>(ch);
+
+				glyph* g;
+				if(code < 0x10000)
+				{
+					auto & page = bmp_[code / page_size];
+					if(!page)
+					{
+						page.reset(new glyph[page_size]);
+						for(std::size_t i = 0; i < page_size; ++i)
+							page[i].advance = -1;
+					}
+					g = &page[code % page_size];
+				}
+				else
+					g = &(others_.emplace(code, glyph{ 0, -1 }).first->second);
+
+				if(g->advance >= 0)
+				{
+					++stats_.hits;
+					return *g;
+				}
+
+				++stats_.misses;
+
+				g->index = ::XftCharIndex(disp, xft_, code);
+
+				::XGlyphInfo ext;
+				::XftGlyphExtents(disp, xft_, &g->index, 1, &ext);
+				g->advance = ext.xOff;
+				return *g;
+			}
+		private:
+			statistics& stats_;
+			::XftFont* const xft_;
+			std::unique_ptr<glyph[]> bmp_[0x10000 / page_size];
+			std::unordered_map<unsigned, glyph> others_;
+		};
+
+		/// The mutex should be locked while the glyphs are accessed.
+		std::mutex& mutex()
+		{
+			return mutex_;
+		}
+
+		font_glyphs& glyphs(::XftFont* xft)
+		{
+			auto & ptr = fonts_[xft];
+			if(!ptr)
+				ptr.reset(new font_glyphs(stats_, xft));
+
+			return *ptr;
+		}
+
+		/// Discards the glyphs of a font, it should be called before the font is closed.
+		void erase(::XftFont* xft)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			fonts_.erase(xft);
+		}
+
+		statistics stats()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			auto result = stats_;
+			result.fonts = fonts_.size();
+			return result;
+		}
+	private:
+		std::mutex mutex_;
+		statistics stats_;
+		std::unordered_map<::XftFont*, std::unique_ptr<font_glyphs>> fonts_;
+	};
+
+	/// The result of reordering, reshaping and font fallback of a text
+	struct shaped_run
+	{
+		/// A sequence of glyphs which are drawn with a font and don't contain tabs
+		struct glyph_run
+		{
+			::XftFont* font;
+			int x;	//The offset from the origin of the text
+			std::vector<FT_UInt> glyphs;
+		};
+
+		std::vector<glyph_run> runs;	//In visual order
+		nana::size extent;
+	};
+
+	/// A LRU cache of shaped runs keyed by the font and the text
+	/**
+	 * Widgets redraw the same texts frequently, e.g. the cells of listbox when the mouse moves
+	 * over them, the cache avoids repeating the reordering, reshaping and font fallback scan for
+	 * these texts. The memory used by the cache is limited by its capacity, the least recently
+	 * used runs are evicted when the capacity is exceeded.
+	 */
+	class shaped_run_cache
+	{
+		struct entry
+		{
+			std::size_t hash;
+			::XftFont* font;
+			std::wstring text;
+			shaped_run shaped;
+			std::size_t bytes;
+		};
+
+		using list_type = std::list<entry>;
+	public:
+		using statistics = platform_abstraction::shaped_run_cache_statistics;
+
+		static constexpr std::size_t default_capacity = 1024 * 1024;
+
+		/// The mutex should be locked while the cache is accessed.
+		std::mutex& mutex()
+		{
+			return mutex_;
+		}
+
+		/// Returns the shaped run of the text, or nullptr if it is not cached.
+		/// The returned pointer is valid until the mutex is unlocked.
+		const shaped_run* find(::XftFont* xft, const wchar_t* str, std::size_t len)
+		{
+			auto const hash = _m_hash(xft, str, len);
+			auto range = index_.equal_range(hash);
+			for(auto i = range.first; i != range.second; ++i)
+			{
+				auto & e = *(i->second);
+				if(e.font == xft && e.text.size() == len && std::equal(str, str + len, e.text.data()))
+				{
+					++stats_.hits;
+					entries_.splice(entries_.begin(), entries_, i->second);
+					return &e.shaped;
+				}
+			}
+
+			++stats_.misses;
+			return nullptr;
+		}
+
+		/// Caches a shaped run. The shaped run is moved only if it is cached.
+		/// @return The cached run, or nullptr if the run is not cached because it is larger than the capacity.
+		const shaped_run* insert(::XftFont* xft, const wchar_t* str, std::size_t len, shaped_run&& shaped)
+		{
+			auto bytes = sizeof(entry) + sizeof(list_type::iterator) + len * sizeof(wchar_t) + shaped.runs.size() * sizeof(shaped_run::glyph_run);
+			for(auto & r : shaped.runs)
+				bytes += r.glyphs.size() * sizeof(FT_UInt);
+
+			if(bytes > capacity_)
+				return nullptr;
+
+			auto const hash = _m_hash(xft, str, len);
+			entries_.push_front(entry{ hash, xft, std::wstring{ str, len }, std::move(shaped), bytes });
+			index_.emplace(hash, entries_.begin());
+			bytes_ += bytes;
+
+			_m_shrink();
+			return &entries_.front().shaped;
+		}
+
+		/// Discards the shaped runs which refer to the font, it should be called before the font is closed.
+		void erase(::XftFont* xft)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			for(auto i = entries_.begin(); i != entries_.end();)
+			{
+				bool refer = (i->font == xft);
+				for(auto & r : i->shaped.runs)
+				{
+					if(refer)
+						break;
+					refer = (r.font == xft);
+				}
+
+				if(refer)
+					i = _m_erase(i);
+				else
+					++i;
+			}
+		}
+
+		void capacity(std::size_t bytes)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			capacity_ = bytes;
+			_m_shrink();
+		}
+
+		statistics stats()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			auto result = stats_;
+			result.runs = entries_.size();
+			result.bytes = bytes_;
+			result.capacity = capacity_;
+			return result;
+		}
+	private:
+		static std::size_t _m_hash(::XftFont* xft, const wchar_t* str, std::size_t len)
+		{
+			//FNV-1a
+			std::size_t hash = static_cast<std::size_t>(14695981039346656037ULL) ^ reinterpret_cast<std::size_t>(xft);
+			for(auto end = str + len; str != end; ++str)
+			{
+				hash ^= static_cast<std::size_t>(*str);
+				hash *= static_cast<std::size_t>(1099511628211ULL);
+			}
+			return hash;
+		}
+
+		list_type::iterator _m_erase(list_type::iterator i)
+		{
+			auto range = index_.equal_range(i->hash);
+			for(auto k = range.first; k != range.second; ++k)
+			{
+				if(k->second == i)
+				{
+					index_.erase(k);
+					break;
+				}
+			}
+
+			bytes_ -= i->bytes;
+			return entries_.erase(i);
+		}
+
+		void _m_shrink()
+		{
+			while(bytes_ > capacity_)
+				_m_erase(std::prev(entries_.end()));
+		}
+	private:
+		std::mutex mutex_;
+		statistics stats_;
+		std::size_t capacity_{ default_capacity };
+		std::size_t bytes_{ 0 };
+		list_type entries_;	//The most recently used run is at the front.
+		std::unordered_multimap<std::size_t, list_type::iterator> index_;
+	};
+
 	//A fallback fontset provides the multiple languages support.
 	class fallback_fontset
 	{
 	public:
-		fallback_fontset():
-			disp_(::nana::detail::platform_spec::instance().open_display())
+		fallback_fontset(glyph_cache& glyphs, shaped_run_cache& shaped_runs):
+			disp_(::nana::detail::platform_spec::instance().open_display()),
+			glyphs_(glyphs),
+			shaped_runs_(shaped_runs)
 		{
 		}
 
 		~fallback_fontset()
 		{
 			for(auto xft: xftset_)
+			{
+				shaped_runs_.erase(xft);
+				glyphs_.erase(xft);
 				::XftFontClose(disp_, xft);
+			}
 		}
 
 		void open(const std::string& font_desc, const std::set<std::string>& langs)
 		{
 			for(auto xft: xftset_)
+			{
+				shaped_runs_.erase(xft);
+				glyphs_.erase(xft);
 				::XftFontClose(disp_, xft);
+			}
 
 			xftset_.clear();
 
@@ -213,43 +500,15 @@ namespace nana
 			if(nullptr == str || 0 == len)
 				return 0;
 
-			int const init_x = x;
-			std::unique_ptr<FT_UInt[]> glyph_indexes(new FT_UInt[len]);
+			int width = 0;
+			_m_shaped(xft, str, len, [&](const shaped_run& shaped){
+				for(auto & r : shaped.runs)
+					::XftDrawGlyphs(xftdraw, xftcolor, r.font, x + r.x, y + r.font->ascent, r.glyphs.data(), static_cast<int>(r.glyphs.size()));
 
-			//The RTL and shaping should be handled manually, because the libXft and X doesn't support these language features.
-			std::wstring rtl;
-			auto ents = unicode_reorder(str, len);
-			for(auto & e : ents)
-			{
-				auto size = static_cast<std::size_t>(e.end - e.begin);
-				auto p = e.begin;
-
-				if(unicode_bidi::is_text_right(e))
-				{
-					auto restr = nana::reshaping::arabic::reshape(std::wstring{e.begin, e.end});
-					rtl.assign(restr.crbegin(), restr.crend());
-
-					p = rtl.c_str();
-					size = rtl.size();
-				}
-
-				while(true)
-				{
-					//Scan the string until the character which font is not same with the font of the first character where the scan begins.
-					auto preferred = _m_scan_fonts(xft, p, size, glyph_indexes.get());
-					x += _m_draw(xftdraw, xftcolor, preferred.first, x, y, p, preferred.second, glyph_indexes.get());
-
-					if(size == preferred.second)
-						break;
-
-					size -= preferred.second;
-					p += preferred.second;
-				}
-
-				rtl.clear();
-			}
+				width = static_cast<int>(shaped.extent.width);
+			});
 
-			return x - init_x;
+			return width;
 		}
 
 		std::unique_ptr<unsigned[]> glyph_pixels(::XftFont* xft, const wchar_t* str, std::size_t len)
@@ -263,6 +522,8 @@ namespace nana
 
 			auto pbuf = pxbuf.get();
 
+			std::lock_guard<std::mutex> lock(glyphs_.mutex());
+
 #ifdef _nana_std_has_string_view
 			std::wstring_view s{str, len};
 #else
@@ -274,7 +535,7 @@ namespace nana
 				{
 					auto preferred = _m_scan_fonts(xft, p, size, glyph_indexes.get());
 
-					_m_glyph_px(preferred.first, p, preferred.second, glyph_indexes.get(), pbuf + (pstr - str));
+					_m_glyph_px(preferred.first, p, preferred.second, pbuf + (pstr - str));
 
 					if(size == preferred.second)
 						break;
@@ -295,35 +556,65 @@ namespace nana
 			if(nullptr == str || 0 == len)
 				return extent;
 
+			_m_shaped(xft, str, len, [&extent](const shaped_run& shaped){
+				extent = shaped.extent;
+			});
+
+			return extent;
+		}
+	private:
+		/// Calls the function with the shaped run of the text, the text is shaped if it is not cached.
+		template<typename Function>
+		void _m_shaped(::XftFont* xft, const wchar_t* str, std::size_t len, Function fn)
+		{
+			std::lock_guard<std::mutex> lock(shaped_runs_.mutex());
+
+			auto cached = shaped_runs_.find(xft, str, len);
+			if(cached)
+				return fn(*cached);
+
+			auto shaped = _m_shape(xft, str, len);
+
+			cached = shaped_runs_.insert(xft, str, len, std::move(shaped));
+			fn(cached ? *cached : shaped);
+		}
+
+		shaped_run _m_shape(::XftFont* xft, const wchar_t* str, std::size_t len)
+		{
+			shaped_run shaped;
+			int x = 0;
+
 			std::unique_ptr<FT_UInt[]> glyph_indexes(new FT_UInt[len]);
 
+			std::lock_guard<std::mutex> lock(glyphs_.mutex());
+
 #ifdef _nana_std_has_string_view
 			std::wstring_view s{str, len};
 #else
 			std::wstring s{str, len};
 #endif
-			//Don't reverse the string
-			_m_reorder_reshaping(s, false, [&,xft, str](const wchar_t* p, std::size_t size, const wchar_t* /*pstr*/) mutable{
+			//Reverse the RTL string for drawing
+			_m_reorder_reshaping(s, true, [&, xft](const wchar_t* p, std::size_t size, const wchar_t* /*pstr*/) mutable{
 				while(true)
 				{
+					//Scan the string until the character which font is not same with the font of the first character where the scan begins.
 					auto preferred = _m_scan_fonts(xft, p, size, glyph_indexes.get());
+					x += _m_glyph_runs(preferred.first, x, p, preferred.second, glyph_indexes.get(), shaped.runs);
 
-					extent.width += _m_extents(preferred.first, p, preferred.second, glyph_indexes.get());
-
-					if(preferred.first->ascent + preferred.first->descent > static_cast<int>(extent.height))
-						extent.height = preferred.first->ascent + preferred.first->descent;
+					if(preferred.first->ascent + preferred.first->descent > static_cast<int>(shaped.extent.height))
+						shaped.extent.height = preferred.first->ascent + preferred.first->descent;
 
 					if(size == preferred.second)
 						break;
 
 					size -= preferred.second;
 					p += preferred.second;
-				}				
+				}
 			});
 
-			return extent;
+			shaped.extent.width = static_cast<unsigned>(x);
+			return shaped;
 		}
-	private:
 		/// @param reverse Indicates whether to reverse the string, it only reverse the RTL language string.
 		template<typename Function>
 #ifdef _nana_std_has_string_view
@@ -332,6 +623,13 @@ namespace nana
 		void _m_reorder_reshaping(const std::wstring& str, bool reverse, Function fn)
 #endif
 		{
+			if(_m_ltr_only(str.data(), str.size()))
+			{
+				//Neither the reordering nor the reshaping changes the text
+				fn(str.data(), str.size(), str.data());
+				return;
+			}
+
 			//The RTL and shaping should be handled manually, because the libXft and X doesn't support these language features.
 			std::wstring rtl;
 			auto ents = unicode_reorder(str.data(), str.size());
@@ -360,51 +658,48 @@ namespace nana
 			}
 		}
 
-		//Tab is a invisible character
-		int _m_draw(::XftDraw* xftdraw, ::XftColor* xftcolor, ::XftFont* xft, int x, int y, const wchar_t* str, std::size_t len, const FT_UInt* glyph_indexes)
+		/// Returns true if the text only consists of characters which are laid out from left to right and never shaped.
+		static bool _m_ltr_only(const wchar_t* str, std::size_t len)
 		{
-			int const init_x = x;
-
-			auto p = str;
 			auto const end = str + len;
-
-			y += xft->ascent;
-
-			::XGlyphInfo ext;
-			while(p < end)
+#if defined(__SSE2__) || defined(_M_X64)
+			if(sizeof(wchar_t) == sizeof(int))
 			{
-				auto off = p - str;
-				auto ptab = _m_find_tab(p, end);
-				if(ptab == p)
+				//Skips the blocks of 4 characters which are all less than U+0590, the first RTL code point.
+				const __m128i rtl_begin = _mm_set1_epi32(0x590);
+				for(; end - str >= 4; str += 4)
 				{
-					++p;
-					continue;
+					auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+					if(0xFFFF != _mm_movemask_epi8(_mm_cmplt_epi32(chars, rtl_begin)))
+						break;
 				}
-
-				auto const size = ptab - p;
-
-				::XftDrawGlyphs(xftdraw, xftcolor, xft, x, y, glyph_indexes + off, size);
-				::XftGlyphExtents(disp_, xft, glyph_indexes + off, size, &ext);
-				
-				x += ext.xOff;
-
-				if(ptab == end)
-					break;
-
-				p = ptab + 1;
 			}
+#endif
+			for(; str != end; ++str)
+			{
+				auto const code = static_cast<unsigned>(*str);
+				if(code < 0x590)
+					continue;
 
-			return x - init_x;
+				//Hebrew, Arabic, Syriac, Thaana, NKo, ..., the bidi controls, the presentation forms and the RTL scripts of SMP
+				if((code <= 0x8FF) ||
+					(0x200E <= code && code <= 0x200F) || (0x202A <= code && code <= 0x202E) || (0x2066 <= code && code <= 0x2069) ||
+					(0xFB1D <= code && code <= 0xFDFF) || (0xFE70 <= code && code <= 0xFEFF) ||
+					(0x10800 <= code && code <= 0x10FFF) || (0x1E800 <= code && code <= 0x1EFFF))
+					return false;
+			}
+			return true;
 		}
 
 		//Tab is a invisible character
-		unsigned _m_extents(::XftFont* xft, const wchar_t* const str, const std::size_t len, const FT_UInt* glyph_indexes)
+		int _m_glyph_runs(::XftFont* xft, int x, const wchar_t* str, std::size_t len, const FT_UInt* glyph_indexes, std::vector<shaped_run::glyph_run>& runs)
 		{
-			unsigned pixels = 0;
+			int const init_x = x;
+
 			auto p = str;
 			auto const end = str + len;
 
-			::XGlyphInfo ext;
+			auto & glyphs = glyphs_.glyphs(xft);
 			while(p < end)
 			{
 				auto off = p - str;
@@ -412,39 +707,35 @@ namespace nana
 				if(ptab == p)
 				{
 					++p;
-					//extents->xOff += tab_pixels_;
 					continue;
 				}
 
-				::XftGlyphExtents(disp_, xft, glyph_indexes + off, ptab - p, &ext);
+				runs.push_back(shaped_run::glyph_run{ xft, x, std::vector<FT_UInt>(glyph_indexes + off, glyph_indexes + (ptab - str)) });
 
-				pixels += ext.xOff;
+				for(; p != ptab; ++p)
+					x += glyphs.get(disp_, *p).advance;
 
-				if(end == ptab)
+				if(ptab == end)
 					break;
+
 				p = ptab + 1;
 			}
 
-			return pixels;
+			return x - init_x;
 		}
 
 		//Tab is a invisible character
-		void _m_glyph_px(::XftFont* xft, const wchar_t* str, std::size_t len, const FT_UInt* glyph_indexes, unsigned* pxbuf)
+		void _m_glyph_px(::XftFont* xft, const wchar_t* str, std::size_t len, unsigned* pxbuf)
 		{
 			auto const end = str + len;
 
-			::XGlyphInfo extent;
+			auto & glyphs = glyphs_.glyphs(xft);
 			for(auto p = str; p < end; ++p)
 			{
 				if('\t' != *p)
-				{
-					::XftGlyphExtents(disp_, xft, glyph_indexes, 1, &extent);
-					*pxbuf++ = extent.xOff;
-				}
+					*pxbuf++ = glyphs.get(disp_, *p).advance;
 				else
 					*pxbuf++ = 0;//tab_pixels_;
-
-				++glyph_indexes;
 			}
 		}
 
@@ -463,12 +754,12 @@ namespace nana
 		std::pair<::XftFont*, std::size_t> _m_scan_fonts(::XftFont* xft, const wchar_t* str, std::size_t len, FT_UInt* const glyphs) const
 		{
 			auto preferred = xft;
-			auto idx = ::XftCharIndex(disp_, xft, *str);
+			auto idx = _m_char_index(xft, *str);
 			if(0 == idx)
 			{
 				for(auto ft : xftset_)
 				{
-					idx = ::XftCharIndex(disp_, ft, *str);
+					idx = _m_char_index(ft, *str);
 					if(idx)
 					{
 						preferred = ft;
@@ -484,12 +775,12 @@ namespace nana
 				//scan the str with all fonts until a char index is found.
 				for(std::size_t i = 1; i < len; ++i)
 				{
-					if(::XftCharIndex(disp_, xft, str[i]))
+					if(_m_char_index(xft, str[i]))
 						return {preferred, i};
 
 					for(auto ft : xftset_)
 					{
-						if(::XftCharIndex(disp_, ft, str[i]))
+						if(_m_char_index(ft, str[i]))
 							return {preferred, i};
 					}
 					glyphs[i] = 0;
@@ -499,9 +790,10 @@ namespace nana
 			}
 
 			//scan the str with preferred font until a char index is invalid.
+			auto & preferred_glyphs = glyphs_.glyphs(preferred);
 			for(std::size_t i = 1; i < len; ++i)
 			{
-				idx = ::XftCharIndex(disp_, preferred, str[i]);
+				idx = preferred_glyphs.get(disp_, str[i]).index;
 				if(0 == idx)
 					return {preferred, i};
 
@@ -510,8 +802,15 @@ namespace nana
 
 			return {preferred, len};
 		}
+
+		FT_UInt _m_char_index(::XftFont* xft, wchar_t ch) const
+		{
+			return glyphs_.glyphs(xft).get(disp_, ch).index;
+		}
 	private:
 		Display* const disp_;
+		glyph_cache& glyphs_;
+		shaped_run_cache& shaped_runs_;
 		std::vector<::XftFont*> xftset_;
 	};
 
@@ -540,7 +839,7 @@ namespace nana
 			if(i != xft_table_.end())
 				return i->second;
 			
-			auto fb = std::make_shared<fallback_fontset>();
+			auto fb = std::make_shared<fallback_fontset>(glyphs_, shaped_runs_);
 
 			fb->open(font_desc, langs_);
 
@@ -549,6 +848,16 @@ namespace nana
 			return fb;
 		}
 
+		glyph_cache& glyphs()
+		{
+			return glyphs_;
+		}
+
+		shaped_run_cache& shaped_runs()
+		{
+			return shaped_runs_;
+		}
+
 		void release_fallback(std::shared_ptr<fallback_fontset>& p)
 		{
 			for(auto i = xft_table_.cbegin(); i != xft_table_.cend(); ++i)
@@ -585,10 +894,17 @@ namespace nana
 		}
 	private:
 		std::set<std::string> langs_;
+		glyph_cache glyphs_;	//It should be destroyed after the fallback fontsets
+		shaped_run_cache shaped_runs_;	//It should be destroyed after the fallback fontsets
 		std::map<std::string, std::shared_ptr<fallback_fontset>> xft_table_;
 	};
 #endif
 
+#ifdef NANA_USE_XFT
+	//The FreeType library of headless mode, it is shared by the faces and freed with the last one.
+	using ft_library_ptr = std::shared_ptr<std::remove_pointer<FT_Library>::type>;
+#endif
+
 	struct platform_runtime
 	{
 		std::shared_ptr<font_interface> font;
@@ -598,6 +914,7 @@ namespace nana
 #endif
 #ifdef NANA_USE_XFT
 		fallback_manager fb_manager;
+		ft_library_ptr ft_library;	//It rasterizes the text in headless mode
 #endif
 	};
 
@@ -625,13 +942,14 @@ namespace nana
 		using path_type = std::filesystem::path;
 
 #ifdef NANA_USE_XFT
-		internal_font(const path_type& ttf, const std::string& font_family, double font_size, const font_style& fs, native_font_type native_font, std::shared_ptr<fallback_fontset> fallback):
+		internal_font(const path_type& ttf, const std::string& font_family, double font_size, const font_style& fs, native_font_type native_font, std::shared_ptr<fallback_fontset> fallback, ft_library_ptr ft_library = {}):
 			ttf_(ttf),
 			family_(font_family),
 			size_(font_size),
 			style_(fs),
 			native_handle_(native_font),
-			fallback_(fallback)
+			fallback_(fallback),
+			ft_library_(std::move(ft_library))
 		{}
 #else
 		internal_font(const path_type& ttf, const std::string& font_family, double font_size, const font_style& fs, native_font_type native_font):
@@ -650,8 +968,16 @@ namespace nana
 #elif defined(NANA_X11)
 			auto disp = ::nana::detail::platform_spec::instance().open_display();
 #	ifdef NANA_USE_XFT
-			platform_storage().fb_manager.release_fallback(fallback_);
-			::XftFontClose(disp, reinterpret_cast<XftFont*>(native_handle_));
+			//The face is done before ft_library_ is released, the library is freed with the last face.
+			if (ft_library_)
+				::FT_Done_Face(reinterpret_cast<FT_Face>(native_handle_));
+			else
+			{
+				platform_storage().fb_manager.release_fallback(fallback_);
+				platform_storage().fb_manager.shaped_runs().erase(reinterpret_cast<XftFont*>(native_handle_));
+				platform_storage().fb_manager.glyphs().erase(reinterpret_cast<XftFont*>(native_handle_));
+				::XftFontClose(disp, reinterpret_cast<XftFont*>(native_handle_));
+			}
 #	else
 			::XFreeFontSet(disp, reinterpret_cast<XFontSet>(native_handle_));
 #	endif
@@ -694,6 +1020,7 @@ namespace nana
 		native_font_type const native_handle_;
 #ifdef NANA_USE_XFT
 		std::shared_ptr<fallback_fontset> fallback_;
+		ft_library_ptr ft_library_;	//Only available in headless mode
 #endif
 	};
 
@@ -728,6 +1055,166 @@ namespace nana
 		auto xft = reinterpret_cast<XftFont*>(static_cast<internal_font*>(ft)->native_handle());
 		return fallback->glyph_pixels(xft, str, len);
 	}
+
+	//Headless mode
+	//The font is a FT_Face and the text is rasterized by FreeType into the memory surface of drawable.
+	//Tab is a invisible character, and the fallback fonts and the bidi reordering are not supported.
+
+	static FT_Face ft_open_face(const std::string& font_desc, double size_pt)
+	{
+		auto & r = platform_storage();
+		if (!r.ft_library)
+		{
+			FT_Library library = nullptr;
+			if (::FT_Init_FreeType(&library))
+				return nullptr;
+
+			r.ft_library.reset(library, ::FT_Done_FreeType);
+		}
+
+		auto pat = ::FcNameParse(reinterpret_cast<const FcChar8*>(font_desc.c_str()));
+		if (nullptr == pat)
+			return nullptr;
+
+		::FcConfigSubstitute(nullptr, pat, FcMatchPattern);
+		::FcDefaultSubstitute(pat);
+
+		FcResult res;
+		auto match_pat = ::FcFontMatch(nullptr, pat, &res);
+		::FcPatternDestroy(pat);
+		if (nullptr == match_pat)
+			return nullptr;
+
+		FT_Face face = nullptr;
+		FcChar8* file = nullptr;
+		int index = 0;
+		if (FcResultMatch == ::FcPatternGetString(match_pat, FC_FILE, 0, &file))
+		{
+			::FcPatternGetInteger(match_pat, FC_INDEX, 0, &index);
+			if (::FT_New_Face(r.ft_library.get(), reinterpret_cast<const char*>(file), index, &face))
+				face = nullptr;
+		}
+		::FcPatternDestroy(match_pat);
+
+		//The size is scaled by 96 DPI which is the screen_dpi of headless mode
+		if (face && ::FT_Set_Char_Size(face, 0, static_cast<FT_F26Dot6>(size_pt * 64), 96, 96))
+		{
+			::FT_Done_Face(face);
+			face = nullptr;
+		}
+		return face;
+	}
+
+	static FT_Face ft_face(font_interface* ft)
+	{
+		return (ft ? reinterpret_cast<FT_Face>(static_cast<internal_font*>(ft)->native_handle()) : nullptr);
+	}
+
+	static unsigned ft_advance(FT_GlyphSlot slot)
+	{
+		return static_cast<unsigned>((slot->advance.x + 32) >> 6);
+	}
+
+	void nana_ft_metrics(font_interface* ft, unsigned& ascent, unsigned& descent)
+	{
+		ascent = descent = 0;
+
+		auto face = ft_face(ft);
+		if (face)
+		{
+			ascent = static_cast<unsigned>((face->size->metrics.ascender + 63) >> 6);
+			descent = static_cast<unsigned>((63 - face->size->metrics.descender) >> 6);
+		}
+	}
+
+	void nana_ft_draw_string(paint::drawable_type dw, font_interface* ft, const nana::point& pos, const wchar_t * str, std::size_t len)
+	{
+		auto face = ft_face(ft);
+		if (nullptr == face)
+			return;
+
+		unsigned ascent, descent;
+		nana_ft_metrics(ft, ascent, descent);
+
+		const int baseline = pos.y + static_cast<int>(ascent);
+		const int width = static_cast<int>(dw->pixbuf_size.width);
+		const int height = static_cast<int>(dw->pixbuf_size.height);
+
+		pixel_argb_t fgcolor;
+		fgcolor.value = dw->fgcolor_rgb;
+
+		int x = pos.x;
+		for (auto p = str, end = str + len; p != end; ++p)
+		{
+			if (('\t' == *p) || ::FT_Load_Char(face, *p, FT_LOAD_RENDER))
+				continue;
+
+			auto slot = face->glyph;
+			auto const & bmp = slot->bitmap;
+			const int left = x + slot->bitmap_left;
+			const int top = baseline - slot->bitmap_top;
+
+			for (int row = (std::max)(0, -top); row < static_cast<int>(bmp.rows) && top + row < height; ++row)
+			{
+				auto coverage = bmp.buffer + bmp.pitch * row;
+				auto px = ::nana::detail::headless::row(dw, top + row);
+
+				for (int col = (std::max)(0, -left); col < static_cast<int>(bmp.width) && left + col < width; ++col)
+				{
+					unsigned alpha;
+					if (FT_PIXEL_MODE_MONO == bmp.pixel_mode)
+						alpha = ((coverage[col >> 3] & (0x80 >> (col & 7))) ? 255 : 0);
+					else
+						alpha = coverage[col];
+
+					if (0 == alpha)
+						continue;
+
+					auto & d = px[left + col].element;
+					d.red = static_cast<unsigned char>(d.red + ((static_cast<int>(fgcolor.element.red) - d.red) * static_cast<int>(alpha)) / 255);
+					d.green = static_cast<unsigned char>(d.green + ((static_cast<int>(fgcolor.element.green) - d.green) * static_cast<int>(alpha)) / 255);
+					d.blue = static_cast<unsigned char>(d.blue + ((static_cast<int>(fgcolor.element.blue) - d.blue) * static_cast<int>(alpha)) / 255);
+				}
+			}
+
+			x += static_cast<int>(ft_advance(slot));
+		}
+	}
+
+	nana::size nana_ft_extents(font_interface* ft, const wchar_t* str, std::size_t len)
+	{
+		auto face = ft_face(ft);
+		if (nullptr == face || nullptr == str || 0 == len)
+			return {};
+
+		unsigned ascent, descent;
+		nana_ft_metrics(ft, ascent, descent);
+
+		nana::size extent{ 0, ascent + descent };
+		for (auto p = str, end = str + len; p != end; ++p)
+		{
+			if (('\t' != *p) && (0 == ::FT_Load_Char(face, *p, FT_LOAD_DEFAULT)))
+				extent.width += ft_advance(face->glyph);
+		}
+		return extent;
+	}
+
+	std::unique_ptr<unsigned[]> nana_ft_glyph_pixels(font_interface* ft, const wchar_t* str, std::size_t len)
+	{
+		auto face = ft_face(ft);
+		if (nullptr == face || nullptr == str || 0 == len)
+			return {};
+
+		std::unique_ptr<unsigned[]> pxbuf{ new unsigned[len] };
+		for (std::size_t i = 0; i < len; ++i)
+		{
+			if (('\t' != str[i]) && (0 == ::FT_Load_Char(face, str[i], FT_LOAD_DEFAULT)))
+				pxbuf[i] = ft_advance(face->glyph);
+			else
+				pxbuf[i] = 0;
+		}
+		return pxbuf;
+	}
 #endif
 
 
@@ -746,6 +1233,7 @@ namespace nana
 
 		r.font.reset();
 
+		//The FreeType library of headless mode is not freed here, it is shared by the faces which may be still alive.
 		delete data::storage;
 		data::storage = nullptr;
 	}
@@ -881,6 +1369,14 @@ namespace nana
 		if(fs.italic)
 			pat_str += ":slant=italic";
 
+		if (::nana::detail::platform_spec::instance().headless())
+		{
+			auto face = ft_open_face(font_family + pat_str, (size_pt ? size_pt : platform_abstraction::font_default_pt()));
+			if (face)
+				return std::make_shared<internal_font>(std::move(ttf), std::move(font_family), size_pt, fs, reinterpret_cast<native_font_type>(face), nullptr, platform_storage().ft_library);
+			return{};
+		}
+
 		auto pat = ::XftNameParse((font_family + pat_str).c_str());
 		XftResult res;
 		auto match_pat = ::XftFontMatch(disp, ::XDefaultScreen(disp), pat, &res);
@@ -889,6 +1385,10 @@ namespace nana
 		if (match_pat)
 			fd = ::XftFontOpenPattern(disp, match_pat);
 #	else
+		//The font set requires a X server, there is no font in headless mode without Xft.
+		if (nullptr == disp)
+			return{};
+
 		std::string pat_str;
 		if (font_family.empty())
 			pat_str = "-misc-fixed-*";
@@ -898,7 +1398,7 @@ namespace nana
 		char ** missing_list;
 		int missing_count;
 		char * defstr;
-		XFontSet fd = ::XCreateFontSet(display_, const_cast<char*>(pat_str.c_str()), &missing_list, &missing_count, &defstr);
+		XFontSet fd = ::XCreateFontSet(disp, const_cast<char*>(pat_str.c_str()), &missing_list, &missing_count, &defstr);
 #	endif
 #endif
 
@@ -961,6 +1461,33 @@ namespace nana
 #endif
 	}
 
+	platform_abstraction::glyph_cache_statistics platform_abstraction::glyph_cache_stats()
+	{
+#ifdef NANA_USE_XFT
+		return platform_storage().fb_manager.glyphs().stats();
+#else
+		return{};
+#endif
+	}
+
+	platform_abstraction::shaped_run_cache_statistics platform_abstraction::shaped_run_cache_stats()
+	{
+#ifdef NANA_USE_XFT
+		return platform_storage().fb_manager.shaped_runs().stats();
+#else
+		return{};
+#endif
+	}
+
+	void platform_abstraction::shaped_run_cache_capacity(std::size_t bytes)
+	{
+#ifdef NANA_USE_XFT
+		platform_storage().fb_manager.shaped_runs().capacity(bytes);
+#else
+		static_cast<void>(bytes);	//eliminate unused parameter compiler warning.
+#endif
+	}
+
 	unsigned platform_abstraction::screen_dpi(bool x_requested)
 	{
 #ifdef NANA_WINDOWS
@@ -970,6 +1497,9 @@ namespace nana
 		return dots;
 #else
 		auto & spec = ::nana::detail::platform_spec::instance();
+		if (spec.headless())
+			return 96;
+
 		auto disp = spec.open_display();
 		auto screen = ::XDefaultScreen(disp);
 
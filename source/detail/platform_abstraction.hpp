@@ -18,6 +18,7 @@
 #include "platform_abstraction_types.hpp"
 #include <memory>
 #include <nana/filesystem/filesystem.hpp>
+#include <nana/paint/text_cache.hpp>
 
 namespace nana
 {
@@ -30,6 +31,9 @@ namespace nana
 
 		using path_type = ::std::filesystem::path;
 
+		using glyph_cache_statistics = ::nana::paint::glyph_cache_statistics;
+		using shaped_run_cache_statistics = ::nana::paint::shaped_run_cache_statistics;
+
 		static void initialize();
 		/// Shutdown before destruction of platform_spec 
 		static void shutdown();
@@ -40,6 +44,12 @@ namespace nana
 		static ::std::shared_ptr<font> make_font_from_ttf(const path_type& ttf, double size_pt, const font::font_style& fs);
 		static void font_resource(bool try_add, const path_type& ttf);
 
+		static glyph_cache_statistics glyph_cache_stats();
+		static shaped_run_cache_statistics shaped_run_cache_stats();
+
+		/// Sets the memory cap of the shaped run cache in bytes, 0 disables the cache.
+		static void shaped_run_cache_capacity(std::size_t bytes);
+
 		static unsigned screen_dpi(bool x_requested);
 	};
 }
@@ -22,6 +22,7 @@
 
 #include <X11/Xlocale.h>
 #include <clocale>
+#include <cstring>
 #include <map>
 #include <set>
 #include <algorithm>
@@ -365,8 +366,11 @@ namespace detail
 					(col & 0xFF) * 31 / 255;
 				break;
 			}
-			::XSetForeground(spec.open_display(), context, col);
-			::XSetBackground(spec.open_display(), context, col);
+			if (!spec.headless())
+			{
+				::XSetForeground(spec.open_display(), context, col);
+				::XSetBackground(spec.open_display(), context, col);
+			}
 
 #if defined(NANA_USE_XFT)
 			//xft_fgcolor also needs to be assigned.
@@ -401,8 +405,11 @@ namespace detail
 					(col & 0xFF) * 31 / 255;
 				break;
 			}
-			::XSetForeground(spec.open_display(), context, col);
-			::XSetBackground(spec.open_display(), context, col);
+			if (!spec.headless())
+			{
+				::XSetForeground(spec.open_display(), context, col);
+				::XSetBackground(spec.open_display(), context, col);
+			}
 
 #if defined(NANA_USE_XFT)
 			xft_fgcolor.color.red = ((0xFF0000 & col) >> 16) * 0x101;
@@ -439,7 +446,7 @@ namespace detail
 	{}
 
 	platform_spec::platform_spec()
-		:display_(0), colormap_(0), def_X11_error_handler_(0), grab_(0)
+		:display_(0), headless_(false), colormap_(0), def_X11_error_handler_(0), grab_(0)
 	{
 		::XInitThreads();
 		const char * langstr = getenv("LC_CTYPE");
@@ -466,48 +473,65 @@ namespace detail
 			::XSetLocaleModifiers(langstr_dup.c_str());
 
 
-		display_ = ::XOpenDisplay(0);
-		colormap_ = DefaultColormap(display_,  ::XDefaultScreen(display_));
+#if defined(NANA_HEADLESS)
+		headless_ = true;
+#else
+		auto headless_env = std::getenv("NANA_HEADLESS");
+		headless_ = (headless_env && *headless_env && std::strcmp(headless_env, "0"));
+#endif
+		if(!headless_)
+		{
+			display_ = ::XOpenDisplay(0);
+
+			//Falls back to headless mode, it makes graphics available without a X server.
+			headless_ = (nullptr == display_);
+		}
 
 		//Initialize the member data
 		selection_.content.utf8_string = 0;
 		xdnd_.good_type = None;
 
-		atombase_.wm_protocols = ::XInternAtom(display_, "WM_PROTOCOLS", False);
-		atombase_.wm_change_state = ::XInternAtom(display_, "WM_CHANGE_STATE", False);
-		atombase_.wm_delete_window = ::XInternAtom(display_, "WM_DELETE_WINDOW", False);
-		atombase_.net_frame_extents = ::XInternAtom(display_, "_NET_FRAME_EXTENTS", False);
-		atombase_.net_wm_state = ::XInternAtom(display_, "_NET_WM_STATE", False);
-		atombase_.net_wm_state_skip_taskbar = ::XInternAtom(display_, "_NET_WM_STATE_SKIP_TASKBAR", False);
-		atombase_.net_wm_state_fullscreen = ::XInternAtom(display_, "_NET_WM_STATE_FULLSCREEN", False);
-		atombase_.net_wm_state_maximized_horz = ::XInternAtom(display_, "_NET_WM_STATE_MAXIMIZED_HORZ", False);
-		atombase_.net_wm_state_maximized_vert = ::XInternAtom(display_, "_NET_WM_STATE_MAXIMIZED_VERT", False);
-		atombase_.net_wm_state_modal = ::XInternAtom(display_, "_NET_WM_STATE_MODAL", False);
-		atombase_.net_wm_name = ::XInternAtom(display_, "_NET_WM_NAME", False);
-		atombase_.net_wm_window_type = ::XInternAtom(display_, "_NET_WM_WINDOW_TYPE", False);
-		atombase_.net_wm_window_type_normal = ::XInternAtom(display_, "_NET_WM_WINDOW_TYPE_NORMAL", False);
-		atombase_.net_wm_window_type_utility = ::XInternAtom(display_, "_NET_WM_WINDOW_TYPE_UTILITY", False);
-		atombase_.net_wm_window_type_dialog = ::XInternAtom(display_, "_NET_WM_WINDOW_TYPE_DIALOG", False);
-		atombase_.motif_wm_hints = ::XInternAtom(display_, "_MOTIF_WM_HINTS", False);
-
-		atombase_.clipboard = ::XInternAtom(display_, "CLIPBOARD", False);
-		atombase_.text = ::XInternAtom(display_, "TEXT", False);
-		atombase_.text_uri_list = ::XInternAtom(display_, "text/uri-list", False);
-		atombase_.utf8_string = ::XInternAtom(display_, "UTF8_STRING", False);
-		atombase_.targets = ::XInternAtom(display_, "TARGETS", False);
-
-		atombase_.xdnd_aware = ::XInternAtom(display_, "XdndAware", False);
-		atombase_.xdnd_enter = ::XInternAtom(display_, "XdndEnter", False);
-		atombase_.xdnd_position = ::XInternAtom(display_, "XdndPosition", False);
-		atombase_.xdnd_status	= ::XInternAtom(display_, "XdndStatus", False);
-		atombase_.xdnd_action_copy = ::XInternAtom(display_, "XdndActionCopy", False);
-		atombase_.xdnd_action_move = ::XInternAtom(display_, "XdndActionMove", False);
-		atombase_.xdnd_action_link = ::XInternAtom(display_, "XdndActionLink", False);
-		atombase_.xdnd_drop = ::XInternAtom(display_, "XdndDrop", False);
-		atombase_.xdnd_selection = ::XInternAtom(display_, "XdndSelection", False);
-		atombase_.xdnd_typelist = ::XInternAtom(display_, "XdndTypeList", False);
-		atombase_.xdnd_leave = ::XInternAtom(display_, "XdndLeave", False);
-		atombase_.xdnd_finished = ::XInternAtom(display_, "XdndFinished", False);
+		atombase_ = {};
+		if(!headless_)
+		{
+			colormap_ = DefaultColormap(display_,  ::XDefaultScreen(display_));
+
+			atombase_.wm_protocols = ::XInternAtom(display_, "WM_PROTOCOLS", False);
+			atombase_.wm_change_state = ::XInternAtom(display_, "WM_CHANGE_STATE", False);
+			atombase_.wm_delete_window = ::XInternAtom(display_, "WM_DELETE_WINDOW", False);
+			atombase_.net_frame_extents = ::XInternAtom(display_, "_NET_FRAME_EXTENTS", False);
+			atombase_.net_wm_state = ::XInternAtom(display_, "_NET_WM_STATE", False);
+			atombase_.net_wm_state_skip_taskbar = ::XInternAtom(display_, "_NET_WM_STATE_SKIP_TASKBAR", False);
+			atombase_.net_wm_state_fullscreen = ::XInternAtom(display_, "_NET_WM_STATE_FULLSCREEN", False);
+			atombase_.net_wm_state_maximized_horz = ::XInternAtom(display_, "_NET_WM_STATE_MAXIMIZED_HORZ", False);
+			atombase_.net_wm_state_maximized_vert = ::XInternAtom(display_, "_NET_WM_STATE_MAXIMIZED_VERT", False);
+			atombase_.net_wm_state_modal = ::XInternAtom(display_, "_NET_WM_STATE_MODAL", False);
+			atombase_.net_wm_name = ::XInternAtom(display_, "_NET_WM_NAME", False);
+			atombase_.net_wm_window_type = ::XInternAtom(display_, "_NET_WM_WINDOW_TYPE", False);
+			atombase_.net_wm_window_type_normal = ::XInternAtom(display_, "_NET_WM_WINDOW_TYPE_NORMAL", False);
+			atombase_.net_wm_window_type_utility = ::XInternAtom(display_, "_NET_WM_WINDOW_TYPE_UTILITY", False);
+			atombase_.net_wm_window_type_dialog = ::XInternAtom(display_, "_NET_WM_WINDOW_TYPE_DIALOG", False);
+			atombase_.motif_wm_hints = ::XInternAtom(display_, "_MOTIF_WM_HINTS", False);
+
+			atombase_.clipboard = ::XInternAtom(display_, "CLIPBOARD", False);
+			atombase_.text = ::XInternAtom(display_, "TEXT", False);
+			atombase_.text_uri_list = ::XInternAtom(display_, "text/uri-list", False);
+			atombase_.utf8_string = ::XInternAtom(display_, "UTF8_STRING", False);
+			atombase_.targets = ::XInternAtom(display_, "TARGETS", False);
+
+			atombase_.xdnd_aware = ::XInternAtom(display_, "XdndAware", False);
+			atombase_.xdnd_enter = ::XInternAtom(display_, "XdndEnter", False);
+			atombase_.xdnd_position = ::XInternAtom(display_, "XdndPosition", False);
+			atombase_.xdnd_status	= ::XInternAtom(display_, "XdndStatus", False);
+			atombase_.xdnd_action_copy = ::XInternAtom(display_, "XdndActionCopy", False);
+			atombase_.xdnd_action_move = ::XInternAtom(display_, "XdndActionMove", False);
+			atombase_.xdnd_action_link = ::XInternAtom(display_, "XdndActionLink", False);
+			atombase_.xdnd_drop = ::XInternAtom(display_, "XdndDrop", False);
+			atombase_.xdnd_selection = ::XInternAtom(display_, "XdndSelection", False);
+			atombase_.xdnd_typelist = ::XInternAtom(display_, "XdndTypeList", False);
+			atombase_.xdnd_leave = ::XInternAtom(display_, "XdndLeave", False);
+			atombase_.xdnd_finished = ::XInternAtom(display_, "XdndFinished", False);
+		}
 
 		msg_dispatcher_ = new msg_dispatcher(display_);
 
@@ -530,6 +554,11 @@ namespace detail
 		return display_;
 	}
 
+	bool platform_spec::headless() const
+	{
+		return headless_;
+	}
+
 	void platform_spec::close_display()
 	{
 		if(display_)
@@ -557,6 +586,9 @@ namespace detail
 
 	int platform_spec::screen_depth()
 	{
+		if(headless_)
+			return 32;	//The depth of memory surface
+
 		return ::XDefaultDepth(display_, ::XDefaultScreen(display_));
 	}
 
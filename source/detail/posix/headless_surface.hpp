@@ -0,0 +1,168 @@
+/*
+ *	Headless Memory Surface
+ *	Nana C++ Library(http://www.nanapro.org)
+ *	Copyright(C) 2003-2019 Jinhao(cnjinhao@hotmail.com)
+ *
+ *	Distributed under the Boost Software License, Version 1.0.
+ *	(See accompanying file LICENSE_1_0.txt or copy at
+ *	http://www.boost.org/LICENSE_1_0.txt)
+ *
+ *	@file: nana/detail/posix/headless_surface.hpp
+ *	@brief: The primitives of a drawable which is backed by a memory surface instead of
+ *	a pixmap. They are used when the platform_spec is headless.
+ *
+ *	This file should not be included by any header files.
+ */
+
+#ifndef NANA_DETAIL_HEADLESS_SURFACE_HPP
+#define NANA_DETAIL_HEADLESS_SURFACE_HPP
+
+#include "platform_spec.hpp"
+#include <nana/gui/layout_utility.hpp>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+namespace nana
+{
+namespace detail
+{
+namespace headless
+{
+	inline bool alloc(drawable_impl_type* dw, const nana::size& sz)
+	{
+		dw->pixbuf_ptr = static_cast<pixel_argb_t*>(std::calloc(static_cast<std::size_t>(sz.width) * sz.height, sizeof(pixel_argb_t)));
+		if (nullptr == dw->pixbuf_ptr)
+			return false;
+
+		dw->bytes_per_line = sz.width * sizeof(pixel_argb_t);
+		dw->pixbuf_size = sz;
+		return true;
+	}
+
+	inline void release(drawable_impl_type* dw)
+	{
+		std::free(dw->pixbuf_ptr);
+		dw->pixbuf_ptr = nullptr;
+	}
+
+	inline pixel_argb_t* row(const drawable_impl_type* dw, int y)
+	{
+		return reinterpret_cast<pixel_argb_t*>(reinterpret_cast<char*>(dw->pixbuf_ptr) + dw->bytes_per_line * y);
+	}
+
+	/// Copies the pixels of src_r to the position of destination, the area is clipped by the both buffers.
+	/// The source and destination may be the same buffer.
+	inline void blit(pixel_argb_t* dst, std::size_t dst_bytes_per_line, const nana::size& dst_size, const nana::point& dst_pos,
+					const pixel_argb_t* src, std::size_t src_bytes_per_line, const nana::size& src_size, const nana::rectangle& src_r)
+	{
+		nana::rectangle s_r, d_r;
+		if (!::nana::overlap(src_r, src_size, nana::rectangle{ dst_pos, src_r.dimension() }, dst_size, s_r, d_r))
+			return;
+
+		auto s = reinterpret_cast<const char*>(src + s_r.x) + src_bytes_per_line * s_r.y;
+		auto d = reinterpret_cast<char*>(dst + d_r.x) + dst_bytes_per_line * d_r.y;
+		const auto bytes = sizeof(pixel_argb_t) * s_r.width;
+
+		if ((s < d) && (reinterpret_cast<const char*>(src) == reinterpret_cast<const char*>(dst)))
+		{
+			//Copies the rows from bottom to top if the destination is overlapped below the source.
+			s += src_bytes_per_line * (s_r.height - 1);
+			d += dst_bytes_per_line * (s_r.height - 1);
+			for (unsigned i = 0; i < s_r.height; ++i)
+			{
+				std::memmove(d, s, bytes);
+				s -= src_bytes_per_line;
+				d -= dst_bytes_per_line;
+			}
+			return;
+		}
+
+		for (unsigned i = 0; i < s_r.height; ++i)
+		{
+			std::memmove(d, s, bytes);
+			s += src_bytes_per_line;
+			d += dst_bytes_per_line;
+		}
+	}
+
+	inline void copy(drawable_impl_type* dst, const nana::point& dst_pos, const drawable_impl_type* src, const nana::rectangle& src_r)
+	{
+		blit(dst->pixbuf_ptr, dst->bytes_per_line, dst->pixbuf_size, dst_pos, src->pixbuf_ptr, src->bytes_per_line, src->pixbuf_size, src_r);
+	}
+
+	inline void fill(drawable_impl_type* dw, const nana::rectangle& r, unsigned rgb)
+	{
+		nana::rectangle good_r;
+		if (!::nana::overlap(nana::rectangle{ dw->pixbuf_size }, r, good_r))
+			return;
+
+		for (int y = good_r.y; y < good_r.bottom(); ++y)
+		{
+			for (auto p = row(dw, y) + good_r.x, end = p + good_r.width; p != end; ++p)
+				p->value = rgb;
+		}
+	}
+
+	inline void set_pixel(drawable_impl_type* dw, int x, int y, unsigned rgb)
+	{
+		if (0 <= x && x < static_cast<int>(dw->pixbuf_size.width) && 0 <= y && y < static_cast<int>(dw->pixbuf_size.height))
+			row(dw, y)[x].value = rgb;
+	}
+
+	/// Draws a line including the both end points, like XDrawLine does.
+	inline void line(drawable_impl_type* dw, const nana::point& pos_beg, const nana::point& pos_end, unsigned rgb)
+	{
+		if (pos_beg.y == pos_end.y)
+		{
+			auto x = (std::min)(pos_beg.x, pos_end.x);
+			fill(dw, nana::rectangle{ x, pos_beg.y, static_cast<unsigned>((std::max)(pos_beg.x, pos_end.x) - x + 1), 1 }, rgb);
+			return;
+		}
+		else if (pos_beg.x == pos_end.x)
+		{
+			auto y = (std::min)(pos_beg.y, pos_end.y);
+			fill(dw, nana::rectangle{ pos_beg.x, y, 1, static_cast<unsigned>((std::max)(pos_beg.y, pos_end.y) - y + 1) }, rgb);
+			return;
+		}
+
+		//Bresenham
+		int x = pos_beg.x, y = pos_beg.y;
+		const int dx = std::abs(pos_end.x - x), sx = (x < pos_end.x ? 1 : -1);
+		const int dy = -std::abs(pos_end.y - y), sy = (y < pos_end.y ? 1 : -1);
+		int err = dx + dy;
+		while (true)
+		{
+			set_pixel(dw, x, y, rgb);
+			if (x == pos_end.x && y == pos_end.y)
+				break;
+
+			const int e2 = err * 2;
+			if (e2 >= dy)
+			{
+				err += dy;
+				x += sx;
+			}
+			if (e2 <= dx)
+			{
+				err += dx;
+				y += sy;
+			}
+		}
+	}
+
+	/// Draws the outline of a rectangle, the size of outline is (width + 1, height + 1) like XDrawRectangle.
+	inline void frame(drawable_impl_type* dw, const nana::rectangle& r, unsigned rgb)
+	{
+		const int right = r.x + static_cast<int>(r.width);
+		const int bottom = r.y + static_cast<int>(r.height);
+		line(dw, { r.x, r.y }, { right, r.y }, rgb);
+		line(dw, { r.x, bottom }, { right, bottom }, rgb);
+		line(dw, { r.x, r.y }, { r.x, bottom }, rgb);
+		line(dw, { right, r.y }, { right, bottom }, rgb);
+	}
+}//end namespace headless
+}//end namespace detail
+}//end namespace nana
+
+#endif
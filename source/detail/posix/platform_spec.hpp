@@ -67,8 +67,13 @@ namespace detail
 	{
 		using font_type = ::std::shared_ptr<font_interface>;
 
-		Pixmap	pixmap;
-		GC	context;
+		Pixmap	pixmap{0};
+		GC	context{nullptr};
+
+		//The memory surface of the drawable, it replaces the pixmap when the platform_spec is headless.
+		pixel_argb_t*	pixbuf_ptr{nullptr};
+		std::size_t		bytes_per_line{0};
+		nana::size		pixbuf_size;
 
 		font_type font;
 
@@ -197,6 +202,14 @@ namespace detail
 		Display* open_display();
 		void close_display();
 
+		/// Returns true if nana renders without a X server.
+		/**
+		 * The headless mode is enabled by defining NANA_HEADLESS, by the environment variable
+		 * NANA_HEADLESS, or if the X display can't be opened. In this mode, graphics is backed by
+		 * a memory surface and the text is rasterized by FreeType, the windows are unavailable.
+		 */
+		bool headless() const;
+
 		void lock_xlib();
 		void unlock_xlib();
 
@@ -260,6 +273,7 @@ namespace detail
 		void _m_caret_routine();
 	private:
 		Display*	display_;
+		bool		headless_;
 		Colormap	colormap_;
 		atombase_tag atombase_;
 
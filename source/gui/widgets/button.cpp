@@ -224,9 +224,9 @@ namespace nana{	namespace drawerbase
 			wchar_t shortkey;
 			std::string::size_type shortkey_pos;
 			std::string mbstr = API::transform_shortkey_text(wdg_->caption(), shortkey, &shortkey_pos);
-			std::wstring str = to_wstring(mbstr);
+			utf::scratch_wstring str{ mbstr };
 
-			nana::size ts = graph.text_extent_size(str);
+			nana::size ts = graph.text_extent_size(str.str());
 			nana::size gsize = graph.size();
 
 			nana::size icon_sz;
@@ -245,7 +245,7 @@ namespace nana{	namespace drawerbase
 
 			unsigned omitted_pixels = gsize.width - icon_sz.width;
 			std::size_t txtlen = str.size();
-			const auto txtptr = str.c_str();
+			const auto txtptr = str.data();
 			if(ts.width)
 			{
 				nana::paint::text_renderer tr(graph);
@@ -22,8 +22,18 @@
 #include <list>
 #include <deque>
 #include <stdexcept>
+#include <new>
 #include <map>
+#include <unordered_map>
 #include <iostream>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <exception>
+#include <locale>
+#include <thread>
+#include <cctype>
+#include <cstdlib>
 
 #include <nana/gui/widgets/listbox.hpp>
 #include <nana/gui/widgets/panel.hpp>	//for inline widget
@@ -33,6 +43,9 @@
 #include <nana/paint/text_renderer.hpp>
 #include <nana/system/dataexch.hpp>
 #include <nana/system/platform.hpp>
+#include <nana/gui/timer.hpp>
+#include <nana/threads/pool.hpp>
+#include <nana/gui/widgets/skeletons/text_matcher.hpp>
 #include "skeletons/content_view.hpp"
 
 namespace nana
@@ -68,6 +81,150 @@ namespace nana
 				model_interface* const model_ptr_;
 			};
 
+			/// The model of a virtual category. The rows are not stored, they are fetched from the application
+			/// on demand and the recently fetched rows are kept in a LRU cache.
+			class virtual_model_container
+				: public model_interface, public container_interface
+			{
+				using cache_list = std::list<std::pair<std::size_t, std::vector<cell>>>;
+			public:
+				virtual_model_container(std::size_t rows, virtual_fetcher fetcher, std::size_t cache_rows)
+					: rows_(rows), fetcher_(std::move(fetcher)), cache_rows_(cache_rows ? cache_rows : 1)
+				{
+				}
+
+				void resize(std::size_t rows)
+				{
+					rows_ = rows;
+					invalidate();
+				}
+
+				void invalidate() noexcept
+				{
+					cache_.clear();
+					index_.clear();
+				}
+
+				/// Fetches a row bypassing the cache, it is used for scanning all the rows.
+				void fetch(std::size_t row, std::vector<cell>& cells) const
+				{
+					cells.clear();
+					fetcher_(row, cells);
+				}
+
+				const std::vector<cell>& cached(std::size_t row) const
+				{
+					check_range(row, rows_);
+
+					auto i = index_.find(row);
+					if (i != index_.end())
+					{
+						//Moves the row to the front, it becomes the most recently used one.
+						cache_.splice(cache_.begin(), cache_, i->second);
+						return i->second->second;
+					}
+
+					if (cache_.size() < cache_rows_)
+						cache_.emplace_front();
+					else
+					{
+						//Reuses the least recently used row.
+						index_.erase(cache_.back().first);
+						cache_.splice(cache_.begin(), cache_, std::prev(cache_.end()));
+					}
+
+					try
+					{
+						fetch(row, cache_.front().second);
+					}
+					catch (...)
+					{
+						cache_.pop_front();
+						throw;
+					}
+
+					cache_.front().first = row;
+					index_[row] = cache_.begin();
+					return cache_.front().second;
+				}
+			private:
+				//Implementation of model_interface. The rows are fetched in the GUI thread, it is not necessary to lock.
+				void lock() override {}
+				void unlock() override {}
+
+				container_interface* container() noexcept override
+				{
+					return this;
+				}
+
+				const container_interface* container() const noexcept override
+				{
+					return this;
+				}
+
+				//Implementation of container_interface
+				void clear() override
+				{
+					throw std::runtime_error("nana::listbox disallow to remove items because of virtual model");
+				}
+
+				void erase(std::size_t /*pos*/) override
+				{
+					throw std::runtime_error("nana::listbox disallow to remove items because of virtual model");
+				}
+
+				std::size_t size() const override
+				{
+					return rows_;
+				}
+
+				bool immutable() const override
+				{
+					return true;
+				}
+
+				void emplace(std::size_t /*pos*/) override
+				{
+					throw std::runtime_error("nana::listbox disallow to insert items because of virtual model");
+				}
+
+				void emplace_back() override
+				{
+					throw std::runtime_error("nana::listbox disallow to insert items because of virtual model");
+				}
+
+				void assign(std::size_t /*pos*/, const std::vector<cell>& /*cells*/) override
+				{
+					throw std::runtime_error("nana::listbox disallow to modify items because of virtual model");
+				}
+
+				std::vector<cell> to_cells(std::size_t pos) const override
+				{
+					return cached(pos);
+				}
+
+				bool push_back(const const_virtual_pointer& /*dptr*/) override
+				{
+					throw std::runtime_error("nana::listbox disallow to insert items because of virtual model");
+				}
+
+				void* pointer() override
+				{
+					return nullptr;
+				}
+
+				const void* pointer() const override
+				{
+					return nullptr;
+				}
+			private:
+				std::size_t rows_;
+				virtual_fetcher fetcher_;
+				const std::size_t cache_rows_;
+				mutable cache_list cache_;
+				mutable std::unordered_map<std::size_t, cache_list::iterator> index_;
+			};
+
 
 			//struct cell
 				cell::format::format(const ::nana::color& bgcolor, const ::nana::color& fgcolor) noexcept
@@ -144,6 +301,8 @@ namespace nana
 					std::function<bool(const std::string&,  nana::any*,
 							           const std::string&,  nana::any*,        bool reverse)> weak_ordering;
 
+					sort_key key_kind{ sort_key::text };	///< The kind of keys if weak_ordering is empty
+
 					std::shared_ptr<paint::font> font;	///< The exclusive column font
 					
 					column(const column&) = default;
@@ -159,6 +318,7 @@ namespace nana
 							index = other.index;
 							alignment = other.alignment;
 							weak_ordering = other.weak_ordering;
+							key_kind = other.key_kind;
 							font = other.font;
 						}
 						return *this;
@@ -173,6 +333,7 @@ namespace nana
 						index(other.index),
 						alignment(other.alignment),
 						weak_ordering(std::move(other.weak_ordering)),
+						key_kind(other.key_kind),
 						font(std::move(other.font)),
 						ess_(other.ess_)
 					{
@@ -618,9 +779,9 @@ namespace nana
 				paint::image img;
 				nana::size img_show_size;
 
+				/// The selection is kept by the category as ranges.
 				struct inner_flags
 				{
-					bool selected	:1;
 					bool checked	:1;
 				}flags;
 
@@ -628,7 +789,7 @@ namespace nana
 
 				item_data() noexcept
 				{
-					flags.selected = flags.checked = false;
+					flags.checked = false;
 				}
 
 				item_data(const item_data& r)
@@ -643,13 +804,13 @@ namespace nana
 				item_data(container&& cont)
 					: cells(std::make_unique<container>(std::move(cont)))
 				{
-					flags.selected = flags.checked = false;
+					flags.checked = false;
 				}
 
 				item_data(std::string&& s)
 					: cells(std::make_unique<container>())
 				{
-					flags.selected = flags.checked = false;
+					flags.checked = false;
 					cells->emplace_back(std::move(s));
 				}
 
@@ -692,277 +853,1195 @@ namespace nana
 
 			class inline_indicator;
 
-			struct category_t
+			/// A set of absolute positions, it is stored as the ordered and disjoint ranges [first, last).
+			class interval_set
 			{
-				using container = std::deque<item_data>;
-
-				native_string_type text;
-				std::vector<std::size_t> sorted;
-				container items;
-
-				std::unique_ptr<model_interface> model_ptr;
+			public:
+				using range = std::pair<std::size_t, std::size_t>;
 
-				bool expand{ true };
-				bool display_number{ true };
+				interval_set() = default;
 
-				//A cat may have a key object to identify the category
-				std::shared_ptr<nana::detail::key_interface> key_ptr;
+				interval_set(std::size_t first, std::size_t last)
+				{
+					_m_push(first, last);
+				}
 
-				std::deque<pat::cloneable<pat::abstract_factory<inline_notifier_interface>>> factories;
-				std::deque<std::unique_ptr<inline_indicator>> indicators;
+				/// Makes a set from the disjoint ranges in any order
+				static interval_set from_ranges(std::vector<range> ranges)
+				{
+					std::sort(ranges.begin(), ranges.end());
 
-				category_t(native_string_type str = {}) noexcept
-					:text(std::move(str))
-				{}
+					interval_set result;
+					for (auto & r : ranges)
+						result._m_push(r.first, r.second);
+					return result;
+				}
 
-				bool selected() const noexcept
+				/// Makes a set whose positions p satisfy op(a.contains(p), b.contains(p)), it visits the boundaries of both sets in order.
+				template<typename Operation>
+				static interval_set combine(const interval_set& a, const interval_set& b, Operation op)
 				{
-					for (auto & m : items)
+					const auto a_end = a.ranges_.size() * 2;
+					const auto b_end = b.ranges_.size() * 2;
+
+					interval_set result;
+					std::size_t ia = 0, ib = 0, first = 0;
+					bool inside = false;
+					while (ia < a_end || ib < b_end)
 					{
-						if (false == m.flags.selected)
-							return false;
+						const auto pos = ((ib == b_end || (ia < a_end && a._m_bound(ia) <= b._m_bound(ib))) ? a._m_bound(ia) : b._m_bound(ib));
+
+						while (ia < a_end && a._m_bound(ia) == pos)
+							++ia;
+
+						while (ib < b_end && b._m_bound(ib) == pos)
+							++ib;
+
+						//An odd number of visited boundaries indicates the position is contained by the set.
+						const bool now = op((ia & 1) != 0, (ib & 1) != 0);
+						if (now != inside)
+						{
+							if (now)
+								first = pos;
+							else
+								result._m_push(first, pos);
+
+							inside = now;
+						}
 					}
-					return !items.empty();
+					return result;
 				}
 
-				void make_sort_order()
+				static interval_set unite(const interval_set& a, const interval_set& b)
 				{
-					sorted.clear();
-					for (std::size_t i = 0; i < items.size(); ++i)
-						sorted.push_back(i);
+					return combine(a, b, [](bool x, bool y){ return x || y; });
 				}
-				
-				std::vector<cell> cells(size_type pos) const
-				{
-					if (model_ptr)
-						return model_ptr->container()->to_cells(pos);
 
-					return *(items.at(pos).cells);
+				static interval_set subtract(const interval_set& a, const interval_set& b)
+				{
+					return combine(a, b, [](bool x, bool y){ return x && !y; });
 				}
-			};
-
-			struct inline_pane
-			{
-				::nana::panel<false> pane_bottom;	//pane for pane_widget
-				::nana::panel<false> pane_widget;	//pane for placing user-define widget
-				std::unique_ptr<inline_notifier_interface> inline_ptr;
-				inline_indicator * indicator;
-				index_pair	item_pos;				//The item index of the inline widget
-				std::size_t	column_pos;
-			};
-
-			enum class view_action
-			{
-				auto_view,
-				top_view,
-				bottom_view,
-			};
 
-			class es_lister
-			{
-			public:
-				using container = std::list<category_t>;
-				using item_type = item_data;
+				bool empty() const noexcept
+				{
+					return ranges_.empty();
+				}
 
-				std::function<std::function<bool(const ::std::string&, ::nana::any*,
-								const ::std::string&, ::nana::any*, bool reverse)>(std::size_t) > fetch_ordering_comparer;
+				const std::vector<range>& ranges() const noexcept
+				{
+					return ranges_;
+				}
 
-				struct sort_attributes
+				bool contains(std::size_t pos) const noexcept
 				{
-					std::size_t	column;		///< The position of the column to be sorted
-					bool		resort;
-					bool		reverse;	
-				};
+					return covers(pos, pos + 1);
+				}
 
-				es_lister()
+				/// Determines whether the range [first, last) is entirely contained, an empty range is always contained.
+				bool covers(std::size_t first, std::size_t last) const noexcept
 				{
-					//#0 is a default category
-					categories_.emplace_back();
+					if (first >= last)
+						return true;
 
-					sort_attrs_.column = npos;
-					sort_attrs_.resort = true;
-					sort_attrs_.reverse = false;
+					//The range which begins at or before first. The adjacent ranges are merged, so the range should contain all.
+					auto i = std::upper_bound(ranges_.cbegin(), ranges_.cend(), first, [](std::size_t pos, const range& r){
+						return pos < r.first;
+					});
+					return (i != ranges_.cbegin()) && (last <= (i - 1)->second);
 				}
 
-				void bind(essence* ess, widget& wd) noexcept
+				void clear() noexcept
 				{
-					ess_ = ess;
-					widget_ = dynamic_cast<nana::listbox*>(&wd);
+					ranges_.clear();
 				}
 
-				nana::listbox* wd_ptr() const noexcept
+				void swap(interval_set& other) noexcept
 				{
-					return widget_;
+					ranges_.swap(other.ranges_);
 				}
 
-				nana::any * anyobj(const index_pair& id, bool allocate_if_empty) const
+				/// Shifts the positions behind an inserted item, the inserted item is not contained.
+				void shift_insert(std::size_t pos)
 				{
-					auto& catobj = *get(id.cat);
-					if(id.item < catobj.items.size())
+					std::vector<range> ranges;
+					for (auto & r : ranges_)
 					{
-						auto& item = catobj.items[id.item];
-
-						if(item.anyobj)
-							return item.anyobj.get();
-
-						if (allocate_if_empty)
+						if (r.second <= pos)
+							ranges.push_back(r);
+						else if (pos <= r.first)
+							ranges.emplace_back(r.first + 1, r.second + 1);
+						else
 						{
-							item.anyobj.reset(new ::nana::any);
-							return item.anyobj.get();
+							ranges.emplace_back(r.first, pos);
+							ranges.emplace_back(pos + 1, r.second + 1);
 						}
 					}
-					return nullptr;
+					ranges_.swap(ranges);
 				}
 
-                std::string to_string(const export_options& exp_opt) const;
-
-				void emit_cs(const index_pair& pos, bool for_selection)
+				/// Shifts the positions behind an erased item
+				void shift_erase(std::size_t pos)
 				{
-					item_proxy item(ess_, pos);
-					arg_listbox arg{ item };
-
-					auto & events = wd_ptr()->events();
-					
-					if (for_selection)
-						events.selected.emit(arg, wd_ptr()->handle());
-					else
-						events.checked.emit(arg, wd_ptr()->handle());
-
-					//notify the inline pane. An item may have multiple panes, each pane is for a column.
-					for (auto p : active_panes_)
+					auto ranges = std::move(ranges_);
+					ranges_.clear();
+					for (auto & r : ranges)
 					{
-						if (p && (p->item_pos == pos))
-						{
-							if (for_selection)
-								p->inline_ptr->notify_status(inline_widget_status::selecting, item.selected());
-							else
-								p->inline_ptr->notify_status(inline_widget_status::checking, item.checked());
-						}
+						if (r.second <= pos)
+							_m_push(r.first, r.second);
+						else if (pos < r.first)
+							_m_push(r.first - 1, r.second - 1);
+						else
+							_m_push(r.first, r.second - 1);
 					}
 				}
 
-				// Definition is provided after struct essence
-				unsigned column_content_pixels(size_type pos) const;
+				/// Removes the positions which are not less than size
+				void truncate(std::size_t size)
+				{
+					while (!ranges_.empty() && ranges_.back().first >= size)
+						ranges_.pop_back();
 
-				const sort_attributes& sort_attrs() const noexcept
+					if (!ranges_.empty() && ranges_.back().second > size)
+						ranges_.back().second = size;
+				}
+			private:
+				std::size_t _m_bound(std::size_t n) const noexcept
 				{
-					return sort_attrs_;
+					return ((n & 1) ? ranges_[n / 2].second : ranges_[n / 2].first);
 				}
 
-                /// each sort() invalidates any existing reference from display position to absolute item, that is after sort() display offset point to different items
-                void sort()
+				void _m_push(std::size_t first, std::size_t last)
 				{
-					if((npos == sort_attrs_.column) || (!sort_attrs_.resort))
+					if (first >= last)
 						return;
 
-					auto weak_ordering_comp = fetch_ordering_comparer(sort_attrs_.column);
-					if(weak_ordering_comp)
-					{
-						for (auto & cat : categories_)
-						{
-							const bool use_model = (cat.model_ptr != nullptr);
+					//The adjacent ranges are merged
+					if (!ranges_.empty() && ranges_.back().second >= first)
+						ranges_.back().second = (std::max)(ranges_.back().second, last);
+					else
+						ranges_.emplace_back(first, last);
+				}
+			private:
+				std::vector<range> ranges_;
+			};
 
-							std::stable_sort(cat.sorted.begin(), cat.sorted.end(), [&cat, &weak_ordering_comp, use_model, this](std::size_t x, std::size_t y){
-								//The predicate must be a strict weak ordering.
-								//!comp(x, y) != comp(x, y)
-								if (use_model)
-								{
-									auto & mx = cat.items[x];
-									auto & my = cat.items[y];
+			class category_index;
 
-									auto mx_cells = cat.model_ptr->container()->to_cells(x);
-									auto my_cells = cat.model_ptr->container()->to_cells(y);
+			struct category_t
+			{
+				using container = std::deque<item_data>;
 
-									if (mx_cells.size() <= sort_attrs_.column || my_cells.size() <= sort_attrs_.column)
-									{
-										std::string a;
-										if (mx_cells.size() > sort_attrs_.column)
-											a = mx_cells[sort_attrs_.column].text;
+				native_string_type text;
+				std::vector<std::size_t> sorted;
+				container items;
 
-										std::string b;
-										if (my_cells.size() > sort_attrs_.column)
-											b = my_cells[sort_attrs_.column].text;
+				interval_set selection;	//The absolute positions of the selected items
 
-										return weak_ordering_comp(a, mx.anyobj.get(), b, my.anyobj.get(), sort_attrs_.reverse);
-									}
+				std::unique_ptr<model_interface> model_ptr;
 
-									return weak_ordering_comp(mx_cells[sort_attrs_.column].text, mx.anyobj.get(), my_cells[sort_attrs_.column].text, my.anyobj.get(), sort_attrs_.reverse);
-								}
-								
-								auto & mx = cat.items[x];
-								auto & my = cat.items[y];
+				bool expand{ true };
+				bool display_number{ true };
 
-								if (mx.cells->size() <= sort_attrs_.column || my.cells->size() <= sort_attrs_.column)
-								{
-									std::string a;
-									if (mx.cells->size() > sort_attrs_.column)
-										a = (*mx.cells)[sort_attrs_.column].text;
+				//A cat may have a key object to identify the category
+				std::shared_ptr<nana::detail::key_interface> key_ptr;
 
-									std::string b;
-									if (my.cells->size() > sort_attrs_.column)
-										b = (*my.cells)[sort_attrs_.column].text;
+				std::deque<pat::cloneable<pat::abstract_factory<inline_notifier_interface>>> factories;
+				std::deque<std::unique_ptr<inline_indicator>> indicators;
 
-									return weak_ordering_comp(a, mx.anyobj.get(), b, my.anyobj.get(), sort_attrs_.reverse);
-								}
+				/// The rows of a virtual category are not stored in items, only their states are kept.
+				struct virtual_rows
+				{
+					virtual_model_container* model;						//It refers to the object owned by model_ptr
+					std::vector<item_data::inner_flags> flags;
+					std::map<std::size_t, item_data> attributes;	//The rows which are given colors, an image or a value
+				};
 
-								return weak_ordering_comp((*mx.cells)[sort_attrs_.column].text, mx.anyobj.get(), (*my.cells)[sort_attrs_.column].text, my.anyobj.get(), sort_attrs_.reverse);
-							});
-						}
-					}
-					else
-					{	//No user-defined comparer is provided, and default comparer is applying.
-						for (auto & cat : categories_)
-						{
-							const bool use_model = (cat.model_ptr != nullptr);
+				std::unique_ptr<virtual_rows> virt;
 
-							std::stable_sort(cat.sorted.begin(), cat.sorted.end(), [this, &cat, use_model](std::size_t x, std::size_t y){
-								//The predicate must be a strict weak ordering.
-								//!comp(x, y) != comp(x, y)
-								if (use_model)
-								{
-									auto mx_cells = cat.model_ptr->container()->to_cells(x);
-									auto my_cells = cat.model_ptr->container()->to_cells(y);
+				/// The result of the filter, it is only available when the listbox is filtered.
+				struct filter_state
+				{
+					std::vector<bool> matched;			//Indexed by absolute position
+					std::vector<std::size_t> display;	//The matched items in the order of sorted
+				};
 
-									if (mx_cells.size() <= sort_attrs_.column || my_cells.size() <= sort_attrs_.column)
-									{
-										std::string a;
-										if (mx_cells.size() > sort_attrs_.column)
-											a = mx_cells[sort_attrs_.column].text;
+				std::unique_ptr<filter_state> filter;
 
-										std::string b;
-										if (my_cells.size() > sort_attrs_.column)
-											b = my_cells[sort_attrs_.column].text;
+				/// The pixels of the cell texts which are measured by fit_content, indexed by column and absolute position.
+				/// The items of a model category are not cached except the virtual one, because the model can be changed by model_guard.
+				std::vector<std::vector<unsigned>> widths;
 
-										return (sort_attrs_.reverse ? a > b : a < b);
-									}
+				static constexpr unsigned unmeasured = static_cast<unsigned>(-1);
 
-									auto & a = mx_cells[sort_attrs_.column].text;
-									auto & b = my_cells[sort_attrs_.column].text;
-									return (sort_attrs_.reverse ? a > b : a < b);
-								}
+				std::size_t modifications{ 0 };	//Counts the changes of items, it is increased by modified()
 
-								auto & mx = cat.items[x];
-								auto & my = cat.items[y];
+				/// The index which the category belongs to, and the position of the category in the index.
+				category_index* index{ nullptr };
+				std::size_t index_pos{ 0 };
 
-								if (mx.cells->size() <= sort_attrs_.column || my.cells->size() <= sort_attrs_.column)
-								{
-									std::string a;
-									if (mx.cells->size() > sort_attrs_.column)
-										a = (*mx.cells)[sort_attrs_.column].text;
+				category_t(native_string_type str = {}) noexcept
+					:text(std::move(str))
+				{}
 
-									std::string b;
-									if (my.cells->size() > sort_attrs_.column)
-										b = (*my.cells)[sort_attrs_.column].text;
+				std::size_t size() const noexcept
+				{
+					return (virt ? virt->flags.size() : items.size());
+				}
 
-									return (sort_attrs_.reverse ? a > b : a < b);
-								}
+				item_data::inner_flags& flags(std::size_t pos)
+				{
+					return (virt ? virt->flags.at(pos) : items.at(pos).flags);
+				}
+
+				item_data::inner_flags flags(std::size_t pos) const
+				{
+					return (virt ? virt->flags.at(pos) : items.at(pos).flags);
+				}
+
+				/// Returns the item at the absolute position, the item of a virtual row is created when it is accessed first time.
+				item_data& item(std::size_t pos)
+				{
+					if (virt)
+					{
+						check_range(pos, virt->flags.size());
+						return virt->attributes[pos];
+					}
+					return items.at(pos);
+				}
+
+				/// Returns the item for reading, the virtual rows which are never accessed share an empty item.
+				const item_data& item_view(std::size_t pos) const
+				{
+					if (virt)
+					{
+						check_range(pos, virt->flags.size());
+
+						auto i = virt->attributes.find(pos);
+						if (i != virt->attributes.end())
+							return i->second;
+
+						static const item_data empty;
+						return empty;
+					}
+					return items.at(pos);
+				}
+
+				bool selected() const noexcept
+				{
+					return (size() != 0) && selection.covers(0, size());
+				}
+
+				bool is_selected(std::size_t pos) const noexcept
+				{
+					return selection.contains(pos);
+				}
+
+				bool caches_widths() const noexcept
+				{
+					return (virt || !model_ptr);
+				}
+
+				/// Counts the changes of the cells, insertions and erasures, so that a background sorting or filtering
+				/// which is made before a change is discarded.
+				void modified() noexcept
+				{
+					++modifications;
+				}
+
+				/// Discards the measured pixels of the item at the absolute position, it is called when the cells are changed.
+				void discard_width(std::size_t pos) noexcept
+				{
+					for (auto & col : widths)
+					{
+						if (pos < col.size())
+							col[pos] = unmeasured;
+					}
+				}
+
+				/// Keeps the measured pixels in step with the items when an item is inserted or erased at the absolute position.
+				void shift_widths(std::size_t pos, bool inserted)
+				{
+					for (auto & col : widths)
+					{
+						if (pos >= col.size())
+							continue;
+
+						if (inserted)
+							col.insert(col.begin() + pos, unmeasured);
+						else
+							col.erase(col.begin() + pos);
+					}
+				}
+
+				void make_sort_order()
+				{
+					sorted.resize(size());
+					for (std::size_t i = 0; i < sorted.size(); ++i)
+						sorted[i] = i;
+
+					make_display_order();
+				}
+
+				/// Rebuilds the display order of the filtered items after the sorted order is changed.
+				void make_display_order()
+				{
+					if (filter)
+					{
+						auto & matched = filter->matched;
+						filter->display.clear();
+						for (auto pos : sorted)
+						{
+							if (pos < matched.size() && matched[pos])
+								filter->display.push_back(pos);
+						}
+					}
+					rows_changed();
+				}
+
+				/// Returns the order of the displayed items, its elements are absolute positions.
+				const std::vector<std::size_t>& display_order() const noexcept
+				{
+					return (filter ? filter->display : sorted);
+				}
+
+				std::size_t display_size() const noexcept
+				{
+					return display_order().size();
+				}
+
+				/// Notifies the index that the number of displayed items is changed, or the category is expanded/collapsed.
+				/// Definition is provided after class category_index
+				void rows_changed();
+				
+				std::vector<cell> cells(size_type pos) const
+				{
+					if (model_ptr)
+						return model_ptr->container()->to_cells(pos);
+
+					return *(items.at(pos).cells);
+				}
+			};
+
+			/// Indexes the categories by their positions, and sums the rows of the categories by a Fenwick tree, so that
+			/// a category is accessed in constant time and a display position is translated in logarithmic time.
+			/**
+			 * A category occupies a row for its title, and the rows of its displayed items if it is expanded. The title of
+			 * the first category is counted, although it is not displayed.
+			 */
+			class category_index
+			{
+			public:
+				using container = std::list<category_t>;
+
+				category_index(container& cats) noexcept
+					: cats_(cats)
+				{}
+
+				/// Rebuilds the index when it is accessed next time, it is called when a category is inserted or erased.
+				void invalidate() noexcept
+				{
+					stale_ = true;
+				}
+
+				container::iterator at(std::size_t pos)
+				{
+					_m_build();
+					return iterators_[pos];
+				}
+
+				/// Updates the rows of a category, it is called when the category is expanded, collapsed, or its displayed items are changed.
+				void update(std::size_t pos)
+				{
+					if (stale_)
+						return;
+
+					const auto rows = _m_rows(*iterators_[pos]);
+
+					//The difference is added in modular arithmetic, the sums are correct although it is negative.
+					const auto diff = rows - rows_[pos];
+					rows_[pos] = rows;
+
+					for (auto i = pos + 1; i <= tree_.size(); i += (i & (~i + 1)))
+						tree_[i - 1] += diff;
+				}
+
+				/// Returns the sum of the rows of the categories before the specified one.
+				std::size_t rows_before(std::size_t pos)
+				{
+					_m_build();
+
+					std::size_t sum = 0;
+					for (; pos; pos &= pos - 1)
+						sum += tree_[pos - 1];
+					return sum;
+				}
+
+				/// Returns the sum of the rows of all categories.
+				std::size_t rows()
+				{
+					return rows_before(cats_.size());
+				}
+
+				/// Finds the category which the row belongs to.
+				/**
+				 * @param row The row to be located, it is replaced with the offset of the row in the category.
+				 * @return The position of the category, it is the number of categories if the row is out of range.
+				 */
+				std::size_t locate(std::size_t& row)
+				{
+					_m_build();
+
+					std::size_t pos = 0;
+					for (auto step = top_; step; step >>= 1)
+					{
+						if ((pos + step <= tree_.size()) && (tree_[pos + step - 1] <= row))
+						{
+							pos += step;
+							row -= tree_[pos - 1];
+						}
+					}
+					return pos;
+				}
+			private:
+				static std::size_t _m_rows(const category_t& cat) noexcept
+				{
+					return 1 + (cat.expand ? cat.display_size() : 0);
+				}
+
+				void _m_build()
+				{
+					if (!stale_)
+						return;
+
+					iterators_.clear();
+					rows_.clear();
+					for (auto i = cats_.begin(); i != cats_.end(); ++i)
+					{
+						i->index = this;
+						i->index_pos = iterators_.size();
+
+						iterators_.push_back(i);
+						rows_.push_back(_m_rows(*i));
+					}
+
+					//Builds the tree in linear time, every node is added to its parent.
+					tree_ = rows_;
+					for (std::size_t i = 1; i <= tree_.size(); ++i)
+					{
+						auto parent = i + (i & (~i + 1));
+						if (parent <= tree_.size())
+							tree_[parent - 1] += tree_[i - 1];
+					}
+
+					top_ = 1;
+					while ((top_ << 1) <= tree_.size())
+						top_ <<= 1;
+
+					stale_ = false;
+				}
+			private:
+				container& cats_;
+				bool stale_{ true };
+				std::vector<container::iterator> iterators_;
+				std::vector<std::size_t> rows_;		//The rows of each category
+				std::vector<std::size_t> tree_;		//The Fenwick tree of rows_, the node i is stored at i - 1
+				std::size_t top_{ 0 };				//The highest power of 2 which is not greater than the number of categories
+			};
+
+			void category_t::rows_changed()
+			{
+				if (index)
+					index->update(index_pos);
+			}
+
+			struct inline_pane
+			{
+				::nana::panel<false> pane_bottom;	//pane for pane_widget
+				::nana::panel<false> pane_widget;	//pane for placing user-define widget
+				std::unique_ptr<inline_notifier_interface> inline_ptr;
+				inline_indicator * indicator;
+				index_pair	item_pos;				//The item index of the inline widget
+				std::size_t	column_pos;
+			};
+
+			enum class view_action
+			{
+				auto_view,
+				top_view,
+				bottom_view,
+			};
+
+			/// Sorts the items by the keys which are extracted once for every item, rather than fetching the
+			/// texts for every comparison. The keys of a large category are sorted on the thread pool.
+			class sort_engine
+			{
+			public:
+				using comparer = std::function<bool(const std::string&, nana::any*, const std::string&, nana::any*, bool reverse)>;
+
+				/// The minimal number of items which are sorted by a thread
+				static constexpr std::size_t parallel_threshold = 16384;
+
+				struct key
+				{
+					std::string text;				//The text, or the collation key if the kind is collation
+					double number{ 0 };
+					bool numeric{ false };
+					nana::any* anyobj{ nullptr };	//It is only available for a sort compare
+				};
+
+				/// A sorting of all the categories, it is shared by the listbox and the background thread.
+				struct job
+				{
+					sort_key kind{ sort_key::text };
+					bool reverse{ false };
+					comparer comp;
+
+					std::vector<std::vector<key>> keys;				//The keys of each category, indexed by absolute position
+					std::vector<std::vector<std::size_t>> orders;	//The orders of each category to be sorted
+					std::vector<std::size_t> modifications;			//The modification counts of each category when the job is made
+
+					std::atomic<bool> cancelled{ false };
+					std::atomic<bool> finished{ false };
+					std::exception_ptr error;						//The exception thrown by the background sorting
+
+					std::size_t size() const noexcept
+					{
+						std::size_t n = 0;
+						for (auto & order : orders)
+							n += order.size();
+						return n;
+					}
+				};
+
+				/// Transforms the texts into keys
+				class key_maker
+				{
+				public:
+					key_maker(sort_key kind)
+						: kind_(kind), collate_(sort_key::collation == kind ? &std::use_facet<std::collate<char>>(locale_) : nullptr)
+					{}
+
+					void operator()(key& k, std::string&& text) const
+					{
+						if (collate_)
+						{
+							k.text = collate_->transform(text.data(), text.data() + text.size());
+							return;
+						}
+
+						if (sort_key::numeric == kind_)
+							k.numeric = _m_parse(text, k.number);
+
+						k.text = std::move(text);
+					}
+				private:
+					static bool _m_parse(const std::string& text, double& number)
+					{
+						auto begin = text.c_str();
+						while (std::isspace(static_cast<unsigned char>(*begin)))
+							++begin;
+
+						char* end;
+						number = std::strtod(begin, &end);
+						if (end == begin)
+							return false;
+
+						while (std::isspace(static_cast<unsigned char>(*end)))
+							++end;
+
+						//NaN is not a number for sorting, it breaks the strict weak ordering.
+						return (0 == *end) && (number == number);
+					}
+				private:
+					const sort_key kind_;
+					const std::locale locale_;
+					const std::collate<char>* const collate_;
+				};
+
+				/// Sorts the job, it returns without finishing the job if the job is cancelled.
+				static void run(job& jb)
+				{
+					try
+					{
+						_m_run(jb);
+					}
+					catch (cancellation&)
+					{
+						return;
+					}
+					jb.finished = true;
+				}
+
+				/// Sorts the job in the background, the job is finished even if the sorting throws an exception.
+				/**
+				 * The job is owned by the task, a cancelled job is left to the pool rather than waited for, it
+				 * stops at the next comparison. The pool has one thread, so a new job is started after the
+				 * cancelled one returns.
+				 */
+				static void run_in_background(std::shared_ptr<job> jb)
+				{
+					_m_job_pool().push([jb]
+					{
+						try
+						{
+							run(*jb);
+						}
+						catch (...)
+						{
+							jb->error = std::current_exception();
+							jb->finished = true;
+						}
+					});
+				}
+			private:
+				/// Thrown by the comparison of a cancelled job
+				struct cancellation {};
+
+				static void _m_run(job& jb)
+				{
+					for (std::size_t i = 0; i < jb.orders.size(); ++i)
+					{
+						if (jb.cancelled)
+							throw cancellation{};
+
+						auto & keys = jb.keys[i];
+						auto & order = jb.orders[i];
+						const bool reverse = jb.reverse;
+
+						if (jb.comp)
+						{
+							//The sort compare is called in this thread only, it is not required to be thread-safe.
+							auto & comp = jb.comp;
+							std::stable_sort(order.begin(), order.end(), [&](std::size_t x, std::size_t y){
+								return comp(keys[x].text, keys[x].anyobj, keys[y].text, keys[y].anyobj, reverse);
+							});
+						}
+						else if (sort_key::numeric == jb.kind)
+						{
+							_m_sort(order, [&keys, reverse](std::size_t x, std::size_t y){
+								auto & a = keys[reverse ? y : x];
+								auto & b = keys[reverse ? x : y];
+
+								//The numbers are ahead of the texts which are not numbers.
+								if (a.numeric != b.numeric)
+									return a.numeric;
+
+								return (a.numeric ? a.number < b.number : a.text < b.text);
+							}, jb.cancelled);
+						}
+						else
+						{
+							_m_sort(order, [&keys, reverse](std::size_t x, std::size_t y){
+								return (reverse ? keys[y].text < keys[x].text : keys[x].text < keys[y].text);
+							}, jb.cancelled);
+						}
+					}
+				}
+
+				static threads::pool& _m_pool()
+				{
+					static threads::pool pool;
+					return pool;
+				}
+
+				static threads::pool& _m_job_pool()
+				{
+					//The pool of the chunks is created first, so that it outlives the jobs which use it.
+					_m_pool();
+
+					static threads::pool pool{ 1 };
+					return pool;
+				}
+
+				/// Calls fn(0) ... fn(n - 1) in parallel, the first exception is rethrown after all of them are finished.
+				/**
+				 * The calling thread calls fn(n - 1) and then the ones which are not started by the pool yet, so a task
+				 * which is dropped by the pool or waits for a busy pool doesn't stall the sorting. The latch is shared
+				 * with the tasks, because a task which is called by the calling thread may still be queued in the pool.
+				 */
+				template<typename Function>
+				static void _m_parallel(std::size_t n, Function fn)
+				{
+					struct latch_t
+					{
+						std::mutex mutex;
+						std::condition_variable cond;
+						std::size_t remains;
+						std::exception_ptr error;
+						std::unique_ptr<std::atomic<bool>[]> claimed;
+
+						/// Calls fn(i) if it is not called yet, and counts down even if it throws.
+						void run(Function* fn, std::size_t i)
+						{
+							if (claimed[i].exchange(true))
+								return;
+
+							std::exception_ptr e;
+							try
+							{
+								(*fn)(i);
+							}
+							catch (...)
+							{
+								e = std::current_exception();
+							}
+
+							std::lock_guard<std::mutex> lock(mutex);
+							if (e && !error)
+								error = e;
+
+							if (0 == --remains)
+								cond.notify_one();
+						}
+					};
+
+					auto latch = std::make_shared<latch_t>();
+					latch->remains = n;
+					latch->claimed.reset(new std::atomic<bool>[n]);
+					for (std::size_t i = 0; i < n; ++i)
+						latch->claimed[i] = false;
 
-								auto & a = (*mx.cells)[sort_attrs_.column].text;
-								auto & b = (*my.cells)[sort_attrs_.column].text;
-								return (sort_attrs_.reverse ? a > b : a < b);
+					auto fnptr = &fn;
+					for (std::size_t i = 0; i + 1 < n; ++i)
+					{
+						try
+						{
+							_m_pool().push([latch, fnptr, i]
+							{
+								latch->run(fnptr, i);
 							});
 						}
+						catch (...)
+						{
+							//The task which can't be pushed is called by the calling thread below.
+							break;
+						}
+					}
+
+					for (std::size_t i = n; i > 0; --i)
+						latch->run(fnptr, i - 1);
+
+					std::unique_lock<std::mutex> lock(latch->mutex);
+					latch->cond.wait(lock, [&latch]{ return (0 == latch->remains); });
+
+					if (latch->error)
+						std::rethrow_exception(latch->error);
+				}
+
+				/// A stable sort which sorts the chunks in parallel and then merges them pairwise in parallel.
+				/// Every comparison checks the cancellation, a cancelled sorting throws a cancellation.
+				template<typename Compare>
+				static void _m_sort(std::vector<std::size_t>& order, Compare less, const std::atomic<bool>& cancelled)
+				{
+					auto comp = [&less, &cancelled](std::size_t x, std::size_t y)
+					{
+						if (cancelled.load(std::memory_order_relaxed))
+							throw cancellation{};
+
+						return less(x, y);
+					};
+
+					std::size_t chunks = (std::max)(std::thread::hardware_concurrency(), 1u);
+					chunks = (std::min)(chunks, order.size() / parallel_threshold);
+
+					if (chunks < 2)
+					{
+						std::stable_sort(order.begin(), order.end(), comp);
+						return;
+					}
+
+					std::vector<std::size_t> bounds;
+					for (std::size_t i = 0; i < chunks; ++i)
+						bounds.push_back(order.size() * i / chunks);
+					bounds.push_back(order.size());
+
+					_m_parallel(chunks, [&](std::size_t i){
+						std::stable_sort(order.begin() + bounds[i], order.begin() + bounds[i + 1], comp);
+					});
+
+					std::vector<std::size_t> merged(order.size());
+					while (bounds.size() > 2)
+					{
+						const auto runs = bounds.size() - 1;
+						_m_parallel((runs + 1) / 2, [&](std::size_t i){
+							auto first = order.begin() + bounds[i * 2];
+							auto middle = order.begin() + bounds[i * 2 + 1];
+							auto out = merged.begin() + bounds[i * 2];
+
+							//The odd run at the end is copied.
+							if (i * 2 + 2 > runs)
+								std::copy(first, middle, out);
+							else
+								std::merge(first, middle, middle, order.begin() + bounds[i * 2 + 2], out, comp);
+						});
+
+						order.swap(merged);
+
+						std::vector<std::size_t> next;
+						for (std::size_t i = 0; i < bounds.size(); i += 2)
+							next.push_back(bounds[i]);
+
+						if (next.back() != order.size())
+							next.push_back(order.size());
+
+						bounds.swap(next);
+					}
+				}
+			};
+
+			/// Tests the items against a query. The texts of the items to be tested are copied in the GUI thread,
+			/// then a large listbox is tested in a background thread.
+			class filter_engine
+			{
+			public:
+				/// The minimal number of items which are filtered in a background thread
+				static constexpr std::size_t background_threshold = 16384;
+
+				struct query
+				{
+					filter_predicate pred;	//The substring is ignored if the predicate is specified
+					std::size_t column{ npos };
+					std::string text;
+					bool case_sensitive{ false };
+
+					/// Determines whether the items which are matched by this query are also matched by the other query
+					bool narrows(const query& other) const
+					{
+						if (pred || other.pred || (column != other.column) || (case_sensitive != other.case_sensitive))
+							return false;
+
+						return (npos != widgets::skeletons::basic_text_matcher<char>{ other.text, case_sensitive, false }.find(text));
+					}
+				};
+
+				class tester
+				{
+				public:
+					tester(const query& q)
+						: q_(q)
+					{
+						if (!q.pred)
+							matcher_.reset(new widgets::skeletons::basic_text_matcher<char>{ q.text, q.case_sensitive, false });
+					}
+
+					bool operator()(const std::string& text) const
+					{
+						return (npos != matcher_->find(text));
+					}
+
+					bool operator()(const std::vector<cell>& cells) const
+					{
+						if (q_.pred)
+							return q_.pred(cells);
+
+						return (q_.column < cells.size()) && (*this)(cells[q_.column].text);
+					}
+				private:
+					const query& q_;
+					std::unique_ptr<widgets::skeletons::basic_text_matcher<char>> matcher_;
+				};
+
+				/// A filtering of all the categories, it is shared by the listbox and the background thread.
+				struct job
+				{
+					query q;
+
+					std::vector<std::size_t> sizes;						//The number of items of each category when the job is made
+					std::vector<std::size_t> modifications;				//The modification counts of each category when the job is made
+					std::vector<std::vector<std::size_t>> candidates;	//The absolute positions to be tested
+					std::vector<std::vector<std::string>> texts;		//The texts of candidates if it has no predicate
+					std::vector<std::vector<std::vector<cell>>> rows;	//The cells of candidates if it has a predicate
+					std::vector<std::vector<std::size_t>> results;		//The matched absolute positions
+
+					std::atomic<bool> cancelled{ false };
+					std::atomic<bool> finished{ false };
+
+					std::size_t size() const noexcept
+					{
+						std::size_t n = 0;
+						for (auto & cand : candidates)
+							n += cand.size();
+						return n;
+					}
+				};
+
+				static void run(job& jb)
+				{
+					tester test{ jb.q };
+
+					jb.results.resize(jb.candidates.size());
+					for (std::size_t i = 0; i < jb.candidates.size(); ++i)
+					{
+						auto & cand = jb.candidates[i];
+						auto & result = jb.results[i];
+						for (std::size_t k = 0; k < cand.size(); ++k)
+						{
+							if ((0 == (k & 0x3FF)) && jb.cancelled)
+								return;
+
+							if (jb.q.pred ? test(jb.rows[i][k]) : test(jb.texts[i][k]))
+								result.push_back(cand[k]);
+						}
+					}
+					jb.finished = true;
+				}
+			};
+
+			class es_lister
+			{
+			public:
+				using container = std::list<category_t>;
+				using item_type = item_data;
+
+				std::function<std::function<bool(const ::std::string&, ::nana::any*,
+								const ::std::string&, ::nana::any*, bool reverse)>(std::size_t) > fetch_ordering_comparer;
+
+				std::function<sort_key(std::size_t)> fetch_sort_key;
+
+				struct sort_attributes
+				{
+					std::size_t	column;		///< The position of the column to be sorted
+					bool		resort;
+					bool		reverse;	
+				};
+
+				es_lister()
+				{
+					//#0 is a default category
+					categories_.emplace_back();
+
+					sort_attrs_.column = npos;
+					sort_attrs_.resort = true;
+					sort_attrs_.reverse = false;
+				}
+
+				~es_lister()
+				{
+					_m_cancel_sort();
+					_m_cancel_filter();
+				}
+
+				void bind(essence* ess, widget& wd) noexcept
+				{
+					ess_ = ess;
+					widget_ = dynamic_cast<nana::listbox*>(&wd);
+				}
+
+				nana::listbox* wd_ptr() const noexcept
+				{
+					return widget_;
+				}
+
+				nana::any * anyobj(const index_pair& id, bool allocate_if_empty) const
+				{
+					auto& catobj = *get(id.cat);
+					if(id.item < catobj.size())
+					{
+						//The item of a virtual row is created only if the value is going to be allocated.
+						auto& item = ((allocate_if_empty && catobj.virt) ? catobj.virt->attributes[id.item] : catobj.item_view(id.item));
+
+						if(item.anyobj)
+							return item.anyobj.get();
+
+						if (allocate_if_empty)
+						{
+							item.anyobj.reset(new ::nana::any);
+							return item.anyobj.get();
+						}
 					}
+					return nullptr;
+				}
+
+                std::string to_string(const export_options& exp_opt) const;
+
+				void emit_cs(const index_pair& pos, bool for_selection)
+				{
+					item_proxy item(ess_, pos);
+					arg_listbox arg{ item };
+
+					auto & events = wd_ptr()->events();
+					
+					if (for_selection)
+						events.selected.emit(arg, wd_ptr()->handle());
+					else
+						events.checked.emit(arg, wd_ptr()->handle());
+
+					//notify the inline pane. An item may have multiple panes, each pane is for a column.
+					for (auto p : active_panes_)
+					{
+						if (p && (p->item_pos == pos))
+						{
+							if (for_selection)
+								p->inline_ptr->notify_status(inline_widget_status::selecting, item.selected());
+							else
+								p->inline_ptr->notify_status(inline_widget_status::checking, item.checked());
+						}
+					}
+				}
+
+				/// Returns the max pixels of the cell texts of the specified column.
+				/**
+				 * The measured pixels are cached by the categories. If max_rows is not 0 and the number of items exceeds it,
+				 * only max_rows items are measured: the items of a model category are sampled evenly, because fetching
+				 * them may be expensive, and the items of other categories are picked by the length of their texts.
+				 * Definition is provided after struct essence
+				 */
+				unsigned column_content_pixels(size_type pos, std::size_t max_rows);
+
+				/// Discards all the measured pixels, it is called when the font is changed.
+				void discard_widths() noexcept
+				{
+					for (auto & cat : categories_)
+						cat.widths.clear();
+				}
+
+				const sort_attributes& sort_attrs() const noexcept
+				{
+					return sort_attrs_;
+				}
+
+                /// each sort() invalidates any existing reference from display position to absolute item, that is after sort() display offset point to different items
+                /**
+                 * The keys are extracted in the calling thread. If the background sorting is enabled, a large category is sorted
+                 * in a background thread and the items remain in the previous order until the sorting is finished.
+                 */
+                void sort()
+				{
+					_m_cancel_sort();
+
+					if((npos == sort_attrs_.column) || (!sort_attrs_.resort))
+						return;
+
+					auto jb = _m_make_sort_job();
+					if (async_sort_ && (!jb->comp) && (jb->size() >= sort_engine::parallel_threshold))
+					{
+						_m_sort_in_background(jb);
+						return;
+					}
+
+					sort_engine::run(*jb);
+					_m_apply_sort(*jb);
+				}
+
+				/// Filters the items by a query
+				/**
+				 * Only the displayed items are tested if the query narrows the previous one. The texts are copied in the
+				 * calling thread, a large listbox is tested in a background thread and a new query cancels it.
+				 */
+				void filter(filter_engine::query q, bool narrowing)
+				{
+					_m_cancel_filter();
+
+					const bool refine = filtering_ && (narrowing || q.narrows(filter_query_));
+
+					auto jb = std::make_shared<filter_engine::job>();
+					jb->q = std::move(q);
+
+					std::vector<cell> cells;
+					for (auto & cat : categories_)
+					{
+						jb->sizes.push_back(cat.size());
+						jb->modifications.push_back(cat.modifications);
+						jb->candidates.push_back((refine && cat.filter) ? cat.filter->display : cat.sorted);
+						jb->texts.emplace_back();
+						jb->rows.emplace_back();
+
+						for (auto pos : jb->candidates.back())
+						{
+							if (jb->q.pred)
+							{
+								_m_fetch_cells(cat, pos, cells);
+								jb->rows.back().push_back(std::move(cells));
+							}
+							else
+								jb->texts.back().push_back(_m_fetch_text(cat, pos, jb->q.column, cells));
+						}
+					}
+
+					if (jb->size() >= filter_engine::background_threshold)
+					{
+						_m_filter_in_background(jb);
+						return;
+					}
+
+					filter_engine::run(*jb);
+					_m_apply_filter(*jb);
+					_m_filter_applied();
+				}
+
+				void unfilter()
+				{
+					_m_cancel_filter();
+
+					filtering_ = false;
+					filter_query_ = filter_engine::query{};
+
+					for (auto & cat : categories_)
+					{
+						cat.filter.reset();
+						cat.rows_changed();
+					}
+				}
+
+				bool filtered() const noexcept
+				{
+					return filtering_;
+				}
+
+				/// Updates the cached width, the modification count and the filter state of an item after its cells are changed.
+				void item_changed(category_t& cat, std::size_t pos)
+				{
+					cat.discard_width(pos);
+					cat.modified();
+					_m_filter_changed(cat, pos);
+				}
+
+				/// Tests the items which are appended to the category since last test.
+				/**
+				 * The appended items are expected at the end of sorted order.
+				 */
+				void filter_appended(category_t& cat)
+				{
+					if (!filtering_)
+						return;
+
+					if (!cat.filter)
+						cat.filter.reset(new category_t::filter_state);
+
+					auto & matched = cat.filter->matched;
+					auto & display = cat.filter->display;
+
+					filter_engine::tester test{ filter_query_ };
+
+					std::vector<cell> cells;
+					for (auto pos = matched.size(); pos < cat.size(); ++pos)
+					{
+						_m_fetch_cells(cat, pos, cells);
+						matched.push_back(test(cells));
+						if (matched.back())
+							display.push_back(pos);
+					}
+					cat.rows_changed();
+				}
+
+				/// Tests all the items of the category again
+				void refilter(category_t& cat)
+				{
+					if (cat.filter)
+						cat.filter->matched.clear();
+
+					filter_appended(cat);
+					cat.make_display_order();
+				}
+
+				void async_sort(bool enable)
+				{
+					async_sort_ = enable;
+				}
+
+				bool async_sort() const noexcept
+				{
+					return async_sort_;
 				}
 
 				/// Sorts the specified column
@@ -977,6 +2056,7 @@ namespace nana
 				{
 					if (nana::npos == pos)
 					{
+						_m_cancel_sort();
 						sort_attrs_.column = npos;
 						return false;
 					}
@@ -1037,6 +2117,8 @@ namespace nana
 							}
 							else if (ptr->compare(i->key_ptr.get()))
 							{
+								cat_index_.invalidate();
+
 								auto & catobj = *categories_.emplace(i);
 								catobj.key_ptr = ptr;
 								return &catobj;
@@ -1044,6 +2126,8 @@ namespace nana
 						}
 					}
 
+					cat_index_.invalidate();
+
 #ifdef _nana_std_has_emplace_return_type
 					auto & last_cat = categories_.emplace_back();
 					last_cat.key_ptr = ptr;
@@ -1058,6 +2142,8 @@ namespace nana
 				/// Inserts a new category at position specified by pos
 				category_t* create_category(native_string_type&& text, std::size_t pos = nana::npos)
 				{
+					cat_index_.invalidate();
+
 					if (::nana::npos == pos)
 					{
 #ifdef _nana_std_has_emplace_return_type
@@ -1076,15 +2162,18 @@ namespace nana
 				{
 					auto & catobj = *get(pos.cat);
 
-					const auto item_count = catobj.items.size();
+					const auto item_count = catobj.size();
 
 					check_range(pos.item, item_count);
+					throw_if_immutable_model(catobj.model_ptr.get());
 
 					catobj.sorted.push_back(item_count);
+					catobj.selection.shift_insert(pos.item);
+					catobj.shift_widths(pos.item, true);
+					catobj.modified();
 
 					if (catobj.model_ptr)
 					{
-						throw_if_immutable_model(catobj.model_ptr.get());
 						auto container = catobj.model_ptr->container();
 						std::size_t item_index;
 						//
@@ -1105,11 +2194,15 @@ namespace nana
 						cells.emplace_back(std::move(text));
 						cells.resize(columns);
 						container->assign(item_index, cells);
-
-						return;
 					}
+					else
+						catobj.items.emplace(catobj.items.begin() + (pos.item < item_count ? pos.item : item_count), std::move(text));
 
-					catobj.items.emplace(catobj.items.begin() + (pos.item < item_count ? pos.item : item_count), std::move(text));
+					//The absolute positions of the items behind the new one are changed.
+					if (catobj.filter)
+						refilter(catobj);
+					else
+						catobj.rows_changed();
 				}
 
 				/// Converts an index between display position and absolute real position.
@@ -1131,18 +2224,20 @@ namespace nana
 				{
 					if (from.cat < categories_.size())
 					{
-						auto i = categories_.cbegin();
-						std::advance(i, from.cat);
+						auto i = cat_index_.at(from.cat);
 
-						auto & cat = *i;
-						if (from.item < cat.sorted.size())
+						auto & order = i->display_order();
+						if (from_display_order)
 						{
-							if (from_display_order)
-								return index_pair{ from.cat, static_cast<size_type>(cat.sorted[from.item]) };
-
-							for (size_type i = 0; i < cat.sorted.size(); ++i)
+							if (from.item < order.size())
+								return index_pair{ from.cat, static_cast<size_type>(order[from.item]) };
+						}
+						else if (from.item < i->size())
+						{
+							//A hidden item has no display position
+							for (size_type i = 0; i < order.size(); ++i)
 							{
-								if (from.item == cat.sorted[i])
+								if (from.item == order[i])
 									return index_pair{ from.cat, i };
 							}
 						}
@@ -1163,8 +2258,7 @@ namespace nana
 				{
 					if (pos.cat < categories_.size())
 					{
-						auto i = categories_.cbegin();
-						std::advance(i, pos.cat);
+						auto i = cat_index_.at(pos.cat);
 
 						throw_if_immutable_model(i->model_ptr.get());
 					}
@@ -1174,8 +2268,7 @@ namespace nana
 				{
 					if (pos.cat < categories_.size())
 					{
-						auto i = categories_.cbegin();
-						std::advance(i, pos.cat);
+						auto i = cat_index_.at(pos.cat);
 						if (i->model_ptr)
 						{
 							throw_if_immutable_model(i->model_ptr.get());
@@ -1191,7 +2284,7 @@ namespace nana
 
 				category_t::container::value_type& at_abs(const index_pair& pos)
 				{
-					return get(pos.cat)->items.at(pos.item);
+					return get(pos.cat)->item(pos.item);
 				}
 
 				std::vector<cell> at_model_abs(const index_pair& pos) const
@@ -1208,12 +2301,12 @@ namespace nana
 				/// return a ref to the real item object at display position
 				category_t::container::value_type& at(const index_pair& pos)
 				{
-					return get(pos.cat)->items.at(index_cast(pos, true).item);
+					return get(pos.cat)->item(index_cast(pos, true).item);
 				}
 
 				const category_t::container::value_type& at(const index_pair& pos) const
 				{
-					return get(pos.cat)->items.at(index_cast(pos, true).item);
+					return get(pos.cat)->item_view(index_cast(pos, true).item);
 				}
 
 				std::vector<cell> at_model(const index_pair& pos) const
@@ -1256,6 +2349,11 @@ namespace nana
 
 					catobj.items.clear();
 					catobj.sorted.clear();
+					catobj.selection.clear();
+					catobj.filter.reset();
+					catobj.widths.clear();
+					catobj.modified();
+					catobj.rows_changed();
 				}
 
                 // Clears all items in all cat, but not the container of cat self.
@@ -1274,7 +2372,7 @@ namespace nana
 					const auto cat_size = categories_.size();
 					index_pair dpos{ npos, npos };
 		
-					if (pos.cat >= cat_size || (pos.item != npos && pos.item >= size_item(pos.cat)))
+					if (pos.cat >= cat_size || (pos.item != npos && pos.item >= size_display(pos.cat)))
 						return dpos;
 
 					if ((0 == pos.cat && npos == pos.item) || (!expand(pos.cat) && (npos != pos.item)))
@@ -1283,58 +2381,25 @@ namespace nana
 					if (0 == n)
 						return pos;
 
-					dpos = pos;
-					if (0 < n)
+					//The rows are located by the index, where the row 0 is the title of the first category, and it is
+					//returned as (0, npos) when the position goes backward to it.
+					auto row = _m_row(pos);
+					const auto steps = static_cast<std::size_t>(n < 0 ? -static_cast<long long>(n) : n);
+					if (n < 0)
 					{
-						//Forward
-						std::size_t index = (npos == pos.item ? 0 : pos.item + 1);
-
-						while (n)
-						{
-							std::size_t end = 1;
-							if (expand(dpos.cat))
-								end += size_item(dpos.cat);
-
-							if (n < static_cast<int>(end - index))
-								return index_pair{ dpos.cat, index + n - 1 };
+						if (steps > row)
+							return dpos;
 
-							++dpos.cat;
-							if (cat_size == dpos.cat)
-								return index_pair{ npos, npos };
-
-							n -= static_cast<int>(end - index);
-							index = 0;
-						}
-						return index_pair{ dpos.cat, npos };
+						row -= steps;
 					}
-					
-					//Backward
-					n = -n;
-					dpos = pos;
-					if (good(dpos.cat))
-					{
-						auto count = static_cast<int>(dpos.is_category() ? 1 : pos.item + 2);
-						auto i = get(pos.cat);
-						while (true)
-						{
-							if (count > n)
-							{
-								count -= n;
-								dpos.item = (count == 1 ? npos : count - 2);
-								return dpos;
-							}
-
-							n -= count;
+					else
+						row += steps;
 
-							if (i == categories_.cbegin())
-								break;
+					const auto cat = cat_index_.locate(row);
+					if (cat >= cat_size)
+						return dpos;
 
-							--i;
-							--dpos.cat;
-							count = static_cast<int>(i->expand ? i->items.size() : 0) + 1;
-						}
-					}
-					return index_pair{npos, npos};
+					return index_pair{ cat, (row ? row - 1 : npos) };
 				}
 
                 /// change to index arg
@@ -1352,29 +2417,18 @@ namespace nana
 					else if(to.cat < from.cat)
 						std::swap(from, to);
 
-					std::size_t count = 1;
-					for (auto i = get(from.cat); i != get(to.cat); ++i)
-					{
-						if (i->expand)
-							count += i->items.size() + 1;
-						else
-							++count;
-					}
-
-					if (npos != to.item)
-						count += (1 + to.item);
+					auto count = _m_row(to) - _m_row(from);
 
-					if (npos != from.item)
-						count -= (1 + from.item);
-					else if (0 == from.cat)
+					//The title of the first category is not displayed
+					if ((0 == from.cat) && (npos == from.item))
 						--count;
 
-					return count - 1;
+					return count;
 				}
 
 				void text(category_t* cat, size_type pos, size_type abs_col, cell&& cl, size_type columns)
 				{
-					if ((abs_col < columns) && (pos < cat->items.size()))
+					if ((abs_col < columns) && (pos < cat->size()))
 					{
 						std::vector<cell> model_cells;
 
@@ -1390,8 +2444,6 @@ namespace nana
 						if (abs_col < cells.size())
 						{
 							cells[abs_col] = std::move(cl);
-							if (sort_attrs_.column == abs_col)
-								sort();
 						}
 						else
 						{	//If the index of specified sub item is over the number of sub items that item contained,
@@ -1402,12 +2454,18 @@ namespace nana
 
 						if (cat->model_ptr)
 							cat->model_ptr->container()->assign(pos, model_cells);
+
+						item_changed(*cat, pos);
+
+						//Sorts after the new text is stored, so that the sort sees it and records the modification.
+						if (sort_attrs_.column == abs_col)
+							sort();
 					}
 				}
 
 				void text(category_t* cat, size_type pos, size_type abs_col, std::string&& str, size_type columns)
 				{
-					if ((abs_col < columns) && (pos < cat->items.size()))
+					if ((abs_col < columns) && (pos < cat->size()))
 					{
 						std::vector<cell> model_cells;
 
@@ -1423,8 +2481,6 @@ namespace nana
 						if (abs_col < cells.size())
 						{
 							cells[abs_col].text = std::move(str);
-							if (sort_attrs_.column == abs_col)
-								sort();
 						}
 						else
 						{	//If the index of specified sub item is over the number of sub items that item contained,
@@ -1435,6 +2491,12 @@ namespace nana
 
 						if (cat->model_ptr)
 							cat->model_ptr->container()->assign(pos, model_cells);
+
+						item_changed(*cat, pos);
+
+						//Sorts after the new text is stored, so that the sort sees it and records the modification.
+						if (sort_attrs_.column == abs_col)
+							sort();
 					}
 				}
 
@@ -1455,9 +2517,17 @@ namespace nana
 
 						i->items.clear();
 						i->sorted.clear();
+						i->selection.clear();
+						i->filter.reset();
+						i->widths.clear();
+						i->modified();
+						i->rows_changed();
 					}
 					else
+					{
 						categories_.erase(i);
+						cat_index_.invalidate();
+					}
 				}
 
 				void erase()
@@ -1475,6 +2545,7 @@ namespace nana
 #else
 						categories_.erase(++categories_.begin(), categories_.end());
 #endif
+						cat_index_.invalidate();
 					}
 				}
 
@@ -1483,10 +2554,11 @@ namespace nana
 					//It is allowed to expand the 1st category.
 					if(good(cat) && (cat || exp))
 					{
-						auto & expanded = get(cat)->expand;
-						if(expanded != exp)
+						auto i = get(cat);
+						if(i->expand != exp)
 						{
-							expanded = exp;
+							i->expand = exp;
+							i->rows_changed();
 							return true;
 						}
 					}
@@ -1544,13 +2616,8 @@ namespace nana
 
 				size_type the_number_of_expanded() const noexcept
 				{
-					size_type n = categories_.size() - 1;
-					for (auto & i : categories_)
-					{
-						if(i.expand)
-							n += i.items.size();
-					}
-					return n;
+					//The title of the first category is not displayed
+					return cat_index_.rows() - 1;
 				}
 
 				/// Finds a good item or category if an item specified by pos is invalid
@@ -1565,7 +2632,7 @@ namespace nana
 						if ((pos.npos == pos.item) && !ignore_category)
 							return pos;
 
-						auto cat_item_size = this->get(pos.cat)->items.size();
+						auto cat_item_size = this->get(pos.cat)->size();
 
 						if (pos.item < cat_item_size)
 							return pos;
@@ -1579,109 +2646,169 @@ namespace nana
 					return index_pair{};
 				}
 
-				template<typename Pred>
-				std::vector<std::pair<index_pair, bool>> select_display_range_if(index_pair fr_abs, index_pair to_dpl, bool deselect_others, Pred pred)
+				/// Returns the absolute positions of the items in a display range for each category
+				/**
+				 * The items of a collapsed category are included if the category is in the range, the consecutive
+				 * absolute positions are merged into ranges.
+				 */
+				std::vector<interval_set> display_range(index_pair fr_dpl, index_pair to_dpl) const
+				{
+					std::vector<interval_set> sets(categories_.size());
+					if (fr_dpl.empty() || to_dpl.empty())
+						return sets;
+
+					if (fr_dpl > to_dpl)
+						std::swap(fr_dpl, to_dpl);
+
+					auto i = get(fr_dpl.cat);
+					for (auto cat_pos = fr_dpl.cat; cat_pos <= to_dpl.cat; ++cat_pos, ++i)
+					{
+						auto & order = i->display_order();
+
+						std::size_t first = 0, last = order.size();
+						if (i->expand)
+						{
+							if ((cat_pos == fr_dpl.cat) && !fr_dpl.is_category())
+								first = fr_dpl.item;
+
+							if ((cat_pos == to_dpl.cat) && !to_dpl.is_category())
+								last = (std::min)(to_dpl.item + 1, last);
+						}
+
+						std::vector<interval_set::range> ranges;
+						for (auto k = first; k < last; ++k)
+						{
+							if (!ranges.empty() && (ranges.back().second == order[k]))
+								++ranges.back().second;
+							else
+								ranges.emplace_back(order[k], order[k] + 1);
+						}
+						sets[cat_pos] = interval_set::from_ranges(std::move(ranges));
+					}
+					return sets;
+				}
+
+				/// Selects the items from an absolute position to a display position
+				void select_display_range(index_pair fr_abs, index_pair to_dpl, bool deselect_others)
 				{
 					fr_abs = find_next_good(fr_abs, true);
-					
+
 					if (to_dpl.empty())
 					{
 						if (fr_abs.empty())
-							return{};
+							return;
 
 						to_dpl = this->last();
 					}
-					
 
-					auto fr_dpl = (fr_abs.is_category() ? fr_abs : this->index_cast(fr_abs, false));	//Converts an absolute position to display position
-                    if (fr_dpl > to_dpl)
-						std::swap(fr_dpl, to_dpl);
+					//Converts an absolute position to display position, a hidden item is replaced with to_dpl
+					auto fr_dpl = (fr_abs.is_category() ? fr_abs : this->index_cast_noexcept(fr_abs, false, to_dpl));
+
+					auto sets = display_range(fr_dpl, to_dpl);
 
-					if (to_dpl.is_category() && this->size_item(to_dpl.cat) > 0)
-						to_dpl.item = this->size_item(to_dpl.cat) - 1;
+					size_type cat_pos = 0;
+					for (auto & cat : categories_)
+					{
+						auto & range = sets[cat_pos];
+						this->assign_selection(cat, cat_pos, (deselect_others ? std::move(range) : interval_set::unite(cat.selection, range)));
+						++cat_pos;
+					}
+				}
 
-					const index_pairs already_selected = (deselect_others ? this->pick_items(true) : index_pairs{});
+				/// Changes the selection of a category and records the changes
+				/**
+				 * The selected event is emitted for every changed item only if it has handlers, the selection_changed
+				 * is emitted by emit_selection_changed().
+				 * @return true if the selection is changed.
+				 */
+				bool assign_selection(category_t& cat, size_type cat_pos, interval_set sel)
+				{
+					sel.truncate(cat.size());
 
-					const auto begin = fr_dpl;
-					const auto last = to_dpl;
+					auto added = interval_set::subtract(sel, cat.selection);
+					auto removed = interval_set::subtract(cat.selection, sel);
+					if (added.empty() && removed.empty())
+						return false;
 
-					//pair first: index in the range of [begin, last]
-					//pair second: indicates whether the index is selected before selection.
-					std::vector<std::pair<index_pair, bool>> pairs;
+					cat.selection.swap(sel);
 
-					for (; !(fr_dpl > to_dpl); fr_dpl = advance(fr_dpl, 1))	//fr_dpl <= to_dpl
+					for (auto & r : removed.ranges())
 					{
-						if (fr_dpl.is_category())
-						{
-							if (!expand(fr_dpl.cat))
-							{
-								auto size = size_item(fr_dpl.cat);
-								for (std::size_t i = 0; i < size; ++i)
-								{
-									index_pair abs_pos{ fr_dpl.cat, i };
-									item_proxy m{ ess_, abs_pos };
-									pairs.emplace_back(abs_pos, m.selected());
+						selection_changes_.second.push_back({ cat_pos, r.first, r.second });
 
-									if (pred(abs_pos))
-										m.select(true);
-								}
+						if ((latest_selected_abs.cat == cat_pos) && (r.first <= latest_selected_abs.item) && (latest_selected_abs.item < r.second))
+							latest_selected_abs.set_both(npos);
+					}
 
-								if (fr_dpl.cat == to_dpl.cat)
-									break;
-							}
-						}
-						else
-						{
-							auto abs_pos = index_cast(fr_dpl, true);	//convert display position to absolute position
-							item_proxy m{ ess_, abs_pos };
-							pairs.emplace_back(abs_pos, m.selected());
+					for (auto & r : added.ranges())
+						selection_changes_.first.push_back({ cat_pos, r.first, r.second });
 
-							if (pred(abs_pos))
-								m.select(true);
-						}
-					}
+					if (wd_ptr()->events().selected.length())
+					{
+						for (auto & r : removed.ranges())
+							for (auto pos = r.first; pos < r.second; ++pos)
+								this->emit_cs(index_pair{ cat_pos, pos }, true);
 
-					if (deselect_others)
+						for (auto & r : added.ranges())
+							for (auto pos = r.first; pos < r.second; ++pos)
+								this->emit_cs(index_pair{ cat_pos, pos }, true);
+					}
+					else
 					{
-						//Deselects the already selected which is out of range [begin, last] 
-						for (auto index : already_selected)
+						//Only the inline panes are notified if no one listens to every item.
+						for (auto p : active_panes_)
 						{
-							auto disp_order = this->index_cast(index, false);	//converts an absolute position to a display position
-							if (begin > disp_order || disp_order > last)
-								item_proxy{ ess_, index }.select(false);
+							if (p && (p->item_pos.cat == cat_pos) && (added.contains(p->item_pos.item) || removed.contains(p->item_pos.item)))
+								p->inline_ptr->notify_status(inline_widget_status::selecting, cat.is_selected(p->item_pos.item));
 						}
 					}
+					return true;
+				}
+
+				bool select_range(const index_pair& abs_pos, std::size_t count, bool sel)
+				{
+					auto & cat = *get(abs_pos.cat);
+					const interval_set range{ abs_pos.item, abs_pos.item + count };
+					return assign_selection(cat, abs_pos.cat, (sel ? interval_set::unite(cat.selection, range) : interval_set::subtract(cat.selection, range)));
+				}
+
+				/// Emits the selection_changed with the changes which are recorded since last emission
+				void emit_selection_changed()
+				{
+					if (selection_changes_.first.empty() && selection_changes_.second.empty())
+						return;
 
-					return pairs;
+					arg_listbox_selection arg{ *wd_ptr() };
+					arg.selected.swap(selection_changes_.first);
+					arg.deselected.swap(selection_changes_.second);
+
+					wd_ptr()->events().selection_changed.emit(arg, wd_ptr()->handle());
 				}
 
 				bool select_for_all(bool sel, const index_pair& except_abs = index_pair{npos, npos})
 				{
 					bool changed = false;
-					index_pair pos;
+					size_type cat_pos = 0;
 					for (auto & cat : categories_)
 					{
-						pos.item = 0;
-						for(auto & m : cat.items)
-						{
-							if (except_abs != pos)
-							{
-								if (m.flags.selected != sel)
-								{
-									changed = true;
-									m.flags.selected = sel;
+						interval_set target;
+						if (sel)
+							target = interval_set{ 0, cat.size() };
 
-									this->emit_cs(pos, true);
+						//The excepted item remains its state
+						if ((except_abs.cat == cat_pos) && (except_abs.item < cat.size()))
+						{
+							const interval_set except{ except_abs.item, except_abs.item + 1 };
+							target = (cat.is_selected(except_abs.item) ? interval_set::unite(target, except) : interval_set::subtract(target, except));
+						}
 
-									if (m.flags.selected)
-										latest_selected_abs = pos;
-									else if (latest_selected_abs == pos)
-										latest_selected_abs.set_both(npos);		//make empty
-								}
-							}
-							++pos.item;
+						if (this->assign_selection(cat, cat_pos, std::move(target)))
+						{
+							changed = true;
+							if (sel)
+								latest_selected_abs = index_pair{ cat_pos, cat.selection.ranges().back().second - 1 };
 						}
-						++pos.cat;
+						++cat_pos;
 					}
 					return changed;
 				}
@@ -1702,19 +2829,36 @@ namespace nana
 
 					for (auto & cat : categories_)
 					{
-						id.item = 0;
-						for (auto & m : cat.items)
+						if (for_selection)
+						{
+							for (auto & r : cat.selection.ranges())
+							{
+								for (id.item = r.first; id.item < r.second; ++id.item)
+								{
+									if (items_status && *items_status)
+										*items_status = cat.flags(id.item).checked;
+
+									results.push_back(id);  // absolute positions, no relative to display
+									if (find_first)
+										return results;
+								}
+							}
+						}
+						else
 						{
-							if (for_selection ? m.flags.selected : m.flags.checked)
+							const auto size = cat.size();
+							for (id.item = 0; id.item < size; ++id.item)
 							{
-								if (items_status && *items_status)
-									*items_status = (for_selection ? m.flags.checked : m.flags.selected);
+								if (cat.flags(id.item).checked)
+								{
+									if (items_status && *items_status)
+										*items_status = cat.is_selected(id.item);
 
-								results.push_back(id);  // absolute positions, no relative to display
-								if (find_first)
-									return results;
+									results.push_back(id);  // absolute positions, no relative to display
+									if (find_first)
+										return results;
+								}
 							}
-							++id.item;
 						}
 						++id.cat;
 					}
@@ -1725,33 +2869,25 @@ namespace nana
                 /// we are moving in display, but the selection ocurre in abs position
                 void move_select(bool upwards=true, bool unselect_previous=true, bool into_view=false) noexcept;
 
+				/// The selection is cancelled by ranges, these are only for the check.
 				struct pred_cancel
 				{
-					const bool for_selection;
-
-					pred_cancel(bool for_sel) noexcept : for_selection(for_sel) {}
-
-					bool operator()(category_t::container::value_type & m) const noexcept
+					bool operator()(const item_data::inner_flags& flags) const noexcept
 					{
-						return (for_selection ? m.flags.selected : m.flags.checked);
+						return flags.checked;
 					}
 				};
 
 				struct emit_cancel
 				{
 					es_lister* const self;
-					const bool for_selection;
 
-					emit_cancel(es_lister* self, bool for_sel) noexcept : self(self), for_selection(for_sel) {}
+					emit_cancel(es_lister* self) noexcept : self(self) {}
 
-					void operator()(category_t::container::value_type& m, const index_pair& item_pos) const
+					void operator()(item_data::inner_flags& flags, const index_pair& item_pos) const
 					{
-						if (for_selection)
-							m.flags.selected = false;
-						else
-							m.flags.checked = false;
-
-						self->emit_cs(item_pos, for_selection);
+						flags.checked = false;
+						self->emit_cs(item_pos, false);
 					}
 				};
 
@@ -1760,20 +2896,38 @@ namespace nana
 					if (!(for_selection ? single_selection_ : single_check_))
 						return;
 
-					pred_cancel pred{ for_selection };
-					emit_cancel do_cancel{ this, for_selection };
+					if (for_selection)
+					{
+						//Only the except item remains its state
+						size_type cat_pos = 0;
+						for (auto & cat : categories_)
+						{
+							if ((!single_selection_category_limited_) || (cat_pos == except.cat))
+							{
+								interval_set target;
+								if ((cat_pos == except.cat) && (except.item < cat.size()) && cat.is_selected(except.item))
+									target = interval_set{ except.item, except.item + 1 };
+
+								this->assign_selection(cat, cat_pos, std::move(target));
+							}
+							++cat_pos;
+						}
+						return;
+					}
+
+					pred_cancel pred;
+					emit_cancel do_cancel{ this };
 
-					if (for_selection ? single_selection_category_limited_ : single_check_category_limited_)
+					if (single_check_category_limited_)
 					{
 						auto i = this->get(except.cat);
 
-						std::size_t item_pos = 0;
-						for (auto & m : i->items)
+						const auto size = i->size();
+						for (std::size_t item_pos = 0; item_pos < size; ++item_pos)
 						{
-							if ((item_pos != except.item) && pred(m))
-								do_cancel(m, index_pair{ except.cat, item_pos });
-
-							++item_pos;
+							auto & flags = i->flags(item_pos);
+							if ((item_pos != except.item) && pred(flags))
+								do_cancel(flags, index_pair{ except.cat, item_pos });
 						}
 					}
 					else
@@ -1781,16 +2935,15 @@ namespace nana
 						index_pair cancel_pos;
 						for (auto & cat : categories_)
 						{
-							for (auto & m : cat.items)
+							const auto size = cat.size();
+							for (cancel_pos.item = 0; cancel_pos.item < size; ++cancel_pos.item)
 							{
-								if ((cancel_pos != except) && pred(m))
-									do_cancel(m, cancel_pos);
-
-								++cancel_pos.item;
+								auto & flags = cat.flags(cancel_pos.item);
+								if ((cancel_pos != except) && pred(flags))
+									do_cancel(flags, cancel_pos);
 							}
 
 							++cancel_pos.cat;
-							cancel_pos.item = 0;
 						}
 					}
 				}
@@ -1811,8 +2964,28 @@ namespace nana
 					single = true;
 					limited = category_limited;
 
-					pred_cancel pred{ for_selection };
-					emit_cancel cancel{ this, for_selection };
+					if (for_selection)
+					{
+						//The first selected item of each category, or of all the categories remains selected.
+						bool found = false;
+						size_type cat_pos = 0;
+						for (auto & cat : categories_)
+						{
+							interval_set target;
+							if (!cat.selection.empty() && (category_limited || !found))
+							{
+								const auto first = cat.selection.ranges().front().first;
+								target = interval_set{ first, first + 1 };
+								found = true;
+							}
+
+							this->assign_selection(cat, cat_pos++, std::move(target));
+						}
+						return;
+					}
+
+					pred_cancel pred;
+					emit_cancel cancel{ this };
 
 					std::size_t cat_pos = 0;
 
@@ -1823,19 +2996,19 @@ namespace nana
 						if ((category_limited) || (!selected))
 						{
 							bool ignore = true;	//Ignore the first matched item
-							std::size_t pos = 0;
-							for (auto & m : cat.items)
+							const auto size = cat.size();
+							for (std::size_t pos = 0; pos < size; ++pos)
 							{
-								if (pred(m))
+								auto & flags = cat.flags(pos);
+								if (pred(flags))
 								{
 									selected = true;
 
 									if (ignore)
 										ignore = false;
 									else
-										cancel(m, index_pair{ cat_pos, pos });
+										cancel(flags, index_pair{ cat_pos, pos });
 								}
-								++pos;
 							}
 							++cat_pos;
 						}
@@ -1847,12 +3020,12 @@ namespace nana
 								if (skip_cat++ < cat_pos)
 									continue;
 
-								std::size_t pos = 0;
-								for (auto & m : cat.items)
+								const auto size = cat.size();
+								for (std::size_t pos = 0; pos < size; ++pos)
 								{
-									if (pred(m))
-										cancel(m, index_pair{ cat_pos, pos });
-									++pos;
+									auto & flags = cat.flags(pos);
+									if (pred(flags))
+										cancel(flags, index_pair{ cat_pos, pos });
 								}
 								++cat_pos;
 							}
@@ -1873,15 +3046,24 @@ namespace nana
 
 				size_type size_item(size_type cat) const
 				{
-					return get(cat)->items.size();
+					return get(cat)->size();
+				}
+
+				/// Returns the number of the items which are displayed in the category
+				size_type size_display(size_type cat) const
+				{
+					return get(cat)->display_size();
 				}
 
 				bool cat_status(size_type pos, bool for_selection) const
 				{
-					auto & items = get(pos)->items;
-					for (auto & m : items)
+					auto cat = get(pos);
+					if (for_selection)
+						return cat->selection.covers(0, cat->size());
+
+					for (std::size_t i = 0, size = cat->size(); i < size; ++i)
 					{
-						if ((for_selection ? m.flags.selected : m.flags.checked) == false)
+						if (!cat->flags(i).checked)
 							return false;
 					}
 					return true;
@@ -1901,7 +3083,7 @@ namespace nana
                 /// can be used as the absolute position of the last absolute item, or as the display pos of the last displayed item
                 index_pair last() const noexcept
 				{
-					index_pair i{ categories_.size() - 1, categories_.back().items.size() };
+					index_pair i{ categories_.size() - 1, categories_.back().display_size() };
 
 					if (i.cat)
 					{
@@ -1925,7 +3107,7 @@ namespace nana
                 index_pair first() const noexcept
                 {
 					auto i = categories_.cbegin();
-					if (i->items.size())
+					if (i->display_size())
 						return index_pair{ 0, 0 };
 
 					if (categories_.size() > 1)
@@ -1944,23 +3126,246 @@ namespace nana
 					return ((pos.cat < categories_.size()) && (pos.item < size_item(pos.cat)));
 				}
 
-				/// categories iterator
-				container::iterator get(size_type pos)
+				/// categories iterator
+				container::iterator get(size_type pos)
+				{
+					check_range(pos, categories_.size());
+					return cat_index_.at(pos);
+				}
+
+				container::const_iterator get(size_type pos) const
+				{
+					check_range(pos, categories_.size());
+					return cat_index_.at(pos);
+				}
+			private:
+				/// Returns the row of a display position in the category index
+				std::size_t _m_row(const index_pair& pos) const
+				{
+					return cat_index_.rows_before(pos.cat) + (npos == pos.item ? 0 : pos.item + 1);
+				}
+
+				std::shared_ptr<sort_engine::job> _m_make_sort_job() const
+				{
+					const auto column = sort_attrs_.column;
+
+					auto jb = std::make_shared<sort_engine::job>();
+					jb->comp = fetch_ordering_comparer(column);
+					jb->kind = (fetch_sort_key ? fetch_sort_key(column) : sort_key::text);
+					jb->reverse = sort_attrs_.reverse;
+
+					sort_engine::key_maker make_key{ jb->kind };
+
+					std::vector<cell> cells;
+					for (auto & cat : categories_)
+					{
+						jb->keys.emplace_back(cat.size());
+						jb->orders.push_back(cat.sorted);
+						jb->modifications.push_back(cat.modifications);
+
+						auto & keys = jb->keys.back();
+						for (std::size_t pos = 0; pos < keys.size(); ++pos)
+						{
+							make_key(keys[pos], _m_fetch_text(cat, pos, column, cells));
+
+							if (jb->comp)
+								keys[pos].anyobj = cat.item_view(pos).anyobj.get();
+						}
+					}
+					return jb;
+				}
+
+				/// Applies the sorted orders, it fails if the items of a category are changed since the keys are extracted.
+				bool _m_apply_sort(sort_engine::job& jb)
+				{
+					if (jb.orders.size() != categories_.size())
+						return false;
+
+					std::size_t i = 0;
+					for (auto & cat : categories_)
+					{
+						if ((jb.modifications[i] != cat.modifications) || (jb.orders[i].size() != cat.sorted.size()))
+							return false;
+						++i;
+					}
+
+					i = 0;
+					for (auto & cat : categories_)
+					{
+						cat.sorted.swap(jb.orders[i++]);
+						cat.make_display_order();
+					}
+
+					return true;
+				}
+
+				void _m_sort_in_background(std::shared_ptr<sort_engine::job> jb)
+				{
+					sort_job_ = jb;
+					sort_engine::run_in_background(jb);
+
+					if (!sort_timer_)
+					{
+						//The timer polls the background sorting, it applies the result in the GUI thread.
+						sort_timer_.reset(new timer{ std::chrono::milliseconds{ 30 } });
+						sort_timer_->elapse([this]{
+							_m_check_background_sort();
+						});
+					}
+					sort_timer_->start();
+				}
+
+				// Definition is provided after struct essence
+				void _m_check_background_sort();
+
+				void _m_cancel_sort()
+				{
+					//The cancelled job is not waited for, it is released by the pool when it stops.
+					if (sort_job_)
+					{
+						sort_job_->cancelled = true;
+						sort_job_.reset();
+					}
+
+					if (sort_timer_)
+						sort_timer_->stop();
+				}
+
+				/// Tests an item again after it is changed
+				void _m_filter_changed(category_t& cat, std::size_t pos)
+				{
+					if (!cat.filter || (pos >= cat.filter->matched.size()))
+						return;
+
+					std::vector<cell> cells;
+					_m_fetch_cells(cat, pos, cells);
+
+					const bool matched = filter_engine::tester{ filter_query_ }(cells);
+					if (cat.filter->matched[pos] != matched)
+					{
+						cat.filter->matched[pos] = matched;
+						cat.make_display_order();
+					}
+				}
+
+				/// Returns the text of a column, the rows of a virtual category are fetched without caching them.
+				static std::string _m_fetch_text(const category_t& cat, std::size_t pos, std::size_t column, std::vector<cell>& cells)
+				{
+					std::string text;
+					if (cat.virt)
+					{
+						cat.virt->model->fetch(pos, cells);
+						if (column < cells.size())
+							text.swap(cells[column].text);
+					}
+					else if (cat.model_ptr)
+					{
+						auto model_cells = cat.model_ptr->container()->to_cells(pos);
+						if (column < model_cells.size())
+							text.swap(model_cells[column].text);
+					}
+					else
+					{
+						auto & item_cells = *cat.items[pos].cells;
+						if (column < item_cells.size())
+							text = item_cells[column].text;
+					}
+					return text;
+				}
+
+				static void _m_fetch_cells(const category_t& cat, std::size_t pos, std::vector<cell>& cells)
+				{
+					if (cat.virt)
+						cat.virt->model->fetch(pos, cells);
+					else
+						cells = cat.cells(pos);
+				}
+
+				/// Applies the matched items, it fails if the items of a category are changed since the texts are copied.
+				bool _m_apply_filter(filter_engine::job& jb)
+				{
+					if (jb.sizes.size() != categories_.size())
+						return false;
+
+					std::size_t i = 0;
+					for (auto & cat : categories_)
+					{
+						if ((jb.modifications[i] != cat.modifications) || (jb.sizes[i] != cat.size()))
+							return false;
+						++i;
+					}
+
+					filter_query_ = std::move(jb.q);
+					filtering_ = true;
+
+					i = 0;
+					for (auto & cat : categories_)
+					{
+						if (!cat.filter)
+							cat.filter.reset(new category_t::filter_state);
+
+						auto & matched = cat.filter->matched;
+						matched.assign(cat.size(), false);
+						for (auto pos : jb.results[i++])
+							matched[pos] = true;
+
+						//The order is rebuilt, because the items may be sorted since the texts are copied.
+						cat.make_display_order();
+					}
+					return true;
+				}
+
+				// Definition is provided after struct essence
+				void _m_filter_applied();
+
+				void _m_filter_in_background(std::shared_ptr<filter_engine::job> jb)
+				{
+					filter_job_ = jb;
+					filter_thread_.reset(new std::thread([jb]{
+						filter_engine::run(*jb);
+					}));
+
+					if (!filter_timer_)
+					{
+						filter_timer_.reset(new timer{ std::chrono::milliseconds{ 30 } });
+						filter_timer_->elapse([this]{
+							_m_check_background_filter();
+						});
+					}
+					filter_timer_->start();
+				}
+
+				void _m_check_background_filter()
 				{
-					check_range(pos, categories_.size());
+					if (filter_job_ && filter_job_->finished)
+					{
+						auto jb = std::move(filter_job_);
+						_m_cancel_filter();
 
-					auto i = categories_.begin();
-					std::advance(i, pos);
-					return i;
+						//Filters again if the categories were changed while filtering.
+						if (_m_apply_filter(*jb))
+							_m_filter_applied();
+						else
+							filter(std::move(jb->q), false);
+					}
 				}
 
-				container::const_iterator get(size_type pos) const
+				void _m_cancel_filter()
 				{
-					check_range(pos, categories_.size());
+					if (filter_job_)
+					{
+						filter_job_->cancelled = true;
+						filter_job_.reset();
+					}
 
-					auto i = categories_.cbegin();
-					std::advance(i, pos);
-					return i;
+					if (filter_thread_)
+					{
+						filter_thread_->join();
+						filter_thread_.reset();
+					}
+
+					if (filter_timer_)
+						filter_timer_->stop();
 				}
 			public:
 				index_pair latest_selected_abs;	//Stands for the latest selected item that selected by last operation. Invalid if it is empty.
@@ -1970,6 +3375,7 @@ namespace nana
 
 				sort_attributes sort_attrs_;	//Attributes of sort
 				container categories_;
+				mutable category_index cat_index_{ categories_ };	//It is rebuilt lazily, so it is mutable for the const accessors
 
 				bool	ordered_categories_{false};	///< A switch indicates whether the categories are ordered.
 												/// The ordered categories always creates a new category at a proper position(before the first one which is larger than it).
@@ -1980,6 +3386,19 @@ namespace nana
 				bool single_check_category_limited_{ false };
 
 				std::vector<inline_pane*> active_panes_;
+
+				//The selected and deselected ranges which are not emitted by selection_changed yet
+				std::pair<std::vector<arg_listbox_selection::range>, std::vector<arg_listbox_selection::range>> selection_changes_;
+
+				bool async_sort_{ false };
+				std::shared_ptr<sort_engine::job> sort_job_;	//The background sorting in progress
+				std::unique_ptr<timer> sort_timer_;
+
+				bool filtering_{ false };
+				filter_engine::query filter_query_;				//The query which is applied
+				std::shared_ptr<filter_engine::job> filter_job_;	//The background filtering in progress
+				std::unique_ptr<std::thread> filter_thread_;
+				std::unique_ptr<timer> filter_timer_;
 			};//end class es_lister
 
 			enum class operation_states
@@ -2035,21 +3454,10 @@ namespace nana
 					point	screen_pos;
 					point	begin_position;	///< Logical position to the 
 					point	end_position;
-					index_pairs already_selected;
-					index_pairs selections;
+					std::vector<interval_set> already_selected;	///< The selection of each category before the box selection if ctrl or shift is pressed
 
 					unsigned scroll_step{ 1 };
 					unsigned mouse_move_timestamp{ 0 };
-
-					bool is_already_selected(const index_pair& abs_pos) const noexcept
-					{
-						return (already_selected.cend() != std::find(already_selected.cbegin(), already_selected.cend(), abs_pos));
-					}
-
-					bool is_selected(const index_pair& abs_pos) const noexcept
-					{
-						return (selections.cend() != std::find(selections.cbegin(), selections.cend(), abs_pos));
-					}
 				}mouse_selection;
 
 
@@ -2063,6 +3471,11 @@ namespace nana
 					{
 						return header.at(pos).weak_ordering;
 					};
+
+					lister.fetch_sort_key = [this](std::size_t pos)
+					{
+						return header.at(pos).key_kind;
+					};
 				}
 
 				unsigned suspension_width() const
@@ -2075,8 +3488,8 @@ namespace nana
 					if (abs_pos.is_category())
 						return lister.cat_status(abs_pos.cat, for_selection);
 					
-					auto & flags = lister.get(abs_pos.cat)->items.at(abs_pos.item).flags;
-					return (for_selection ? flags.selected : flags.checked);
+					auto & cat = *lister.get(abs_pos.cat);
+					return (for_selection ? cat.is_selected(abs_pos.item) : cat.flags(abs_pos.item).checked);
 				}
 
 				void resize_disp_area()
@@ -2154,9 +3567,12 @@ namespace nana
 					mouse_selection.end_position = logic_pos;
 					mouse_selection.deselect_when_start_to_move = true;
 
+					mouse_selection.already_selected.clear();
 					if (arg.ctrl || arg.shift)
 					{
-						mouse_selection.already_selected = lister.pick_items(true);
+						for (auto & cat : lister.cat_container())
+							mouse_selection.already_selected.push_back(cat.selection);
+
 						mouse_selection.reverse_selection = arg.ctrl;
 					}
 					API::set_capture(*listbox_ptr, true);
@@ -2175,8 +3591,6 @@ namespace nana
 						mouse_selection.deselect_when_start_to_move = false;
 						if (mouse_selection.already_selected.empty())
 							lister.select_for_all(false);
-
-						mouse_selection.selections.clear();
 					}
 
 					mouse_selection.screen_pos = screen_pos;
@@ -2194,7 +3608,7 @@ namespace nana
 
 					mouse_selection.end_position = logic_pos;
 
-					std::vector<std::pair<index_pair, bool>> selections;
+					std::vector<interval_set> box;
 
 					auto content_x = coordinate_cast({ columns_range().first, 0 }, true).x;
 					if ((std::max)(mouse_selection.end_position.x, mouse_selection.begin_position.x) >= content_x &&
@@ -2210,91 +3624,32 @@ namespace nana
 								//The range [begin_off, last_off] is a range of box selection
 								auto last_off = (std::max)(mouse_selection.begin_position.y, mouse_selection.end_position.y) / item_height();
 								auto last = lister.advance(lister.first(), last_off);
+								if (last.empty())
+									last = lister.last();
 
-								//Tries to select the items in the box, then returns the items with their previous selected states
-								selections = lister.select_display_range_if(begin, last, false, [this](const index_pair& abs_pos) {
-									if (mouse_selection.reverse_selection)
-									{
-										//Deselects the items in the box which has been already selected
-										if(mouse_selection.is_already_selected(abs_pos))
-										{
-											item_proxy{ this, abs_pos }.select(false);
-											return false;
-										}
-									}
-									return true;
-								});
-
-								for (auto & pair : selections)
-								{
-									//Continue if the previous state is selected. It indicates the item now is not selected.
-									if (pair.second)
-										continue;
-
-									//Add the item to selections container.
-									if(!mouse_selection.is_selected(pair.first))
-										mouse_selection.selections.push_back(pair.first);
-								}
-
-								//Deselects the items which are in mouse_selection.selections but not in selections.
-								//Eq to mouse_selection.selections = selections
-#ifdef _MSC_VER
-								for (auto i = mouse_selection.selections.cbegin(); i != mouse_selection.selections.cend();)
-#else
-								for(auto i = mouse_selection.selections.begin(); i != mouse_selection.selections.end();)
-#endif
-								{
-									auto & selpos = *i;
-									if (selections.cend() == std::find_if(selections.cbegin(), selections.cend(), /*pred_mouse_selection{ *i }*/[&selpos](const std::pair<index_pair, bool>& m){
-										return (selpos == m.first);
-									}))
-									{
-										item_proxy{ this, selpos }.select(false);
-										i = mouse_selection.selections.erase(i);
-									}
-									else
-										++i;
-								}
-							}
-						}
-					}
-
-					//Restores an already selected item if it is not in selections.
-					for (auto& abs_pos : mouse_selection.already_selected)
-					{
-						if (selections.cend() == std::find_if(selections.cbegin(), selections.cend(), [abs_pos](const std::pair<index_pair, bool>& rhs) {
-							return (abs_pos == rhs.first);
-							}))
-						{
-							item_proxy m{ this, abs_pos };
-							if (!m.selected())
-							{
-								m.select(true);
-								//Add the item to selections container.
-								if(!mouse_selection.is_selected(abs_pos))
-									mouse_selection.selections.push_back(abs_pos);
+								box = lister.display_range(begin, last);
 							}
 						}
 					}
 
-					//Deselects the item which is not in already_selected and selections but in mouse_selection.selections
-					for(auto i = mouse_selection.selections.cbegin(); i != mouse_selection.selections.cend();)
+					//The items in the box are selected, or reversed if ctrl is pressed. The items out of the box restore
+					//the states before the box selection.
+					const interval_set none;
+					size_type cat_pos = 0;
+					for (auto & cat : lister.cat_container())
 					{
-						auto abs_pos = *i;
-
-						bool is_box_selected = (selections.cend() != std::find_if(selections.cbegin(), selections.cend(), [abs_pos](const std::pair<index_pair, bool>& rhs) {
-							return (abs_pos == rhs.first);
-							}));
+						auto & base = (cat_pos < mouse_selection.already_selected.size() ? mouse_selection.already_selected[cat_pos] : none);
+						auto & in_box = (cat_pos < box.size() ? box[cat_pos] : none);
 
-						if (is_box_selected || mouse_selection.is_already_selected(abs_pos))
-						{
-							++i;
-							continue;
-						}
+						if (mouse_selection.reverse_selection)
+							lister.assign_selection(cat, cat_pos, interval_set::combine(base, in_box, [](bool x, bool y){ return x != y; }));
+						else
+							lister.assign_selection(cat, cat_pos, interval_set::unite(base, in_box));
 
-						item_proxy{ this, abs_pos }.select(false);
-						i = mouse_selection.selections.erase(i);
+						++cat_pos;
 					}
+
+					lister.emit_selection_changed();
 				}
 
 				void stop_mouse_selection() noexcept
@@ -2303,7 +3658,6 @@ namespace nana
 					API::release_capture(*listbox_ptr);
 					mouse_selection.begin_position = mouse_selection.end_position;
 					mouse_selection.already_selected.clear();
-					mouse_selection.selections.clear();
 				}
 
 				/// Returns the number of items that are contained on on screen
@@ -2848,7 +4202,34 @@ namespace nana
 			}
 			//end class iresolver/oresolver
 
-			unsigned es_lister::column_content_pixels(size_type pos) const
+			void es_lister::_m_check_background_sort()
+			{
+				if (sort_job_ && sort_job_->finished)
+				{
+					auto jb = std::move(sort_job_);
+					_m_cancel_sort();
+
+					if (jb->error)
+						std::rethrow_exception(jb->error);
+
+					//Sorts again if the categories were changed while sorting.
+					if (!_m_apply_sort(*jb))
+						sort();
+
+					ess_->update();
+				}
+			}
+
+			void es_lister::_m_filter_applied()
+			{
+				//The number of displayed items is changed, it scrolls to the top.
+				ess_->calc_content_size(false);
+				ess_->content_view->change_position(0, false, false);
+				ess_->content_view->sync(false);
+				ess_->update();
+			}
+
+			unsigned es_lister::column_content_pixels(size_type pos, std::size_t max_rows)
 			{
 				unsigned max_px = 0;
 				
@@ -2862,29 +4243,88 @@ namespace nana
 					graph = graph_helper.get();
 				}
 
+				std::size_t total = 0;
+				for (auto & cat : categories_)
+					total += cat.size();
+
+				if (max_rows >= total)
+					max_rows = 0;	//All items are measured
+
+				std::vector<cell> cells;
+				std::vector<std::pair<std::size_t, std::size_t>> candidates;	//(length of text, absolute position)
 				for (auto & cat : categories_)
 				{
-					for (std::size_t i = 0; i < cat.items.size(); ++i)
+					const auto size = cat.size();
+					if (0 == size)
+						continue;
+
+					std::vector<unsigned>* widths = nullptr;
+					if (cat.caches_widths())
 					{
-						unsigned content_px = 0;
-						if (cat.model_ptr)
-						{
-							auto model_cells = cat.model_ptr->container()->to_cells(i);
-							if (pos >= model_cells.size())
-								continue;
+						if (cat.widths.size() <= pos)
+							cat.widths.resize(pos + 1);
 
-							content_px = graph->text_extent_size(model_cells[pos].text).width;
-						}
-						else
+						widths = &cat.widths[pos];
+						if (widths->size() < size)
+							widths->resize(size, category_t::unmeasured);
+					}
+
+					auto measure = [&](std::size_t i)
+					{
+						unsigned content_px = (widths ? (*widths)[i] : category_t::unmeasured);
+						if (category_t::unmeasured == content_px)
 						{
-							if (pos >= cat.items[i].cells->size())
-								continue;
+							content_px = graph->text_extent_size(_m_fetch_text(cat, i, pos, cells)).width;
 
-							content_px = graph->text_extent_size((*cat.items[i].cells)[pos].text).width;
+							if (widths)
+								(*widths)[i] = content_px;
 						}
 
 						if (content_px > max_px)
 							max_px = content_px;
+					};
+
+					if (0 == max_rows)
+					{
+						for (std::size_t i = 0; i < size; ++i)
+							measure(i);
+						continue;
+					}
+
+					//The budget is shared by the categories in proportion to their sizes.
+					auto quota = static_cast<std::size_t>(static_cast<double>(size) * max_rows / total);
+					if (0 == quota)
+						quota = 1;
+
+					if (quota >= size)
+					{
+						for (std::size_t i = 0; i < size; ++i)
+							measure(i);
+					}
+					else if (cat.model_ptr)
+					{
+						//The texts of a model are converted from its cells, they are sampled without ranking all the items.
+						for (std::size_t n = 0; n < quota; ++n)
+							measure(n * size / quota);
+					}
+					else
+					{
+						//The width of a text is nearly proportional to its length, the longest texts are measured.
+						candidates.clear();
+						for (std::size_t i = 0; i < size; ++i)
+						{
+							auto & item_cells = *cat.items[i].cells;
+							candidates.emplace_back((pos < item_cells.size() ? item_cells[pos].text.size() : 0), i);
+						}
+
+						std::nth_element(candidates.begin(), candidates.begin() + (quota - 1), candidates.end(),
+							[](const std::pair<std::size_t, std::size_t>& a, const std::pair<std::size_t, std::size_t>& b)
+							{
+								return a.first > b.first;
+							});
+
+						for (std::size_t n = 0; n < quota; ++n)
+							measure(candidates[n].second);
 					}
 				}
 				return max_px;
@@ -2919,7 +4359,16 @@ namespace nana
 
 			void es_header::column::fit_content(unsigned maximize) noexcept
 			{
-				auto content_px = ess_->lister.column_content_pixels(index);
+				unsigned content_px = 0;
+				try
+				{
+					content_px = ess_->lister.column_content_pixels(index, ess_->scheme_ptr->max_fit_rows);
+				}
+				catch (std::bad_alloc&)
+				{
+					//The measured pixels and the candidates are allocated, the width is kept if it runs out of memory.
+					return;
+				}
 
 				if (0 == content_px)
 					return;
@@ -3032,13 +4481,15 @@ namespace nana
 						if (model_cells.size())
 							ess_->lister.assign_model(pos, model_cells);
 
+						//The item is tested by the filter again, but it is not sorted while it is being edited.
+						ess_->lister.item_changed(*ess_->lister.get(pos.cat), pos.item);
 						ess_->update();
 					}
 				}
 
 				void selected(index_type pos) override
 				{
-					if (ess_->lister.at(pos).flags.selected)
+					if (ess_->lister.get(pos.cat)->is_selected(pos.item))
 						return;
 					ess_->lister.select_for_all(false);
 					cat_proxy(ess_, pos.cat).at(pos.item).select(true);
@@ -3065,9 +4516,13 @@ namespace nana
 			{
 				auto& cat = *get(abs_pos.cat);
 
-				if ((abs_pos.item != nana::npos) && (abs_pos.item >= cat.items.size()))
+				if ((abs_pos.item != nana::npos) && (abs_pos.item >= cat.size()))
 					throw std::invalid_argument("listbox: invalid pos to scroll");
 
+				//A hidden item can't be scrolled into the view
+				if ((abs_pos.item != nana::npos) && cat.filter && !cat.filter->matched[abs_pos.item])
+					return;
+
 				if (!cat.expand)
 				{
 					this->expand(abs_pos.cat, true);
@@ -3120,7 +4575,7 @@ namespace nana
 			void es_lister::erase(const index_pair& pos)
 			{
 				auto & cat = *get(pos.cat);
-				if (pos.item < cat.items.size())
+				if (pos.item < cat.size())
 				{
 					if (cat.model_ptr)
 					{
@@ -3129,7 +4584,18 @@ namespace nana
 					}
 
 					cat.items.erase(cat.items.begin() + pos.item);
-					cat.sorted.erase(std::find(cat.sorted.begin(), cat.sorted.end(), cat.items.size()));
+					cat.sorted.erase(std::find(cat.sorted.begin(), cat.sorted.end(), cat.size()));
+					cat.selection.shift_erase(pos.item);
+					cat.shift_widths(pos.item, false);
+					cat.modified();
+
+					if (cat.filter)
+					{
+						cat.filter->matched.erase(cat.filter->matched.begin() + pos.item);
+						cat.make_display_order();
+					}
+					else
+						cat.rows_changed();
 
 					sort();
 				}
@@ -3144,7 +4610,7 @@ namespace nana
 					bool good = false;
 					for (size_type i = 0, size = categories_.size(); i < size; ++i) // run all cat
 					{
-						if(size_item(i))
+						if(size_display(i))
 						{
 							//The first category which contains at least one item.
 							next_selected_dpl.cat = i;
@@ -3163,7 +4629,7 @@ namespace nana
 					{
 						if(good(next_selected_dpl.cat))
 						{
-							if (size_item(next_selected_dpl.cat) > next_selected_dpl.item + 1)
+							if (size_display(next_selected_dpl.cat) > next_selected_dpl.item + 1)
 							{
 								++next_selected_dpl.item;
 							}
@@ -3191,9 +4657,9 @@ namespace nana
 								else
 									--next_selected_dpl.cat;
 
-							}while (0 == size_item(next_selected_dpl.cat));
+							}while (0 == size_display(next_selected_dpl.cat));
 
-							next_selected_dpl.item = size_item(next_selected_dpl.cat) - 1;
+							next_selected_dpl.item = size_display(next_selected_dpl.cat) - 1;
 						}
 						else
 							--next_selected_dpl.item;
@@ -3203,7 +4669,7 @@ namespace nana
 					{
 						expand(next_selected_dpl.cat, true); // revise expand
 
-						if (good(next_selected_dpl))
+						if (next_selected_dpl.item < size_display(next_selected_dpl.cat))
 						{
 							if (unselect_previous && !single_selection_)
 								select_for_all(false);
@@ -3237,14 +4703,15 @@ namespace nana
 
 					for (auto i : cat.sorted)
 					{
-						auto& item = cat.items[i];
-						if (item.flags.selected || !exp_opt.only_selected_items)
+						if (cat.is_selected(i) || !exp_opt.only_selected_items)
 						{
 							//Test if the category have a model set.
-							if (pcell)
+							if (cat.virt)
+								cat.virt->model->fetch(i, model_cells);
+							else if (pcell)
 								cat.model_ptr->container()->to_cells(i).swap(model_cells);
 							
-							list_str += (item.to_string(exp_opt, pcell) + exp_opt.endl);
+							list_str += (cat.item_view(i).to_string(exp_opt, pcell) + exp_opt.endl);
 						}
 					}
 				}
@@ -3257,9 +4724,15 @@ namespace nana
 
 				if (for_selection)
 				{
-					cat_proxy cpx{ ess_, pos };
-					for (item_proxy &it : cpx)
-						it.select(value);
+					auto & cat = *get(pos);
+					if (value && single_selection_)
+					{
+						//Only the last item remains selected, as if the items are selected one by one.
+						if (cat.size())
+							item_proxy{ ess_, index_pair{ pos, cat.size() - 1 } }.select(true);
+					}
+					else
+						this->assign_selection(cat, pos, (value ? interval_set{ 0, cat.size() } : interval_set{}));
 
 					latest_selected_abs.cat = pos;
 					latest_selected_abs.item = npos;
@@ -3268,17 +4741,16 @@ namespace nana
 				}
 				else
 				{
-					auto & items = get(pos)->items;
-					size_type index = 0;
-					for (auto & m : items)
+					auto cat = get(pos);
+					for (size_type index = 0, size = cat->size(); index < size; ++index)
 					{
-						if (m.flags.checked != value)
+						auto & flags = cat->flags(index);
+						if (flags.checked != value)
 						{
-							m.flags.checked = value;
+							flags.checked = value;
 							this->emit_cs(index_pair{ pos, index }, false);
 							changed = true;
 						}
-						++index;
 					}
 				}
 				return changed;
@@ -3726,7 +5198,7 @@ namespace nana
 
 							if (i_categ->expand)
 							{
-								auto size = i_categ->items.size();
+								auto size = i_categ->size();
 								for (; idx.item < size; ++idx.item)
 								{
 									if (item_coord.y > visual_r.bottom())
@@ -3785,9 +5257,9 @@ namespace nana
 					auto graph = essence_->graph;
 
 					item_data item;
-					item.flags.selected = categ.selected();
+					const bool selected = categ.selected();
 
-					this->_m_draw_item_bground(bground_r, bgcolor, {}, state, item);
+					this->_m_draw_item_bground(bground_r, bgcolor, {}, state, item, selected);
 
 					color txt_color{ static_cast<color_rgb>(0x3399) };
 
@@ -3811,7 +5283,7 @@ namespace nana
 					if (categ.display_number)
 					{
 						//Display the number of items in the category
-						native_string_type str = to_nstring('(' + std::to_string(categ.items.size()) + ')');
+						native_string_type str = to_nstring('(' + std::to_string(categ.display_size()) + ')');
 						graph->string({ x + 25 + static_cast<int>(text_px), y + txtoff }, str);
 						text_px += graph->text_extent_size(str).width;
 					}
@@ -3824,11 +5296,11 @@ namespace nana
 					}
 
 					//Draw selecting inner rectangle
-					if (item.flags.selected && (categ.expand == false))
+					if (selected && (categ.expand == false))
 						_m_draw_item_border(y);
 				}
 
-				color _m_draw_item_bground(const rectangle& bground_r, color bgcolor, color cell_color, item_state state, const item_data& item)
+				color _m_draw_item_bground(const rectangle& bground_r, color bgcolor, color cell_color, item_state state, const item_data& item, bool selected)
 				{
 					auto graph = essence_->graph;
 
@@ -3837,7 +5309,7 @@ namespace nana
 					if (is_transparent)
 						bgcolor = color{};
 
-					if (item.flags.selected)
+					if (selected)
 					{
 						bgcolor = essence_->scheme_ptr->item_selected;
 
@@ -3851,7 +5323,7 @@ namespace nana
 
 					if (item_state::highlighted == state)
 					{
-						if (item.flags.selected)
+						if (selected)
 							bgcolor = bgcolor.blend(essence_->scheme_ptr->item_highlighted, 0.5);
 						else
 							bgcolor = bgcolor.blend(essence_->scheme_ptr->item_highlighted, 0.7);
@@ -3884,7 +5356,9 @@ namespace nana
 					              item_state state
 					)
 				{
-					auto & item = cat.items[item_pos.item];
+					auto & item = cat.item_view(item_pos.item);
+					const auto flags = cat.flags(item_pos.item);
+					const bool selected = cat.is_selected(item_pos.item);
 
 					std::vector<cell> model_cells;
 					if (cat.model_ptr)
@@ -3907,7 +5381,7 @@ namespace nana
 						coord.y,
 						columns_shown_width + essence_->content_view->origin().x,
 						essence_->item_height() };
-					auto const state_bgcolor = this->_m_draw_item_bground(bground_r, bgcolor, {}, state, item);
+					auto const state_bgcolor = this->_m_draw_item_bground(bground_r, bgcolor, {}, state, item, selected);
 
 					//The position of column in x-axis.
 					int column_x = coord.x;
@@ -3945,7 +5419,7 @@ namespace nana
 									}
 
 									using state = facade<element::crook>::state;
-									crook_renderer_.check(item.flags.checked ? state::checked : state::unchecked);
+									crook_renderer_.check(flags.checked ? state::checked : state::unchecked);
 								}
 
 								if (essence_->if_image)
@@ -4001,8 +5475,8 @@ namespace nana
 									inline_wdg->pane_widget.size(sz);
 									inline_wdg->inline_ptr->resize(sz);
 
-									inline_wdg->inline_ptr->notify_status(status_type::selected, item.flags.selected);
-									inline_wdg->inline_ptr->notify_status(status_type::checked, item.flags.checked);
+									inline_wdg->inline_ptr->notify_status(status_type::selected, selected);
+									inline_wdg->inline_ptr->notify_status(status_type::checked, flags.checked);
 									
 									inline_wdg->indicator->attach(item_pos, inline_wdg);
 
@@ -4031,7 +5505,7 @@ namespace nana
 									col_fgcolor = m_cell.custom_format->fgcolor;
 
 									bground_r = rectangle{ column_x, coord.y, col.width_px, essence_->item_height() };
-									col_bgcolor = this->_m_draw_item_bground(bground_r, bgcolor, m_cell.custom_format->bgcolor, state, item);
+									col_bgcolor = this->_m_draw_item_bground(bground_r, bgcolor, m_cell.custom_format->bgcolor, state, item, selected);
 								}
 								else
 									col_bgcolor = state_bgcolor;
@@ -4068,7 +5542,7 @@ namespace nana
 					}
 
 					//Draw selecting inner rectangle
-					if (item.flags.selected)
+					if (selected)
 						_m_draw_item_border(coord.y);
 				}
 
@@ -4184,6 +5658,8 @@ namespace nana
 					if (graph.text_metrics(as, ds, il))
 						essence_->text_height = as + ds;
 
+					essence_->lister.discard_widths();
+
 					essence_->calc_content_size(true);
 				}
 
@@ -4328,10 +5804,10 @@ namespace nana
 
 						if ((essence_->column_from_pos(arg.pos.x) != npos) && !item_pos.empty())
 						{
-							auto * item_ptr = (item_pos.is_category() ? nullptr : &lister.at(item_pos));
-
 							const auto abs_item_pos = lister.index_cast_noexcept(item_pos, true, item_pos);	//convert display position to absolute position
 
+							auto * flags_ptr = (item_pos.is_category() ? nullptr : &lister.get(abs_item_pos.cat)->flags(abs_item_pos.item));
+
 							if(ptr_where.first == parts::list)
 							{
 								//adjust the display of selected into the list rectangle if the part of the item is beyond the top/bottom edge
@@ -4367,10 +5843,7 @@ namespace nana
 
 										auto before = lister.latest_selected_abs;
 
-										lister.select_display_range_if(lister.latest_selected_abs, item_pos, true, [](const index_pair&)
-										{
-											return true;
-										});
+										lister.select_display_range(lister.latest_selected_abs, item_pos, true);
 
 										lister.latest_selected_abs = before;
 									}
@@ -4406,13 +5879,13 @@ namespace nana
 								{
 									//Clicking on a category is ignored when single selection is enabled.
 									//Fixed by Greentwip(issue #121)
-									if (item_ptr)
+									if (flags_ptr)
 										new_selected_status = !item_proxy(essence_, abs_item_pos).selected();
 								}
 
-								if(item_ptr)
+								if(flags_ptr)
 								{
-									if (item_ptr->flags.selected != new_selected_status)
+									if (lister.get(abs_item_pos.cat)->is_selected(abs_item_pos.item) != new_selected_status)
 									{
 										if (new_selected_status)
 										{
@@ -4423,8 +5896,7 @@ namespace nana
 										else if (essence_->lister.latest_selected_abs == abs_item_pos)
 											essence_->lister.latest_selected_abs.set_both(npos);
 
-										item_ptr->flags.selected = new_selected_status;
-										lister.emit_cs(abs_item_pos, true);
+										lister.select_range(abs_item_pos, 1, new_selected_status);
 									}
 								}
 								else
@@ -4436,17 +5908,19 @@ namespace nana
 							}
 							else
 							{
-								if (item_ptr)
+								if (flags_ptr)
 								{
-									item_ptr->flags.checked = !item_ptr->flags.checked;
+									flags_ptr->checked = !flags_ptr->checked;
 									lister.emit_cs(abs_item_pos, false);
 
-									if (item_ptr->flags.checked)
+									if (flags_ptr->checked)
 										lister.cancel_others_if_single_enabled(false, abs_item_pos);
 								}
 								else if (!lister.single_status(false))	//not single checked
 									lister.cat_status_reverse(item_pos.cat, false);
 							}
+
+							lister.emit_selection_changed();
 							update = true;
 						}
 
@@ -4526,6 +6000,8 @@ namespace nana
 						//Don't deselect if the predicate returns false
 						if(!(essence_->pred_msup_deselect && !essence_->pred_msup_deselect(arg.button)))
 							need_refresh |= essence_->lister.select_for_all(false, essence_->operation.item);
+
+						essence_->lister.emit_selection_changed();
 					}
 
 					if (need_refresh)
@@ -4685,7 +6161,7 @@ namespace nana
 								{
 									if (keyboard::os_home == arg.key)
 									{
-										while (0 == list.size_item(pos.cat))
+										while (0 == list.size_display(pos.cat))
 										{
 											if (++pos.cat >= list.cat_container().size())
 											{
@@ -4696,7 +6172,7 @@ namespace nana
 									}
 									else
 									{
-										while (0 == list.size_item(pos.cat))
+										while (0 == list.size_display(pos.cat))
 										{
 											if (pos.cat-- == 0)
 											{
@@ -4732,6 +6208,8 @@ namespace nana
 					default:
 						return;
 					}
+
+					essence_->lister.emit_selection_changed();
 					refresh(graph);
 					API::dev::lazy_refresh();
 				}
@@ -4752,6 +6230,7 @@ namespace nana
 						if (!essence_->lister.single_status(true))
 						{
 							essence_->lister.select_for_all(true);
+							essence_->lister.emit_selection_changed();
 							refresh(graph);
 							API::dev::lazy_refresh();
 						}
@@ -4794,8 +6273,9 @@ namespace nana
 					if (!ess_->lister.get(pos_.cat)->expand)
 						return false;
 
-					auto pos = to_display();
-					if (ess_->first_display() > pos)
+					//A hidden item is not displayed
+					auto pos = ess_->lister.index_cast_noexcept(pos_, false);
+					if (pos.empty() || ess_->first_display() > pos)
 						return false;
 
 					auto last = ess_->lister.advance(ess_->first_display(), static_cast<int>(ess_->count_of_exposed(false)));
@@ -4811,15 +6291,18 @@ namespace nana
 				item_proxy & item_proxy::check(bool ck, bool scroll_view)
 				{
 					internal_scope_guard lock;
-					auto & m = cat_->items.at(pos_.item);
-					if(m.flags.checked != ck)
+					auto & flags = cat_->flags(pos_.item);
+					if(flags.checked != ck)
 					{
-						m.flags.checked = ck;
+						flags.checked = ck;
 						ess_->lister.emit_cs(pos_, false);
 						if (scroll_view)
 						{
-							if (ess_->lister.get(pos_.cat)->expand)
-								ess_->lister.get(pos_.cat)->expand = false;
+							if (cat_->expand)
+							{
+								cat_->expand = false;
+								cat_->rows_changed();
+							}
 
 							if (!this->displayed())
 								ess_->lister.scroll_into_view(pos_, (ess_->first_display() > this->to_display() ? view_action::top_view : view_action::bottom_view));
@@ -4832,7 +6315,7 @@ namespace nana
 
 				bool item_proxy::checked() const
 				{
-					return cat_->items.at(pos_.item).flags.checked;
+					return cat_->flags(pos_.item).checked;
 				}
 
 				/// is ignored if no change (maybe set last_selected anyway??), but if change emit event, deselect others if need ans set/unset last_selected
@@ -4840,18 +6323,13 @@ namespace nana
 				{
 					internal_scope_guard lock;
 
-					//pos_ never represents a category if this item_proxy is available.
-					auto & m = cat_->items.at(pos_.item);       // a ref to the real item
-
 					//ignore if no change
-					if(m.flags.selected == s)
+					if(cat_->is_selected(pos_.item) == s)
 						return *this;
 
-					m.flags.selected = s;                       // actually change selection
+					ess_->lister.select_range(pos_, 1, s);	// actually change selection
 
-					ess_->lister.emit_cs(this->pos_, true);
-
-					if (m.flags.selected)
+					if (s)
 					{
 						ess_->lister.cancel_others_if_single_enabled(true, pos_);	//Cancel all selections except pos_ if single_selection is enabled.
 						ess_->lister.latest_selected_abs = pos_;
@@ -4859,7 +6337,9 @@ namespace nana
 					else if (ess_->lister.latest_selected_abs == pos_)
 						ess_->lister.latest_selected_abs.set_both(npos);
 
-					if (scroll_view && (!this->displayed()))
+					ess_->lister.emit_selection_changed();
+
+					if (scroll_view && (!this->displayed()) && !ess_->lister.index_cast_noexcept(pos_, false).empty())
 						ess_->lister.scroll_into_view(pos_, (ess_->first_display() > this->to_display() ? view_action::top_view : view_action::bottom_view));
 
 					ess_->update();
@@ -4868,31 +6348,31 @@ namespace nana
 
 				bool item_proxy::selected() const
 				{
-					return cat_->items.at(pos_.item).flags.selected;
+					return cat_->is_selected(pos_.item);
 				}
 
 				item_proxy & item_proxy::bgcolor(const nana::color& col)
 				{
-					cat_->items.at(pos_.item).bgcolor = col;
+					cat_->item(pos_.item).bgcolor = col;
 					ess_->update();
 					return *this;
 				}
 
 				nana::color item_proxy::bgcolor() const
 				{
-					return cat_->items.at(pos_.item).bgcolor;
+					return cat_->item_view(pos_.item).bgcolor;
 				}
 
 				item_proxy& item_proxy::fgcolor(const nana::color& col)
 				{
-					cat_->items.at(pos_.item).fgcolor = col;
+					cat_->item(pos_.item).fgcolor = col;
 					ess_->update();
 					return *this;
 				}
 
 				nana::color item_proxy::fgcolor() const
 				{
-					return cat_->items.at(pos_.item).fgcolor;
+					return cat_->item_view(pos_.item).fgcolor;
 				}
 
 				std::size_t item_proxy::columns() const noexcept
@@ -4935,7 +6415,7 @@ namespace nana
 				{
 					if (img)
 					{
-						auto & item = cat_->items.at(pos_.item);
+						auto & item = cat_->item(pos_.item);
 						item.img = img;
 						nana::fit_zoom(img.size(), nana::size(16, 16), item.img_show_size);
 
@@ -4991,7 +6471,7 @@ namespace nana
 				// Behavior of Iterator
 				item_proxy & item_proxy::operator++()
 				{
-					if (++pos_.item >= cat_->items.size())
+					if (++pos_.item >= cat_->size())
 						cat_ = nullptr;
 
 					return *this;
@@ -5002,7 +6482,7 @@ namespace nana
 				{
 					item_proxy ip(*this);
 
-					if (++pos_.item >= cat_->items.size())
+					if (++pos_.item >= cat_->size())
 						cat_ = nullptr;
 					return ip;
 				}
@@ -5076,6 +6556,19 @@ namespace nana
 
 			//class cat_proxy
 
+				/// Clears the cells which contain a null character only
+				static void erase_null_cells(std::vector<cell>& cells)
+				{
+					for (auto & cl : cells)
+					{
+						if (cl.text.size() == 1 && cl.text[0] == wchar_t(0))
+						{
+							cl.text.clear();
+							cl.custom_format.reset();
+						}
+					}
+				}
+
 			//the member cat_ is used for fast accessing to the category
 				cat_proxy::cat_proxy(essence * ess, size_type pos) noexcept
 					:	ess_(ess),
@@ -5104,6 +6597,66 @@ namespace nana
 					return{ cat_->model_ptr.get() };
 				}
 
+				void cat_proxy::virtual_model(std::size_t rows, virtual_fetcher fetcher, std::size_t cache_rows)
+				{
+					if (!fetcher)
+						throw std::invalid_argument("nana::listbox, the fetcher of virtual model is empty");
+
+					internal_scope_guard lock;
+					_m_reset_model(new virtual_model_container(rows, std::move(fetcher), cache_rows));
+				}
+
+				void cat_proxy::virtual_size(std::size_t rows)
+				{
+					internal_scope_guard lock;
+					if (!cat_->virt)
+						throw std::runtime_error("nana::listbox, the category is not virtual");
+
+					auto & virt = *cat_->virt;
+					if (rows < virt.flags.size())
+					{
+						virt.attributes.erase(virt.attributes.lower_bound(rows), virt.attributes.end());
+
+						if ((ess_->lister.latest_selected_abs.cat == pos_) && (ess_->lister.latest_selected_abs.item != npos) && (ess_->lister.latest_selected_abs.item >= rows))
+							ess_->lister.latest_selected_abs.set_both(npos);
+					}
+
+					virt.flags.resize(rows);
+					virt.model->resize(rows);
+					cat_->selection.truncate(rows);
+
+					for (auto & col : cat_->widths)
+					{
+						if (rows < col.size())
+							col.resize(rows);
+					}
+
+					cat_->modified();
+					cat_->make_sort_order();
+					ess_->lister.refilter(*cat_);
+					ess_->lister.sort();
+					ess_->update();
+				}
+
+				void cat_proxy::virtual_refresh()
+				{
+					internal_scope_guard lock;
+					if (cat_->virt)
+					{
+						cat_->virt->model->invalidate();
+						cat_->widths.clear();
+						cat_->modified();
+						ess_->lister.refilter(*cat_);
+						ess_->lister.sort();
+						ess_->update();
+					}
+				}
+
+				bool cat_proxy::is_virtual() const
+				{
+					return (cat_->virt != nullptr);
+				}
+
 				void cat_proxy::append(std::initializer_list<std::string> arg)
 				{
 					const auto items = columns();
@@ -5132,22 +6685,68 @@ namespace nana
 					}
 				}
 
+				void cat_proxy::append_range(std::vector<std::vector<cell>> rows)
+				{
+					internal_scope_guard lock;
+
+					const auto first = cat_->size();
+					if (cat_->model_ptr)
+					{
+						es_lister::throw_if_immutable_model(cat_->model_ptr.get());
+
+						auto container = cat_->model_ptr->container();
+						for (auto & cells : rows)
+						{
+							erase_null_cells(cells);
+
+							auto item_index = container->size();
+							container->emplace_back();
+							container->assign(item_index, cells);
+						}
+
+						cat_->items.resize(first + rows.size());
+					}
+					else
+					{
+						const auto cols = columns();
+						for (auto & cells : rows)
+						{
+							erase_null_cells(cells);
+
+							cells.resize(cols);
+							cat_->items.emplace_back(std::move(cells));
+						}
+					}
+
+					cat_->sorted.reserve(first + rows.size());
+					for (auto i = first; i < cat_->size(); ++i)
+						cat_->sorted.push_back(i);
+
+					cat_->modified();
+					cat_->rows_changed();
+
+					ess_->lister.filter_appended(*cat_);
+
+					//Sorts and refreshes once for all the items
+					ess_->lister.sort();
+					ess_->update();
+				}
+
 				cat_proxy & cat_proxy::select(bool sel)
                 {
-                    for (item_proxy &it : *this )
-                        it.select(sel);
+                    internal_scope_guard lock;
 
-                    ess_->lister.latest_selected_abs = index_pair {this->pos_, npos};
+                    //It sets the latest selected to this category
+                    ess_->lister.cat_status(pos_, true, sel);
+                    ess_->lister.emit_selection_changed();
+                    ess_->update();
 
                     return *this;
                 }
 
 				bool cat_proxy::selected() const
                 {
-                    for (item_proxy &it : *this )
-                        if (!it.selected())
-                            return false;
-                    return true;
+                    return ess_->lister.cat_status(pos_, true);
                 }
 
 				cat_proxy& cat_proxy::display_number(bool display)
@@ -5171,6 +6770,7 @@ namespace nana
 					if ((expand != cat_->expand) && pos_)
 					{
 						cat_->expand = expand;
+						cat_->rows_changed();
 						ess_->update();
 					}
 					return *this;
@@ -5217,7 +6817,7 @@ namespace nana
 
 					ess_->lister.throw_if_immutable_model(index_pair{ pos_ });
 
-					cat_->sorted.push_back(cat_->items.size());
+					cat_->sorted.push_back(cat_->size());
 
 					if (cat_->model_ptr)
 					{
@@ -5236,6 +6836,9 @@ namespace nana
 					else
 						cat_->items.emplace_back(std::move(s));
 
+					cat_->modified();
+					cat_->rows_changed();
+					ess_->lister.filter_appended(*cat_);
 					ess_->update();
 				}
 
@@ -5243,7 +6846,7 @@ namespace nana
 				item_proxy cat_proxy::begin() const
 				{
 					auto i = ess_->lister.get(pos_);
-					if (i->items.empty())
+					if (i->size() == 0)
 						return end();
 
 					return item_proxy(ess_, index_pair(pos_, 0));
@@ -5275,10 +6878,10 @@ namespace nana
 
 				item_proxy cat_proxy::back() const
 				{
-					if (cat_->items.empty())
+					if (cat_->size() == 0)
 						throw std::runtime_error("listbox.back() no element in the container.");
 
-					return item_proxy(ess_, index_pair(pos_, cat_->items.size() - 1));
+					return item_proxy(ess_, index_pair(pos_, cat_->size() - 1));
 				}
 
 				size_type cat_proxy::index_cast(size_type from, bool from_display_order) const
@@ -5293,7 +6896,7 @@ namespace nana
 
 				size_type cat_proxy::size() const
 				{
-					return cat_->items.size();
+					return cat_->size();
 				}
 
 				// Behavior of Iterator
@@ -5385,15 +6988,7 @@ namespace nana
 
 				void cat_proxy::_m_append(std::vector<cell> && cells)
 				{
-					//check invalid cells
-					for (auto & cl : cells)
-					{
-						if (cl.text.size() == 1 && cl.text[0] == wchar_t(0))
-						{
-							cl.text.clear();
-							cl.custom_format.reset();
-						}
-					}
+					erase_null_cells(cells);
 
 					internal_scope_guard lock;
 
@@ -5415,7 +7010,10 @@ namespace nana
 						cat_->items.emplace_back(std::move(cells));
 					}
 
-					cat_->sorted.push_back(cat_->items.size() - 1);
+					cat_->sorted.push_back(cat_->size() - 1);
+					cat_->modified();
+					cat_->rows_changed();
+					ess_->lister.filter_appended(*cat_);
 				}
 
 				void cat_proxy::_m_try_append_model(const const_virtual_pointer& dptr)
@@ -5429,8 +7027,11 @@ namespace nana
 					if (!cat_->model_ptr->container()->push_back(dptr))
 						throw std::invalid_argument("nana::listbox, the type of operand object is mismatched with model container value_type");
 
-					cat_->sorted.push_back(cat_->items.size());
+					cat_->sorted.push_back(cat_->size());
 					cat_->items.emplace_back();
+					cat_->modified();
+					cat_->rows_changed();
+					ess_->lister.filter_appended(*cat_);
 				}
 
 				void cat_proxy::_m_cat_by_pos() noexcept
@@ -5458,11 +7059,25 @@ namespace nana
 					if (ess_->listbox_ptr)
 					{
 						cat_->model_ptr.reset(p);
+						cat_->virt.reset();
 						cat_->items.clear();
+						cat_->selection.clear();
+						cat_->widths.clear();
+						cat_->modified();
 
-						cat_->items.resize(cat_->model_ptr->container()->size());
+						//The rows of a virtual model are not stored in items, only their states are allocated.
+						auto virt_model = dynamic_cast<virtual_model_container*>(p);
+						if (virt_model)
+						{
+							cat_->virt.reset(new category_t::virtual_rows);
+							cat_->virt->model = virt_model;
+							cat_->virt->flags.resize(p->container()->size());
+						}
+						else
+							cat_->items.resize(cat_->model_ptr->container()->size());
 
 						cat_->make_sort_order();
+						ess_->lister.refilter(*cat_);
 						ess_->lister.sort();
 
 						//Don't ignore the auto-draw flag for performance enhancement.
@@ -5486,6 +7101,11 @@ namespace nana
     {
     }
 
+	arg_listbox_selection::arg_listbox_selection(::nana::listbox& wdg) noexcept
+		: widget(wdg)
+	{
+	}
+
 	//class listbox
 
 		listbox::listbox(window wd, bool visible)
@@ -5852,7 +7472,7 @@ namespace nana
 			int new_pos = origin.y;
 
 			auto start_pos = static_cast<int>(ess.lister.distance(ess.lister.first(), index_pair{cat, npos}) * ess.item_height());
-			auto count = static_cast<int>(ess.lister.size_item(cat) * ess.item_height());
+			auto count = static_cast<int>(ess.lister.size_display(cat) * ess.item_height());
 			if (start_pos + count <= origin.y)
 				new_pos = origin.y - static_cast<int>(count);
 			else if (start_pos < origin.y && origin.y < start_pos + count)
@@ -5891,7 +7511,7 @@ namespace nana
 			auto start_pos = ess.content_position(index_pair{ cat, npos });
 
 			int new_pos = origin.y;
-			auto count = static_cast<int>((ess.lister.size_item(cat) + 1) * ess.item_height());
+			auto count = static_cast<int>((ess.lister.size_display(cat) + 1) * ess.item_height());
 			if (start_pos + count <= origin.y)
 				new_pos = origin.y - static_cast<int>(count);
 			else if (start_pos < origin.y && origin.y < start_pos + count)
@@ -5931,7 +7551,7 @@ namespace nana
 			for (auto & pos : indexes)
 			{
 				auto & cat = *ess.lister.get(pos.cat);
-				if (pos.item < cat.items.size())
+				if (pos.item < cat.size())
 				{
 					if (cat.model_ptr)
 					{
@@ -5940,6 +7560,12 @@ namespace nana
 					}
 
 					cat.items.erase(cat.items.begin() + pos.item);
+					cat.selection.shift_erase(pos.item);
+					cat.shift_widths(pos.item, false);
+					cat.modified();
+
+					if (cat.filter)
+						cat.filter->matched.erase(cat.filter->matched.begin() + pos.item);
 				}
 			}
 
@@ -6007,6 +7633,24 @@ namespace nana
 			_m_ess().header.at(col).weak_ordering = std::move(strick_ordering);
 		}
 
+		void listbox::set_sort_key(size_type col, sort_key kind)
+		{
+			internal_scope_guard lock;
+			_m_ess().header.at(col).key_kind = kind;
+		}
+
+		void listbox::async_sort(bool enable)
+		{
+			internal_scope_guard lock;
+			_m_ess().lister.async_sort(enable);
+		}
+
+		bool listbox::async_sort() const
+		{
+			internal_scope_guard lock;
+			return _m_ess().lister.async_sort();
+		}
+
         /// sort() and invalidates any existing reference from display position to absolute item, that is: after sort() display offset point to different items
         void listbox::sort_col(size_type col, bool reverse)
 		{
@@ -6034,6 +7678,55 @@ namespace nana
 			return !_m_ess().lister.active_sort(!freeze);
 		}
 
+		void listbox::filter(size_type col, std::string text, bool case_sensitive)
+		{
+			if (text.empty())
+				return unfilter();
+
+			drawerbase::listbox::filter_engine::query q;
+			q.column = col;
+			q.text = std::move(text);
+			q.case_sensitive = case_sensitive;
+
+			internal_scope_guard lock;
+			_m_ess().lister.filter(std::move(q), false);
+		}
+
+		void listbox::filter(filter_predicate pred, bool narrowing)
+		{
+			if (!pred)
+				return unfilter();
+
+			drawerbase::listbox::filter_engine::query q;
+			q.pred = std::move(pred);
+
+			internal_scope_guard lock;
+			_m_ess().lister.filter(std::move(q), narrowing);
+		}
+
+		void listbox::unfilter()
+		{
+			internal_scope_guard lock;
+			auto & ess = _m_ess();
+
+			//The filtering in progress is cancelled even if no filter is applied.
+			const bool filtered = ess.lister.filtered();
+			ess.lister.unfilter();
+
+			if (filtered)
+			{
+				ess.calc_content_size(false);
+				ess.content_view->sync(false);
+				ess.update();
+			}
+		}
+
+		bool listbox::filtered() const
+		{
+			internal_scope_guard lock;
+			return _m_ess().lister.filtered();
+		}
+
 		auto listbox::selected() const -> index_pairs
 		{
 			internal_scope_guard lock;
@@ -6057,6 +7750,7 @@ namespace nana
 		{
 			internal_scope_guard lock;
 			_m_ess().lister.move_select(upwards, true, true);
+			_m_ess().lister.emit_selection_changed();
 			_m_ess().update();
 		}
 
@@ -6074,6 +7768,7 @@ namespace nana
 		{
 			internal_scope_guard lock;
 			_m_ess().lister.enable_single(for_selection, category_limited);
+			_m_ess().lister.emit_selection_changed();
 		}
 
 		void listbox::disable_single(bool for_selection)
@@ -6157,7 +7852,7 @@ namespace nana
 				}
 				else
 				{
-					auto const count = (std::min)(_m_ess().lister.size_item(idx.cat) - idx.item, n);
+					auto const count = (std::min)(_m_ess().lister.size_display(idx.cat) - idx.item, n);
 					for (std::size_t i = 0; i < count; ++i)
 					{
 						indexes.push_back(idx);
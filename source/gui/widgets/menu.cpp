@@ -147,8 +147,8 @@ namespace nana
 					graph.palette(true, at.enabled ? colors::black : colors::gray_border);
 					nana::paint::text_renderer tr(graph);
 
-					auto wstr = to_wstring(text);
-					tr.render(pos, wstr.c_str(), wstr.length(), text_pixels, paint::text_renderer::mode::truncate_with_ellipsis);
+					utf::scratch_wstring wstr{ text };
+					tr.render(pos, wstr.data(), wstr.size(), text_pixels, paint::text_renderer::mode::truncate_with_ellipsis);
 				}
 
 				void sub_arrow(graph_reference graph, const nana::point& pos, unsigned pixels, const attr&)
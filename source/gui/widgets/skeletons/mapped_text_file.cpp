@@ -0,0 +1,275 @@
+/*
+ *	A memory mapped text file
+ *	Nana C++ Library(http://www.nanapro.org)
+ *	Copyright(C) 2003-2019 Jinhao(cnjinhao@hotmail.com)
+ *
+ *	Distributed under the Boost Software License, Version 1.0.
+ *	(See accompanying file LICENSE_1_0.txt or copy at
+ *	http://www.boost.org/LICENSE_1_0.txt)
+ *
+ *	@file: nana/gui/widgets/skeletons/mapped_text_file.cpp
+ */
+
+#include <nana/gui/widgets/skeletons/mapped_text_file.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <cstring>
+
+#if defined(NANA_WINDOWS)
+#	include <windows.h>
+#else
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+namespace nana
+{
+namespace widgets
+{
+namespace skeletons
+{
+	struct mapped_text_file::implementation
+	{
+		/// The number of bytes which are scanned before the indexed lines are published.
+		static constexpr std::size_t chunk_size = 1024 * 1024;
+
+		const char* data{ nullptr };
+		std::size_t size{ 0 };
+#if defined(NANA_WINDOWS)
+		HANDLE file{ INVALID_HANDLE_VALUE };
+		HANDLE mapping{ nullptr };
+#endif
+		std::unique_ptr<std::thread> indexer;
+		std::atomic<bool> stop{ false };
+
+		mutable std::mutex mutex;
+		mutable std::condition_variable finished_cond;
+		std::vector<std::size_t> line_begins;	//The indexed lines which are not fetched
+		std::size_t scanned{ 0 };
+		bool finished{ false };
+
+		bool map(const path_type& path)
+		{
+#if defined(NANA_WINDOWS)
+			file = ::CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (INVALID_HANDLE_VALUE == file)
+				return false;
+
+			LARGE_INTEGER bytes;
+			if (!::GetFileSizeEx(file, &bytes))
+				return false;
+
+			size = static_cast<std::size_t>(bytes.QuadPart);
+			if (0 == size)
+				return true;
+
+			mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (nullptr == mapping)
+				return false;
+
+			data = static_cast<const char*>(::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			return (nullptr != data);
+#else
+			int fd = ::open(path.string().c_str(), O_RDONLY);
+			if (fd < 0)
+				return false;
+
+			struct stat st;
+			if (::fstat(fd, &st) < 0)
+			{
+				::close(fd);
+				return false;
+			}
+
+			size = static_cast<std::size_t>(st.st_size);
+			if (0 == size)
+			{
+				::close(fd);
+				return true;
+			}
+
+			auto ptr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);	//The mapping is still valid after the descriptor is closed.
+
+			if (MAP_FAILED == ptr)
+				return false;
+
+#if defined(POSIX_MADV_SEQUENTIAL)
+			::posix_madvise(ptr, size, POSIX_MADV_SEQUENTIAL);
+#endif
+			data = static_cast<const char*>(ptr);
+			return true;
+#endif
+		}
+
+		void unmap()
+		{
+#if defined(NANA_WINDOWS)
+			if (data)
+				::UnmapViewOfFile(data);
+
+			if (mapping)
+				::CloseHandle(mapping);
+
+			if (INVALID_HANDLE_VALUE != file)
+				::CloseHandle(file);
+
+			mapping = nullptr;
+			file = INVALID_HANDLE_VALUE;
+#else
+			if (data)
+				::munmap(const_cast<char*>(data), size);
+#endif
+			data = nullptr;
+			size = 0;
+		}
+
+		/// Scans the lines from pos to the end of chunk. It returns the end of chunk.
+		std::size_t scan(std::size_t pos, std::size_t chunk_end, std::vector<std::size_t>& found) const
+		{
+			while (pos < chunk_end)
+			{
+				auto p = static_cast<const char*>(std::memchr(data + pos, '\n', chunk_end - pos));
+				if (nullptr == p)
+					break;
+
+				pos = static_cast<std::size_t>(p - data) + 1;
+				found.push_back(pos);
+			}
+			return chunk_end;
+		}
+
+		void publish(std::vector<std::size_t>& found, std::size_t scanned_bytes, bool end)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			line_begins.insert(line_begins.end(), found.begin(), found.end());
+			scanned = scanned_bytes;
+			finished = end;
+
+			if (end)
+				finished_cond.notify_all();
+
+			found.clear();
+		}
+
+		void run_indexer(std::size_t pos)
+		{
+			std::vector<std::size_t> found;
+			while (pos < size)
+			{
+				if (stop)
+					break;
+
+				pos = scan(pos, (size - pos > chunk_size ? pos + chunk_size : size), found);
+				publish(found, pos, false);
+			}
+
+			publish(found, size, true);
+		}
+	};
+
+	mapped_text_file::mapped_text_file()
+		: impl_(new implementation)
+	{
+	}
+
+	mapped_text_file::~mapped_text_file()
+	{
+		close();
+		delete impl_;
+	}
+
+	bool mapped_text_file::open(const path_type& file, std::size_t skip)
+	{
+		close();
+
+		if (!impl_->map(file))
+		{
+			impl_->unmap();
+			return false;
+		}
+
+		if (skip > impl_->size)
+			skip = impl_->size;
+
+		//Scans the first line synchronously, it makes the first line available when open() returns.
+		std::vector<std::size_t> found;
+		auto pos = skip;
+		while (pos < impl_->size && found.empty())
+			pos = impl_->scan(pos, (impl_->size - pos > implementation::chunk_size ? pos + implementation::chunk_size : impl_->size), found);
+
+		impl_->publish(found, pos, (pos == impl_->size));
+
+		if (pos < impl_->size)
+		{
+			impl_->stop = false;
+			impl_->indexer.reset(new std::thread([this, pos]{
+				impl_->run_indexer(pos);
+			}));
+		}
+		return true;
+	}
+
+	void mapped_text_file::close()
+	{
+		if (impl_->indexer)
+		{
+			impl_->stop = true;
+			impl_->indexer->join();
+			impl_->indexer.reset();
+		}
+
+		impl_->unmap();
+
+		impl_->line_begins.clear();
+		impl_->scanned = 0;
+		impl_->finished = false;
+	}
+
+	const char* mapped_text_file::data() const
+	{
+		return impl_->data;
+	}
+
+	std::size_t mapped_text_file::size() const
+	{
+		return impl_->size;
+	}
+
+	bool mapped_text_file::fetch(std::vector<std::size_t>& line_begins)
+	{
+		std::lock_guard<std::mutex> lock(impl_->mutex);
+		if (line_begins.empty())
+			line_begins.swap(impl_->line_begins);
+		else
+		{
+			line_begins.insert(line_begins.end(), impl_->line_begins.begin(), impl_->line_begins.end());
+			impl_->line_begins.clear();
+		}
+
+		return impl_->finished;
+	}
+
+	void mapped_text_file::wait() const
+	{
+		std::unique_lock<std::mutex> lock(impl_->mutex);
+		impl_->finished_cond.wait(lock, [this]{ return impl_->finished; });
+	}
+
+	double mapped_text_file::progress() const
+	{
+		std::lock_guard<std::mutex> lock(impl_->mutex);
+		if (impl_->finished || (0 == impl_->size))
+			return 1.0;
+
+		return static_cast<double>(impl_->scanned) / static_cast<double>(impl_->size);
+	}
+}//end namespace skeletons
+}//end namespace widgets
+}//end namespace nana
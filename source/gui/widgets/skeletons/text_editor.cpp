@@ -16,6 +16,7 @@
 #include <nana/system/dataexch.hpp>
 #include <nana/unicode_bidi.hpp>
 #include <nana/gui/widgets/widget.hpp>
+#include <nana/gui/timer.hpp>
 #include "content_view.hpp"
 
 #include <deque>
@@ -24,6 +25,10 @@
 #include <cstring>
 #include <algorithm>
 #include <map>
+#include <list>
+#include <unordered_map>
+#include <limits>
+#include <chrono>
 
 namespace nana {
 	namespace widgets
@@ -40,6 +45,9 @@ namespace nana {
 				virtual EnumCommand get() const = 0;
 				virtual bool merge(const undoable_command_interface&) = 0;
 				virtual void execute(bool redo) = 0;
+
+				/// Returns the number of bytes the command occupies, it is used for limiting the memory of undoable.
+				virtual std::size_t bytes() const = 0;
 			};
 
 			template<typename EnumCommand>
@@ -53,13 +61,14 @@ namespace nana {
 				{
 					commands_.clear();
 					pos_ = 0;
+					bytes_ = 0;
 				}
 
 				void max_steps(std::size_t maxs)
 				{
 					max_steps_ = maxs;
 					if (maxs && (commands_.size() >= maxs))
-						commands_.erase(commands_.begin(), commands_.begin() + (commands_.size() - maxs + 1));
+						_m_evict(commands_.size() - maxs + 1);
 				}
 
 				std::size_t max_steps() const
@@ -67,25 +76,72 @@ namespace nana {
 					return max_steps_;
 				}
 
+				/// Sets the maximum number of bytes the commands occupy, the oldest commands are discarded when it is exceeded. 0 means unlimited.
+				void max_bytes(std::size_t maxb)
+				{
+					max_bytes_ = maxb;
+					_m_fit_bytes();
+				}
+
+				std::size_t max_bytes() const
+				{
+					return max_bytes_;
+				}
+
+				/// Returns the number of bytes the commands occupy.
+				std::size_t bytes() const noexcept
+				{
+					return bytes_;
+				}
+
 				void push(std::unique_ptr<undoable_command_interface<command>> && ptr)
 				{
 					if (!ptr)
 						return;
 
 					if (pos_ < commands_.size())
-						commands_.erase(commands_.begin() + pos_, commands_.end());
+						_m_erase_back(pos_);
 					else if (max_steps_ && (commands_.size() >= max_steps_))
-						commands_.erase(commands_.begin(), commands_.begin() + (commands_.size() - max_steps_ + 1));
+						_m_erase_front(commands_.size() - max_steps_ + 1);
 
 					pos_ = commands_.size();
 					if (!commands_.empty())
 					{
+						auto const before = commands_.back()->bytes();
 						if (commands_.back().get()->merge(*ptr))
+						{
+							bytes_ = bytes_ - before + commands_.back()->bytes();
+							_m_fit_bytes();
 							return;
+						}
 					}
 
+					bytes_ += ptr->bytes();
 					commands_.emplace_back(std::move(ptr));
 					++pos_;
+					_m_fit_bytes();
+				}
+
+				/// Amends the last command instead of pushing a new command.
+				/**
+				 * It is unavailable if the last command is undone.
+				 * @param fn A function which amends the command and returns true, or returns false if the command can't be amended.
+				 * @return true if the last command is amended.
+				 */
+				template<typename Function>
+				bool amend(Function fn)
+				{
+					if ((0 == pos_) || (pos_ != commands_.size()))
+						return false;
+
+					auto & last = *commands_.back();
+					auto const before = last.bytes();
+					if (!fn(last))
+						return false;
+
+					bytes_ = bytes_ - before + last.bytes();
+					_m_fit_bytes();
+					return true;
 				}
 
 				std::size_t count(bool is_undo) const noexcept
@@ -104,10 +160,56 @@ namespace nana {
 					if (pos_ != commands_.size())
 						commands_[pos_++].get()->execute(true);
 				}
+			private:
+				/// Discards n commands. The undone commands are kept as long as possible, the oldest commands
+				/// which are done are discarded first, and then the undone commands which are farthest from redoing.
+				void _m_evict(std::size_t n)
+				{
+					auto const front = (std::min)(n, pos_);
+					if (front)
+						_m_erase_front(front);
+
+					if (n > front)
+						_m_erase_back(commands_.size() - (std::min)(n - front, commands_.size()));
+				}
+
+				void _m_erase_front(std::size_t n)
+				{
+					for (std::size_t i = 0; i < n; ++i)
+						bytes_ -= commands_[i]->bytes();
+
+					//Only the commands which are done are erased from the front
+					commands_.erase(commands_.begin(), commands_.begin() + n);
+					pos_ -= n;
+				}
+
+				void _m_erase_back(std::size_t pos)
+				{
+					for (auto i = pos; i < commands_.size(); ++i)
+						bytes_ -= commands_[i]->bytes();
+
+					commands_.erase(commands_.begin() + pos, commands_.end());
+				}
+
+				/// Discards the commands by _m_evict() until the bytes fit the limit. The last command is discarded
+				/// as well if it alone exceeds the limit, a huge paste shouldn't be kept for undoing.
+				void _m_fit_bytes()
+				{
+					if (0 == max_bytes_)
+						return;
 
+					std::size_t n = 0;
+					for (auto bytes = bytes_; (n < commands_.size()) && (bytes > max_bytes_); ++n)
+						bytes -= commands_[(n < pos_ ? n : commands_.size() - 1 - (n - pos_))]->bytes();
+
+					if (n)
+						_m_evict(n);
+				}
 			private:
 				container commands_;
 				std::size_t max_steps_{ 30 };
+				std::size_t max_bytes_{ 0 };
+				std::size_t bytes_{ 0 };	//The number of bytes the commands occupy
 				std::size_t pos_{ 0 };
 			};
 
@@ -149,6 +251,11 @@ namespace nana {
 				{
 					return false;
 				}
+
+				std::size_t bytes() const override
+				{
+					return sizeof(*this) + selected_text_.capacity() * sizeof(wchar_t);
+				}
 			protected:
 				text_editor & editor_;
 				upoint			pos_;
@@ -293,8 +400,41 @@ namespace nana {
 					editor_.textbase().text_changed();
 					editor_.reset_caret();
 				}
+
+				std::size_t bytes() const override
+				{
+					return basic_undoable<command>::bytes() + text_.capacity() * sizeof(wchar_t);
+				}
+
+				/// Appends a typed character to the input text, so that a run of typing is undone as a whole.
+				/**
+				 * The character is appended only if the input text is typed, and the character is typed at the end
+				 * of input text. A run of typing is broken at the beginning of a word.
+				 * @param caret The position where the character is typed.
+				 */
+				bool append(wchar_t ch, const upoint& caret)
+				{
+					if ((!typed_) || !selected_text_.empty() || ('\n' == ch) || ('\r' == ch))
+						return false;
+
+					if ((caret.y != pos_.y) || (caret.x != pos_.x + text_.size()))
+						return false;
+
+					if (std::iswspace(text_.back()) && !std::iswspace(ch))
+						return false;
+
+					text_ += ch;	//The capacity grows geometrically, most of the characters are appended without allocation
+					return true;
+				}
+
+				/// Marks the input text as a typed character, the following typed characters can be appended.
+				void set_typed()
+				{
+					typed_ = (1 == text_.size()) && ('\n' != text_[0]) && ('\r' != text_[0]);
+				}
 			private:
 				std::wstring text_;
+				bool typed_{ false };
 			};
 
 			class text_editor::undo_move_text
@@ -381,6 +521,188 @@ namespace nana {
 				const keyword_scheme * scheme;
 			};
 
+			/// A keyword found in a line, the positions are relative to the beginning of the line.
+			struct keyword_span
+			{
+				std::size_t begin;
+				std::size_t end;
+				const keyword_scheme * scheme;
+			};
+
+			/// An Aho-Corasick automaton which is compiled from the keywords, it finds all the keywords of a text in one pass.
+			/**
+			 * The keywords are stored in the trie in uppercase, so that the case-insensitive keywords are matched
+			 * by the automaton directly, and the case-sensitive keywords are compared with the text once more when they are matched.
+			 */
+			class keyword_automaton
+			{
+				static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+				struct pattern
+				{
+					std::wstring text;
+					const keyword_scheme * scheme;
+					bool case_sensitive;
+					bool whole_word_matched;
+				};
+
+				struct node
+				{
+					std::vector<std::pair<wchar_t, std::size_t>> next;	//The transitions, sorted by character
+					std::vector<std::size_t> patterns;					//The patterns which end at this node
+					std::size_t fail{ 0 };
+					std::size_t dict{ npos };							//The nearest node on the failure path which ends some patterns
+				};
+			public:
+				keyword_automaton(const std::deque<keyword_desc>& base, const std::map<std::string, std::shared_ptr<keyword_scheme>>& schemes)
+					: nodes_(1)
+				{
+					for (auto & ds : base)
+					{
+						auto ki = schemes.find(ds.scheme);
+						if (ds.text.empty() || (ki == schemes.end()) || !ki->second)
+							continue;
+
+						std::size_t state = 0;
+						for (auto chr : ds.text)
+						{
+							chr = _m_fold(chr);
+
+							auto & next = nodes_[state].next;
+							auto i = std::lower_bound(next.begin(), next.end(), chr, [](const std::pair<wchar_t, std::size_t>& tr, wchar_t c)
+							{
+								return tr.first < c;
+							});
+
+							if ((i == next.end()) || (i->first != chr))
+							{
+								next.emplace(i, chr, nodes_.size());
+								state = nodes_.size();
+								nodes_.emplace_back();	//next is invalidated
+							}
+							else
+								state = i->second;
+						}
+
+						nodes_[state].patterns.push_back(patterns_.size());
+						patterns_.push_back(pattern{ ds.text, ki->second.get(), ds.case_sensitive, ds.whole_word_matched });
+					}
+
+					//Calculates the failure links in breadth-first order, the failure link of a node
+					//always refers to a shallower node whose links are calculated.
+					std::vector<std::size_t> queue;
+					for (auto & tr : nodes_[0].next)
+						queue.push_back(tr.second);
+
+					for (std::size_t qpos = 0; qpos < queue.size(); ++qpos)
+					{
+						auto const state = queue[qpos];
+						for (auto & tr : nodes_[state].next)
+						{
+							auto & child = nodes_[tr.second];
+							child.fail = _m_next(nodes_[state].fail, tr.first);
+							child.dict = (nodes_[child.fail].patterns.empty() ? nodes_[child.fail].dict : child.fail);
+							queue.push_back(tr.second);
+						}
+					}
+				}
+
+				/// Finds the keywords of the text, the overlapped keywords are discarded except the first one.
+				void find(const wchar_t* text, std::size_t len, std::vector<keyword_span>& spans) const
+				{
+					struct found
+					{
+						std::size_t begin;
+						std::size_t end;
+						std::size_t order;
+					};
+					std::vector<found> matches;
+
+					std::size_t state = 0;
+					for (std::size_t i = 0; i < len; ++i)
+					{
+						state = _m_next(state, _m_fold(text[i]));
+
+						for (auto out = (nodes_[state].patterns.empty() ? nodes_[state].dict : state); out != npos; out = nodes_[out].dict)
+						{
+							for (auto order : nodes_[out].patterns)
+							{
+								auto & pat = patterns_[order];
+								auto const begin = i + 1 - pat.text.size();
+
+								if (pat.case_sensitive && !std::equal(pat.text.begin(), pat.text.end(), text + begin))
+									continue;
+
+								if (pat.whole_word_matched && !_m_whole_word(text, len, begin, pat.text.size()))
+									continue;
+
+								matches.push_back(found{ begin, i + 1, order });
+							}
+						}
+					}
+
+					//If the keywords begin at the same position, the keyword which is set earlier wins.
+					std::sort(matches.begin(), matches.end(), [](const found& a, const found& b)
+					{
+						return (a.begin != b.begin ? a.begin < b.begin : a.order < b.order);
+					});
+
+					std::size_t bound = 0;
+					for (auto & m : matches)
+					{
+						if (m.begin < bound)
+							continue;	//Erase overlapping
+
+						spans.push_back(keyword_span{ m.begin, m.end, patterns_[m.order].scheme });
+						bound = m.end;
+					}
+				}
+			private:
+				std::size_t _m_next(std::size_t state, wchar_t chr) const
+				{
+					while (true)
+					{
+						auto & next = nodes_[state].next;
+						auto i = std::lower_bound(next.begin(), next.end(), chr, [](const std::pair<wchar_t, std::size_t>& tr, wchar_t c)
+						{
+							return tr.first < c;
+						});
+
+						if ((i != next.end()) && (i->first == chr))
+							return i->second;
+
+						if (0 == state)
+							return 0;
+
+						state = nodes_[state].fail;
+					}
+				}
+
+				static wchar_t _m_fold(wchar_t chr)
+				{
+					if (chr < 0x80)
+						return (('a' <= chr && chr <= 'z') ? static_cast<wchar_t>(chr - 'a' + 'A') : chr);
+
+					return static_cast<wchar_t>(std::towupper(chr));
+				}
+
+				static bool _m_is_word_char(wchar_t chr)
+				{
+					return ((std::iswalpha(chr) && !std::iswspace(chr)) || chr == '_');
+				}
+
+				static bool _m_whole_word(const wchar_t* text, std::size_t len, std::size_t pos, std::size_t n)
+				{
+					if (pos && _m_is_word_char(text[pos - 1]))
+						return false;
+
+					return !((pos + n < len) && _m_is_word_char(text[pos + n]));
+				}
+			private:
+				std::vector<node> nodes_;
+				std::vector<pattern> patterns_;
+			};
+
 			enum class sync_graph
 			{
 				none,
@@ -517,11 +839,211 @@ namespace nana {
 
 				struct inner_keywords
 				{
+					/// The maximum number of lines whose keywords are cached
+					static constexpr std::size_t max_cached_lines = 4096;
+
 					std::map<std::string, std::shared_ptr<keyword_scheme>> schemes;
 					std::deque<keyword_desc> base;
+					std::size_t generation{ 0 };	//It is increased when the keywords or the schemes are changed
+
+					std::unique_ptr<keyword_automaton> automaton;	//It is compiled from base when it is used
+
+					/// The matches of finding text, they are highlighted over the keywords
+					struct match_highlight
+					{
+						std::unique_ptr<text_matcher> matcher;
+						keyword_scheme scheme;
+					}matches;
+
+					struct line_cache
+					{
+						std::size_t revision{ 0 };	//The revision of textbase which the cached lines belong to
+						std::unordered_map<std::size_t, std::vector<keyword_span>> lines;
+					}cache;
+
+					/// Discards the automaton and the cached lines, it is called when the keywords or the schemes are changed.
+					void changed()
+					{
+						++generation;
+						automaton.reset();
+						cache.lines.clear();
+					}
+
+					bool empty() const
+					{
+						return (base.empty() && !matches.matcher);
+					}
+
+					const keyword_automaton& compiled()
+					{
+						if (!automaton)
+							automaton.reset(new keyword_automaton(base, schemes));
+						return *automaton;
+					}
+
+					/// Returns the keywords of a line, they are found again only if the text is edited.
+					const std::vector<keyword_span>& spans(std::size_t line, const std::wstring& text, std::size_t revision)
+					{
+						if ((cache.revision != revision) || (cache.lines.size() >= max_cached_lines))
+						{
+							cache.lines.clear();
+							cache.revision = revision;
+						}
+
+						auto i = cache.lines.find(line);
+						if (i != cache.lines.end())
+							return i->second;
+
+						auto & spans = cache.lines[line];
+						compiled().find(text.c_str(), text.size(), spans);
+
+						if (matches.matcher)
+							_m_merge_matches(text, spans);
+
+						return spans;
+					}
+				private:
+					/// Merges the matches into the keywords, the keywords which are overlapped with a match are discarded.
+					void _m_merge_matches(const std::wstring& text, std::vector<keyword_span>& spans) const
+					{
+						std::vector<keyword_span> merged;
+						std::size_t k = 0;
+
+						auto const size = matches.matcher->size();
+						matches.matcher->for_each(text.data(), text.size(), [&](std::size_t found)
+						{
+							for (; (k < spans.size()) && (spans[k].begin < found + size); ++k)
+							{
+								if (spans[k].end <= found)
+									merged.push_back(spans[k]);
+							}
+
+							merged.push_back(keyword_span{ found, found + size, &matches.scheme });
+						});
+
+						merged.insert(merged.end(), spans.begin() + k, spans.end());
+						spans.swap(merged);
+					}
 				}keywords;
 
 				std::unique_ptr<content_view> cview;
+
+				std::unique_ptr<timer> loading_timer;	//Fetches the indexed lines of a lazily loaded file
+
+				/// The bitmaps of drawn text sections. A section which is not selected is copied from its bitmap
+				/// if it is drawn again with the same line revision, position, colors and keywords.
+				struct render_cache_rep
+				{
+					/// The maximum bytes of bitmaps, the least recently used sections are discarded when it is exceeded.
+					static constexpr std::size_t max_bytes = 8 * 1024 * 1024;
+
+					using key_type = std::pair<std::size_t, std::size_t>;	//The revision of the line and the position of section
+
+					struct section
+					{
+						std::size_t length;		//The number of characters of the section
+						int x;					//The position where the section is drawn
+						int area_left;
+						int area_right;
+						::nana::color fgcolor;
+						::nana::color bgcolor;
+						std::size_t keywords;	//The generation of keywords
+						int bitmap_x;			//The position where the bitmap is copied
+						paint::graphics bitmap;	//It is empty if the section is out of the text area
+						std::list<key_type>::iterator used;	//The position in the list of recently used sections
+					};
+
+					::nana::color background;	//The background of text, it is invisible if the background is not plain
+					std::map<key_type, section> sections;
+					std::list<key_type> recently_used;	//The most recently used section is at front
+					std::size_t bytes{ 0 };
+
+					std::size_t frames{ 0 };
+					double last_ms{ 0 };
+					double total_ms{ 0 };
+					std::size_t cached{ 0 };
+					std::size_t drawn{ 0 };
+
+					void clear()
+					{
+						sections.clear();
+						recently_used.clear();
+						bytes = 0;
+					}
+
+					/// Copies the section from its bitmap if it is not changed. It returns false if the section has to be drawn.
+					bool draw(paint::graphics& graph, std::size_t revision, std::size_t pos, std::size_t length, const point& pos_px, const rectangle& area, const ::nana::color& fgcolor, std::size_t keywords)
+					{
+						auto i = sections.find(key_type{ revision, pos });
+						if (i == sections.end())
+							return false;
+
+						auto & sct = i->second;
+						if ((sct.length != length) || (sct.x != pos_px.x) || (sct.area_left != area.x) || (sct.area_right != area.right()) ||
+							(sct.fgcolor != fgcolor) || (sct.bgcolor != background) || (sct.keywords != keywords))
+							return false;
+
+						if (!sct.bitmap.empty())
+							graph.bitblt(rectangle{ sct.bitmap_x, pos_px.y, sct.bitmap.width(), sct.bitmap.height() }, sct.bitmap);
+
+						recently_used.splice(recently_used.begin(), recently_used, sct.used);
+						++cached;
+						return true;
+					}
+
+					/// Keeps the bitmap of a drawn section, the section is drawn in [pos_px.x, end_x).
+					void store(paint::graphics& graph, std::size_t revision, std::size_t pos, std::size_t length, const point& pos_px, int end_x, unsigned line_px, const rectangle& area, const ::nana::color& fgcolor, std::size_t keywords)
+					{
+						//The section is kept only if it is drawn inside the text area vertically, otherwise the bitmap would contain the border.
+						if ((pos_px.y < area.y) || (pos_px.y + static_cast<int>(line_px) > area.bottom()))
+							return;
+
+						auto const left = (std::max)(pos_px.x, area.x);
+						auto const right = (std::min)(end_x, area.right());
+						auto const width = static_cast<unsigned>(right > left ? right - left : 0);
+						auto const sct_bytes = static_cast<std::size_t>(width) * line_px * sizeof(pixel_argb_t);
+
+						key_type const key{ revision, pos };
+						_m_erase(sections.find(key));
+
+						while ((bytes + sct_bytes > max_bytes) && !recently_used.empty())
+							_m_erase(sections.find(recently_used.back()));
+
+						auto & sct = sections[key];
+						sct.length = length;
+						sct.x = pos_px.x;
+						sct.area_left = area.x;
+						sct.area_right = area.right();
+						sct.fgcolor = fgcolor;
+						sct.bgcolor = background;
+						sct.keywords = keywords;
+						sct.bitmap_x = left;
+						sct.used = recently_used.insert(recently_used.begin(), key);
+
+						if (width)
+						{
+							sct.bitmap.make({ width, line_px });
+							sct.bitmap.bitblt(rectangle{ 0, 0, width, line_px }, graph, point{ left, pos_px.y });
+						}
+
+						bytes += _m_bytes(sct);
+					}
+				private:
+					void _m_erase(std::map<key_type, section>::iterator i)
+					{
+						if (i == sections.end())
+							return;
+
+						bytes -= _m_bytes(i->second);
+						recently_used.erase(i->second.used);
+						sections.erase(i);
+					}
+
+					static std::size_t _m_bytes(const section& sct)
+					{
+						return static_cast<std::size_t>(sct.bitmap.width()) * sct.bitmap.height() * sizeof(pixel_argb_t);
+					}
+				}render_cache;
 			};
 
 
@@ -552,6 +1074,8 @@ namespace nana {
 				virtual std::size_t take_lines() const = 0;
 				/// Returns the number of lines that the line of text specified by pos takes.
 				virtual std::size_t take_lines(std::size_t pos) const = 0;
+				/// Returns the number of lines that the lines of text before pos take.
+				virtual std::size_t take_lines_before(std::size_t pos) const = 0;
 			};
 
 			inline bool is_right_text(const unicode_bidi::entity& e)
@@ -570,6 +1094,10 @@ namespace nana {
 
 				std::vector<text_section> line(std::size_t pos) const override
 				{
+					//The line is not measured if it was not decoded when it was calculated.
+					if (nullptr == this->sections_[pos].begin)
+						_m_measure(pos);
+
 					//Every line of normal behavior only has one text_section
 					std::vector<text_section> sections;
 					sections.emplace_back(this->sections_[pos]);
@@ -616,16 +1144,20 @@ namespace nana {
 #endif
 					pre_calc_line(first, 0);
 
-					//textbase is implement by using deque, and the linemtr holds the text pointers
+					//textbase moves the lines when lines are inserted or erased, and the linemtr holds the text pointers
 					//If the textbase is changed, it will check the text pointers.
 					std::size_t line = 0;
 
 					auto const & const_sections = sections_;
 					for (auto & sct : const_sections)
 					{
-						auto const& text = editor_.textbase().getline(line);
-						if (sct.begin < text.c_str() || (text.c_str() + text.size() < sct.begin))
-							pre_calc_line(line, 0);
+						//Skips the unmeasured line, it doesn't hold a text pointer
+						if (sct.begin)
+						{
+							auto const& text = editor_.textbase().getline(line);
+							if (sct.begin < text.c_str() || (text.c_str() + text.size() < sct.begin))
+								pre_calc_line(line, 0);
+						}
 
 						++line;
 					}
@@ -641,14 +1173,14 @@ namespace nana {
 #else
 							this->sections_.emplace(this->sections_.begin() + (pos + i));
 #endif
-						//textbase is implement by using deque, and the linemtr holds the text pointers
+						//textbase moves the lines when lines are inserted or erased, and the linemtr holds the text pointers
 						//If the textbase is changed, it will check the text pointers.
 						std::size_t line = 0;
 
 						auto const & const_sections = sections_;
 						for (auto & sct : const_sections)
 						{
-							if (line < pos || (pos + line_size) <= line)
+							if ((line < pos || (pos + line_size) <= line) && sct.begin)
 							{
 								auto const & text = editor_.textbase().getline(line);
 								if (sct.begin < text.c_str() || (text.c_str() + text.size() < sct.begin))
@@ -667,11 +1199,14 @@ namespace nana {
 
 				void pre_calc_line(std::size_t pos, unsigned) override
 				{
-					auto const & text = editor_.textbase().getline(pos);
-					auto& txt_section = this->sections_[pos];
-					txt_section.begin = text.c_str();
-					txt_section.end = txt_section.begin + text.size();
-					txt_section.pixels = editor_._m_text_extent_size(txt_section.begin, text.size()).width;
+					//Don't decode the line of a lazily loaded text, it is measured when it is displayed.
+					if (!editor_.textbase().decoded(pos))
+					{
+						this->sections_[pos] = text_section{};
+						return;
+					}
+
+					_m_measure(pos);
 				}
 
 				void pre_calc_lines(unsigned) override
@@ -691,9 +1226,23 @@ namespace nana {
 				{
 					return 1;
 				}
+
+				std::size_t take_lines_before(std::size_t pos) const override
+				{
+					return pos;
+				}
+			private:
+				void _m_measure(std::size_t pos) const
+				{
+					auto const & text = editor_.textbase().getline(pos);
+					auto& txt_section = this->sections_[pos];
+					txt_section.begin = text.c_str();
+					txt_section.end = txt_section.begin + text.size();
+					txt_section.pixels = editor_._m_text_extent_size(txt_section.begin, text.size()).width;
+				}
 			private:
 				text_editor& editor_;
-				std::vector<text_section> sections_;
+				mutable std::vector<text_section> sections_;	//A section of null pointer indicates an unmeasured line
 			}; //end class behavior_normal
 
 
@@ -702,8 +1251,8 @@ namespace nana {
 			{
 				struct line_metrics
 				{
-					std::size_t		take_lines;	//The number of lines that text of this line takes.
-					std::vector<text_section>	line_sections;
+					std::size_t		take_lines{ 1 };	//The number of lines that text of this line takes. It is an estimate if the line is not measured.
+					std::vector<text_section>	line_sections;	//It is empty if the line is not measured.
 				};
 			public:
 				behavior_linewrapped(text_editor& editor)
@@ -712,6 +1261,9 @@ namespace nana {
 
 				std::vector<text_section> line(std::size_t pos) const override
 				{
+					if (linemtr_[pos].line_sections.empty())
+						_m_measure(pos);
+
 					return linemtr_[pos].line_sections;
 				}
 
@@ -729,7 +1281,14 @@ namespace nana {
 					if (linemtr_.size() <= coord.first)
 					{
 						coord.first = linemtr_.size() - 1;
-						coord.second = linemtr_.back().line_sections.size() - 1;
+						coord.second = line(coord.first).size() - 1;
+					}
+					else
+					{
+						//The take_lines of the line may be estimated, the real sections can be fewer after the width is changed.
+						auto const sections = line(coord.first).size();
+						if (sections && (coord.second >= sections))
+							coord.second = sections - 1;
 					}
 					return coord;
 				}
@@ -745,7 +1304,10 @@ namespace nana {
 						std::swap(first, second);
 
 					if (second < linemtr_.size())
+					{
 						linemtr_.erase(linemtr_.begin() + first + 1, linemtr_.begin() + second + 1);
+						tree_dirty_ = true;
+					}
 
 					pre_calc_line(first, editor_.width_pixels());
 				}
@@ -757,14 +1319,17 @@ namespace nana {
 						for (std::size_t i = 0; i < lines; ++i)
 							linemtr_.emplace(linemtr_.begin() + pos + i);
 
-						//textbase is implement by using deque, and the linemtr holds the text pointers
+						tree_dirty_ = true;
+
+						//textbase moves the lines when lines are inserted or erased, and the linemtr holds the text pointers
 						//If the textbase is changed, it will check the text pointers.
 						std::size_t line = 0;
 
 						auto const & const_linemtr = linemtr_;
 						for (auto & mtr : const_linemtr)
 						{
-							if (line < pos || (pos + lines) <= line)
+							//The unmeasured lines don't hold text pointers.
+							if ((line < pos || (pos + lines) <= line) && !mtr.line_sections.empty())
 							{
 								auto & linestr = editor_.textbase().getline(line);
 								auto p = mtr.line_sections.front().begin;
@@ -780,10 +1345,76 @@ namespace nana {
 				{
 					auto const lines = editor_.textbase().lines();
 					linemtr_.resize(lines);
+					tree_dirty_ = true;
 				}
 
 				void pre_calc_line(std::size_t line, unsigned pixels) override
 				{
+					pixels_ = pixels;
+					_m_measure(line);
+				}
+
+				/// Measures the lines in the view immediately, the other lines are measured when the editor is idle.
+				/**
+				 * The measured lines are invalidated, and the number of lines they took are kept as estimates
+				 * until they are measured again, so that the scrolling is not disturbed when the width is changed.
+				 */
+				void pre_calc_lines(unsigned pixels) override
+				{
+					auto const top = _m_top_line();
+
+					pixels_ = pixels;
+					linemtr_.resize(editor_.textbase().lines());
+					for (auto & mtr : linemtr_)
+						mtr.line_sections.clear();
+
+					tree_dirty_ = true;
+
+					//Measures the lines in the view
+					std::size_t rows = 0;
+					std::size_t measured = 0;
+					auto const screen_lines = static_cast<std::size_t>(editor_.screen_lines()) + 1;
+					for (auto i = top.first; (i < linemtr_.size()) && (rows < screen_lines + top.second); ++i)
+					{
+						_m_measure(i);
+						rows += linemtr_[i].take_lines;
+						++measured;
+					}
+
+					//Measures the remaining lines when the editor is idle.
+					pending_ = 0;
+					if (linemtr_.size() > measured)
+					{
+						if (!idle_)
+						{
+							idle_.reset(new timer{ std::chrono::milliseconds{ 1 } });
+							idle_->elapse([this]{
+								this->_m_measure_pending();
+							});
+						}
+						idle_->start();
+					}
+				}
+
+				std::size_t take_lines() const override
+				{
+					return _m_prefix(linemtr_.size());
+				}
+
+				std::size_t take_lines(std::size_t pos) const override
+				{
+					return (pos < linemtr_.size() ? linemtr_[pos].take_lines : 0);
+				}
+
+				std::size_t take_lines_before(std::size_t pos) const override
+				{
+					return _m_prefix((std::min)(pos, linemtr_.size()));
+				}
+			private:
+				void _m_measure(std::size_t line) const
+				{
+					auto const pixels = pixels_;
+
 					const string_type& lnstr = editor_.textbase().getline(line);
 					if (lnstr.empty())
 					{
@@ -791,7 +1422,7 @@ namespace nana {
 						mtr.line_sections.clear();
 
 						mtr.line_sections.emplace_back(lnstr.c_str(), lnstr.c_str(), unsigned{});
-						mtr.take_lines = 1;
+						_m_take_lines(line, 1);
 						return;
 					}
 
@@ -857,43 +1488,132 @@ namespace nana {
 						}
 					}
 
-					auto & mtr = linemtr_[line];
+					auto & mtr = linemtr_[line];
+
+					mtr.line_sections.swap(line_sections);
+
+					if (secondary_begin)
+						mtr.line_sections.emplace_back(secondary_begin, sections.back().end, unsigned{ text_px });
+
+					_m_take_lines(line, mtr.line_sections.size());
+				}
+
+				/// Measures the unmeasured lines for a while, it is called when the editor is idle.
+				void _m_measure_pending()
+				{
+					auto & cview = *editor_.impl_->cview;
+					auto const line_px = static_cast<int>(editor_.line_height());
+
+					//The line at the top of view is kept when the lines before it are measured.
+					auto const top = _m_top_line();
+					auto const top_offset = (line_px ? cview.origin().y % line_px : 0);
+
+					//Every line takes one row at least, the lines in the view are before the bottom.
+					auto const bottom = top.first + static_cast<std::size_t>(editor_.screen_lines()) + 1;
+					bool view_measured = false;
+
+					auto const deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds{ 10 };
+					for (; pending_ < linemtr_.size(); ++pending_)
+					{
+						//Don't decode the lines of a lazily loaded text, they are measured when they are displayed.
+						if (linemtr_[pending_].line_sections.empty() && editor_.textbase().decoded(pending_))
+						{
+							_m_measure(pending_);
+							if (top.first <= pending_ && pending_ < bottom)
+								view_measured = true;
+
+							if (std::chrono::steady_clock::now() > deadline)
+							{
+								++pending_;
+								break;
+							}
+						}
+					}
+
+					auto const finished = (pending_ >= linemtr_.size());
+					if (finished)
+						idle_->stop();
 
-					mtr.take_lines = line_sections.size();
-					mtr.line_sections.swap(line_sections);
+					editor_._m_reset_content_size(false);
 
-					if (secondary_begin)
+					if (line_px && (top.first < linemtr_.size()))
 					{
-						mtr.line_sections.emplace_back(secondary_begin, sections.back().end, unsigned{ text_px });
-						++mtr.take_lines;
+						auto const row = take_lines_before(top.first) + (std::min)(top.second, linemtr_[top.first].take_lines - 1);
+						auto const origin_y = static_cast<int>(row) * line_px + top_offset;
+						if (cview.move_origin({ 0, origin_y - cview.origin().y }))
+							cview.sync(true);
+					}
+
+					editor_.reset_caret();
+
+					//The origin is moved with the top line, so the view is redrawn once after the batch, or when the lines in the view are measured.
+					if (finished || view_measured)
+					{
+						editor_.impl_->try_refresh = sync_graph::refresh;
+						if (editor_.try_refresh())
+							API::update_window(editor_.window_handle());
 					}
 				}
 
-				void pre_calc_lines(unsigned pixels) override
+				/// Returns the line and the secondary line at the top of view.
+				row_coordinate _m_top_line() const
 				{
-					auto const lines = editor_.textbase().lines();
-					linemtr_.resize(lines);
+					auto const line_px = static_cast<int>(editor_.line_height());
+					if (0 == line_px || linemtr_.empty())
+						return{};
 
-					for (std::size_t i = 0; i < lines; ++i)
-						pre_calc_line(i, pixels);
+					auto coord = _m_textline(static_cast<std::size_t>(editor_.impl_->cview->origin().y / line_px));
+					if (coord.first >= linemtr_.size())
+						return{ linemtr_.size() - 1, 0 };
+
+					return coord;
 				}
 
-				std::size_t take_lines() const override
+				void _m_take_lines(std::size_t line, std::size_t lines) const
 				{
-					std::size_t lines = 0;
-					for (auto & mtr : linemtr_)
-						lines += mtr.take_lines;
+					auto & mtr = linemtr_[line];
+					if (!tree_dirty_)
+					{
+						//Updates the Fenwick tree
+						for (auto i = line + 1; i <= tree_.size(); i += (i & (~i + 1)))
+							tree_[i - 1] += lines - mtr.take_lines;
+					}
+					mtr.take_lines = lines;
+				}
+
+				/// Returns the number of lines that the first n lines take
+				std::size_t _m_prefix(std::size_t n) const
+				{
+					_m_build_tree();
 
+					std::size_t lines = 0;
+					for (; n; n -= (n & (~n + 1)))
+						lines += tree_[n - 1];
 					return lines;
 				}
 
-				std::size_t take_lines(std::size_t pos) const override
+				void _m_build_tree() const
 				{
-					return (pos < linemtr_.size() ? linemtr_[pos].take_lines : 0);
+					if (!tree_dirty_)
+						return;
+
+					auto const count = linemtr_.size();
+					tree_.resize(count);
+					for (std::size_t i = 0; i < count; ++i)
+						tree_[i] = linemtr_[i].take_lines;
+
+					for (std::size_t i = 1; i <= count; ++i)
+					{
+						auto parent = i + (i & (~i + 1));
+						if (parent <= count)
+							tree_[parent - 1] += tree_[i - 1];
+					}
+
+					tree_dirty_ = false;
 				}
-			private:
+
 				/// Split a text into multiple sections, a section indicates an english word or a CKJ character
-				void _m_text_section(const std::wstring& str, std::vector<text_section>& tsec)
+				static void _m_text_section(const std::wstring& str, std::vector<text_section>& tsec)
 				{
 					if (str.empty())
 					{
@@ -930,128 +1650,184 @@ namespace nana {
 
 				row_coordinate _m_textline(std::size_t scrline) const
 				{
+					_m_build_tree();
+
+					auto const count = tree_.size();
+
+					std::size_t mask = 1;
+					while ((mask << 1) <= count)
+						mask <<= 1;
+
+					//Search the Fenwick tree for the last line whose preceding lines take not more than scrline.
 					row_coordinate coord;
-					for (auto & mtr : linemtr_)
+					for (; mask; mask >>= 1)
 					{
-						if (mtr.take_lines > scrline)
+						auto const next = coord.first + mask;
+						if (next <= count && tree_[next - 1] <= scrline)
 						{
-							coord.second = scrline;
-							return coord;
+							coord.first = next;
+							scrline -= tree_[next - 1];
 						}
-						else
-							scrline -= mtr.take_lines;
-
-						++coord.first;
 					}
+
+					coord.second = scrline;
 					return coord;
 				}
 			private:
 				text_editor& editor_;
-				std::vector<line_metrics> linemtr_;
+				mutable std::vector<line_metrics> linemtr_;	//The unmeasured lines are measured when they are accessed
+				mutable std::vector<std::size_t> tree_;		//The Fenwick tree of take_lines
+				mutable bool tree_dirty_{ false };
+				unsigned pixels_{ 0 };
+				std::size_t pending_{ 0 };				//The line where the idle measurement resumes
+				std::unique_ptr<timer> idle_;
 			}; //end class behavior_linewrapped
 
 			class text_editor::keyword_parser
 			{
 			public:
+				/// Parses the keywords of a text which is not a line of textbase, e.g. the mask characters.
 				void parse(const wchar_t* c_str, std::size_t len, implementation::inner_keywords& keywords) //need string_view
 				{
+					entities_.clear();
 					if (keywords.base.empty() || (0 == len) || (*c_str == 0))
 						return;
 
-					std::wstring text{ c_str, len };
+					std::vector<keyword_span> spans;
+					keywords.compiled().find(c_str, len, spans);
+					_m_assign(c_str, c_str, c_str + len, spans);
+				}
 
-					using index = std::wstring::size_type;
+				/// Parses the keywords of a part of line. The keywords are found in the whole line and cached.
+				void parse(std::size_t line, const std::wstring& line_str, const wchar_t* c_str, std::size_t len, std::size_t revision, implementation::inner_keywords& keywords)
+				{
+					entities_.clear();
+					if (keywords.empty() || (0 == len))
+						return;
 
-					std::vector<entity> entities;
+					_m_assign(line_str.c_str(), c_str, c_str + len, keywords.spans(line, line_str, revision));
+				}
 
-					::nana::ciwstring cistr;
-					for (auto & ds : keywords.base)
+				const std::vector<entity>& entities() const
+				{
+					return entities_;
+				}
+			private:
+				/// Assigns the keywords which are overlapped with [begin, end)
+				void _m_assign(const wchar_t* origin, const wchar_t* begin, const wchar_t* end, const std::vector<keyword_span>& spans)
+				{
+					for (auto & sp : spans)
 					{
-						index pos{ 0 };
-						for (index rest{ text.size() }; rest >= ds.text.size(); ++pos, rest = text.size() - pos)
-						{
-							if (ds.case_sensitive)
-							{
-								pos = text.find(ds.text, pos);
-								if (pos == text.npos)
-									break;
-							}
-							else
-							{
-								if (cistr.empty())
-									cistr.append(text.c_str(), text.size());
-
-								pos = cistr.find(ds.text.c_str(), pos);
-								if (pos == cistr.npos)
-									break;
-							}
+						if (origin + sp.end <= begin)
+							continue;
 
-							if (ds.whole_word_matched && (!_m_whole_word(text, pos, ds.text.size())))
-								continue;
+						if (end <= origin + sp.begin)
+							break;
 
-							auto ki = keywords.schemes.find(ds.scheme);
-							if ((ki != keywords.schemes.end()) && ki->second)
-							{
-#ifdef _nana_std_has_emplace_return_type
-								auto & last = entities.emplace_back();
-#else
-								entities.emplace_back();
-								auto & last = entities.back();
-#endif
-								last.begin = c_str + pos;
-								last.end = last.begin + ds.text.size();
-								last.scheme = ki->second.get();
-							}
-						}
+						entities_.push_back(entity{ origin + sp.begin, origin + sp.end, sp.scheme });
 					}
+				}
+			private:
+				std::vector<entity> entities_;
+			};
+
+			class text_editor::undo_replace_text
+				: public basic_undoable <command>
+			{
+			public:
+				undo_replace_text(text_editor& editor, const std::wstring& text, const std::wstring& replacement, bool case_sensitive, bool whole_word)
+					: basic_undoable<command>(editor, command::replace_text),
+					matcher_(text, case_sensitive, whole_word),
+					replacement_(replacement)
+				{}
+
+				/// Replaces all the matches and keeps the original lines for undoing. Returns the number of replacements.
+				std::size_t replace()
+				{
+					auto & textbase = editor_.textbase();
 
-					if (!entities.empty())
+					originals_.clear();
+
+					std::size_t count = 0;
+					for (std::size_t line = 0; line < textbase.lines(); ++line)
 					{
-						std::sort(entities.begin(), entities.end(), [](const entity& a, const entity& b)
+						auto & origin = textbase.getline(line);
+
+						std::wstring str;
+						std::size_t begin = 0;
+						matcher_.for_each(origin.data(), origin.size(), [&](std::size_t found)
 						{
-							return (a.begin < b.begin);
+							str.append(origin, begin, found - begin);
+							str += replacement_;
+							begin = found + matcher_.size();
+							++count;
 						});
 
-						auto i = entities.begin();
-						auto bound = i->end;
+						if (0 == begin)
+							continue;
 
-						for (++i; i != entities.end(); )
-						{
-							if (bound > i->begin)
-								i = entities.erase(i);  // erase overlapping. Left only the first.
-							else
-								++i;
-						}
+						str.append(origin, begin, origin.npos);
+
+						originals_.emplace_back(line, origin);
+						textbase.replace(line, std::move(str));
 					}
 
-					entities_.swap(entities);
+					if (count)
+						_m_update();
+
+					return count;
 				}
 
-				const std::vector<entity>& entities() const
+				void execute(bool redo) override
 				{
-					return entities_;
+					if (redo)
+					{
+						replace();
+						return;
+					}
+
+					auto & textbase = editor_.textbase();
+					for (auto & ln : originals_)
+						textbase.replace(ln.first, std::wstring{ ln.second });
+
+					_m_update();
+				}
+
+				std::size_t bytes() const override
+				{
+					//basic_undoable only counts its own size, the members of this class are added, and the matcher is
+					//counted by itself because its table of shifts is the largest part of the command.
+					auto bytes = basic_undoable<command>::bytes() + (sizeof(*this) - sizeof(basic_undoable<command>) - sizeof(matcher_)) + matcher_.bytes();
+
+					bytes += replacement_.capacity() * sizeof(wchar_t) + originals_.capacity() * sizeof(originals_.front());
+					for (auto & ln : originals_)
+						bytes += ln.second.capacity() * sizeof(wchar_t);
+					return bytes;
 				}
 			private:
-				static bool _m_whole_word(const std::wstring& text, std::wstring::size_type pos, std::size_t len)
+				/// Updates the replaced lines and refreshes the editor once
+				void _m_update()
 				{
-					if (pos)
-					{
-						auto chr = text[pos - 1];
-						if ((std::iswalpha(chr) && !std::iswspace(chr)) || chr == '_')
-							return false;
-					}
+					editor_._m_cancel_select(0);
 
-					if (pos + len < text.size())
-					{
-						auto chr = text[pos + len];
-						if ((std::iswalpha(chr) && !std::iswspace(chr)) || chr == '_')
-							return false;
-					}
+					auto & textbase = editor_.textbase();
+					editor_.points_.caret = pos_;
+					if (editor_.points_.caret.y < textbase.lines())
+						editor_.points_.caret.x = (std::min)(editor_.points_.caret.x, static_cast<unsigned>(textbase.getline(editor_.points_.caret.y).size()));
 
-					return true;
+					for (auto & ln : originals_)
+						editor_._m_pre_calc_lines(ln.first, 1);
+
+					editor_._m_reset_content_size(false);
+					textbase.text_changed();
+
+					editor_.reset_caret();
+					editor_.impl_->try_refresh = sync_graph::refresh;
 				}
 			private:
-				std::vector<entity> entities_;
+				text_matcher matcher_;
+				std::wstring replacement_;
+				std::vector<std::pair<std::size_t, std::wstring>> originals_;	//The replaced lines
 			};
 
 			//class text_editor
@@ -1103,6 +1879,7 @@ namespace nana {
 
 			void text_editor::set_highlight(const std::string& name, const ::nana::color& fgcolor, const ::nana::color& bgcolor)
 			{
+				impl_->keywords.changed();
 				if (fgcolor.invisible() && bgcolor.invisible())
 				{
 					impl_->keywords.schemes.erase(name);
@@ -1117,11 +1894,13 @@ namespace nana {
 
 			void text_editor::erase_highlight(const std::string& name)
 			{
+				impl_->keywords.changed();
 				impl_->keywords.schemes.erase(name);
 			}
 
 			void text_editor::set_keyword(const ::std::wstring& kw, const std::string& name, bool case_sensitive, bool whole_word_matched)
 			{
+				impl_->keywords.changed();
 				for (auto & ds : impl_->keywords.base)
 				{
 					if (ds.text == kw)
@@ -1138,6 +1917,7 @@ namespace nana {
 
 			void text_editor::erase_keyword(const ::std::wstring& kw)
 			{
+				impl_->keywords.changed();
 				for (auto i = impl_->keywords.base.begin(); i != impl_->keywords.base.end(); ++i)
 				{
 					if (kw == i->text)
@@ -1148,6 +1928,86 @@ namespace nana {
 				}
 			}
 
+			bool text_editor::find(const ::std::wstring& text, bool case_sensitive, bool whole_word, bool forward)
+			{
+				text_matcher matcher{ text, case_sensitive, whole_word };
+				if (matcher.empty())
+					return false;
+
+				//Searches after the selection forward, or before the selection backward.
+				nana::upoint a = points_.caret, b = points_.caret;
+				get_selected_points(a, b);
+
+				auto pos = (forward ? b : a);
+				if (!impl_->textbase.find(matcher, pos, forward))
+				{
+					//Wraps around
+					if (forward)
+						pos = upoint{};
+					else
+						pos = upoint{ (std::numeric_limits<unsigned>::max)(), static_cast<unsigned>(impl_->textbase.lines() - 1) };
+
+					if (!impl_->textbase.find(matcher, pos, forward))
+						return false;
+				}
+
+				select_.a = pos;
+				select_.b = upoint{ static_cast<unsigned>(pos.x + matcher.size()), pos.y };
+				select_.mode_selection = selection::mode::method_selected;
+				points_.caret = select_.b;
+
+				if (graph_)
+				{
+					if (this->_m_adjust_view())
+						impl_->cview->sync(false);
+
+					reset_caret();
+				}
+				impl_->try_refresh = sync_graph::refresh;
+				return true;
+			}
+
+			std::vector<upoint> text_editor::find_all(const ::std::wstring& text, bool case_sensitive, bool whole_word) const
+			{
+				std::vector<upoint> positions;
+				impl_->textbase.find_all(text_matcher{ text, case_sensitive, whole_word }, [&positions](const upoint& pos)
+				{
+					positions.push_back(pos);
+				});
+				return positions;
+			}
+
+			std::size_t text_editor::replace_all(const ::std::wstring& text, const ::std::wstring& replacement, bool case_sensitive, bool whole_word)
+			{
+				if (text.empty() || (replacement.find_first_of(L"\r\n") != replacement.npos))
+					return 0;
+
+				auto undo_ptr = std::unique_ptr<undo_replace_text>{ new undo_replace_text(*this, text, replacement, case_sensitive, whole_word) };
+				undo_ptr->set_caret_pos();
+
+				auto const count = undo_ptr->replace();
+				if (count)
+					impl_->undo.push(std::move(undo_ptr));
+
+				return count;
+			}
+
+			void text_editor::highlight_matches(const ::std::wstring& text, bool case_sensitive, bool whole_word, const ::nana::color& fgcolor, const ::nana::color& bgcolor)
+			{
+				impl_->keywords.changed();
+
+				auto & matches = impl_->keywords.matches;
+				if (text.empty())
+				{
+					matches.matcher.reset();
+					return;
+				}
+
+				matches.matcher.reset(new text_matcher{ text, case_sensitive, whole_word });
+				matches.scheme.fgcolor = fgcolor;
+				matches.scheme.bgcolor = bgcolor;
+			}
+
 			colored_area_access_interface& text_editor::colored_area()
 			{
 				return impl_->colored_area;
@@ -1280,6 +2140,7 @@ namespace nana {
 
 			void text_editor::typeface_changed()
 			{
+				impl_->render_cache.clear();
 				_m_reset_content_size(true);
 			}
 
@@ -1306,6 +2167,35 @@ namespace nana {
 				return true;
 			}
 
+			bool text_editor::load_lazily(const path_type& fs)
+			{
+				if (!impl_->textbase.load_lazily(fs))
+					return false;
+
+				_m_reset();
+
+				impl_->try_refresh = sync_graph::refresh;
+				_m_reset_content_size(true);
+
+				if (impl_->textbase.loading())
+				{
+					if (!impl_->loading_timer)
+					{
+						impl_->loading_timer.reset(new timer{ std::chrono::milliseconds{ 100 } });
+						impl_->loading_timer->elapse([this]{
+							this->_m_fetch_lines();
+						});
+					}
+					impl_->loading_timer->start();
+				}
+				return true;
+			}
+
+			double text_editor::load_progress() const
+			{
+				return impl_->textbase.load_progress();
+			}
+
 			void text_editor::text_align(::nana::align alignment)
 			{
 				this->attributes_.alignment = alignment;
@@ -1436,6 +2326,16 @@ namespace nana {
 				return impl_->undo.max_steps();
 			}
 
+			void text_editor::undo_max_bytes(std::size_t maxb)
+			{
+				impl_->undo.max_bytes(maxb);
+			}
+
+			std::size_t text_editor::undo_max_bytes() const
+			{
+				return impl_->undo.max_bytes();
+			}
+
 			auto text_editor::customized_renderers() -> renderers&
 			{
 				return impl_->customized_renderers;
@@ -2000,6 +2900,7 @@ namespace nana {
 
 			void text_editor::render(bool has_focus)
 			{
+				auto const start = std::chrono::steady_clock::now();
 				const auto bgcolor = _m_bgcolor();
 
 				auto fgcolor = scheme_->foreground.get_color();
@@ -2009,11 +2910,20 @@ namespace nana {
 				if (API::widget_borderless(window_))
 					graph_.rectangle(false, bgcolor);
 
+				auto & cache = impl_->render_cache;
+				cache.background = ::nana::color{};
+
 				//Draw background
 				if (!API::dev::copy_transparent_background(window_, graph_))
 				{
 					if (attributes_.enable_background)
+					{
 						graph_.rectangle(text_area_.area, true, bgcolor);
+
+						//The text can be cached only if it is drawn on a plain background
+						if (!(impl_->customized_renderers.background || impl_->counterpart.buffer))
+							cache.background = bgcolor;
+					}
 				}
 
 				if (impl_->customized_renderers.background)
@@ -2049,6 +2959,23 @@ namespace nana {
 
 				_m_draw_border();
 				impl_->try_refresh = sync_graph::none;
+
+				cache.last_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+				cache.total_ms += cache.last_ms;
+				++cache.frames;
+			}
+
+			text_render_statistics text_editor::render_statistics() const
+			{
+				auto & cache = impl_->render_cache;
+
+				text_render_statistics stats;
+				stats.frames = cache.frames;
+				stats.last_frame_ms = cache.last_ms;
+				stats.average_frame_ms = (cache.frames ? cache.total_ms / cache.frames : 0);
+				stats.cached_sections = cache.cached;
+				stats.drawn_sections = cache.drawn;
+				return stats;
 			}
 			//public:
 			void text_editor::put(std::wstring text, bool perform_event)
@@ -2087,16 +3014,27 @@ namespace nana {
 			{
 				std::wstring ch_str(1, ch);
 
-				auto undo_ptr = std::unique_ptr<undo_input_text>{ new undo_input_text(*this, ch_str) };
 				bool refresh = (select_.a != select_.b);
 
-				undo_ptr->set_selected_text();
-				if (refresh)
-					points_.caret = _m_erase_select(false);
+				//Appends the character to the last input if it continues the typing
+				bool amended = (!refresh) && impl_->undo.amend([this, ch](undoable_command_interface<command>& cmd)
+				{
+					return (command::input_text == cmd.get()) && static_cast<undo_input_text&>(cmd).append(ch, points_.caret);
+				});
 
-				undo_ptr->set_caret_pos();
+				if (!amended)
+				{
+					auto undo_ptr = std::unique_ptr<undo_input_text>{ new undo_input_text(*this, ch_str) };
+					undo_ptr->set_typed();
 
-				impl_->undo.push(std::move(undo_ptr));
+					undo_ptr->set_selected_text();
+					if (refresh)
+						points_.caret = _m_erase_select(false);
+
+					undo_ptr->set_caret_pos();
+
+					impl_->undo.push(std::move(undo_ptr));
+				}
 
 				auto secondary_before = impl_->capacities.behavior->take_lines(points_.caret.y);
 				textbase().insert(points_.caret, std::move(ch_str));
@@ -2663,6 +3601,24 @@ namespace nana {
 				return line_indexes;
 			}
 
+			void text_editor::_m_fetch_lines()
+			{
+				auto const lines = impl_->textbase.fetch_lines();
+				if (lines)
+				{
+					//The lines are appended to the end, they are measured when they are displayed.
+					impl_->capacities.behavior->prepare();
+					_m_reset_content_size(false);
+
+					impl_->try_refresh = sync_graph::refresh;
+					if (try_refresh())
+						API::update_window(window_);
+				}
+
+				if (!impl_->textbase.loading())
+					impl_->loading_timer->stop();
+			}
+
 			void text_editor::_m_pre_calc_lines(std::size_t line_off, std::size_t lines)
 			{
 				unsigned width_px = width_pixels();
@@ -2675,11 +3631,7 @@ namespace nana {
 				auto const behavior = impl_->capacities.behavior;
 				auto const sections = behavior->line(pos.y);
 
-				std::size_t lines = 0;	//lines before the caret line;
-				for (std::size_t i = 0; i < pos.y; ++i)
-				{
-					lines += behavior->take_lines(i);
-				}
+				auto lines = behavior->take_lines_before(pos.y);	//lines before the caret line;
 
 				const text_section * sct_ptr = nullptr;
 				nana::point scrpos;
@@ -2748,12 +3700,15 @@ namespace nana {
 
 				auto const behavior = impl_->capacities.behavior;
 
-				auto const row = behavior->text_position_from_screen(scrpos.y);
+				auto row = behavior->text_position_from_screen(scrpos.y);
 
 				auto sections = behavior->line(row.first);
 				if (sections.empty())
 					return{ 0, static_cast<unsigned>(row.first) };
 
+				if (row.second >= sections.size())
+					row.second = sections.size() - 1;
+
 				//First of all, find the text of secondary.
 				auto real_str = sections[row.second];
 
@@ -2891,10 +3846,14 @@ namespace nana {
 					const unsigned pixels = line_height();
 					const rectangle update_area = { text_area_.area.x, top, width_pixels(), static_cast<unsigned>(pixels * secondary_count_before) };
 
+					impl_->render_cache.background = ::nana::color{};
 					if (!API::dev::copy_transparent_background(window_, update_area, graph_, update_area.position()))
 					{
 						_m_draw_colored_area(graph_, { pos, 0 }, true);
 						graph_.rectangle(update_area, true, API::bgcolor(window_));
+
+						if (attributes_.enable_background && !(impl_->customized_renderers.background || impl_->counterpart.buffer))
+							impl_->render_cache.background = API::bgcolor(window_);
 					}
 					else
 						_m_draw_colored_area(graph_, { pos, 0 }, true);
@@ -3529,20 +4488,6 @@ namespace nana {
 
 				const auto focused = API::is_focus_ready(window_);
 
-				auto const reordered = unicode_reorder(text_ptr, text_len);
-
-				//Parse highlight keywords
-				keyword_parser parser;
-				parser.parse(text_ptr, text_len, impl_->keywords);
-
-				const auto line_h_pixels = line_height();
-
-				helper_pencil pencil(graph_, *this, parser);
-
-				graph_.palette(true, clr);
-				graph_.palette(false, scheme_->selection.get_color());
-
-
 				//Get the selection begin and end position of the current text.
 				const wchar_t *sbegin = nullptr, *send = nullptr;
 
@@ -3586,6 +4531,40 @@ namespace nana {
 					}
 				}
 
+				auto & line_str = textbase().getline(text_coord.y);
+
+				//A section which is not selected is copied from the render cache if it is not changed since it was drawn.
+				auto & cache = impl_->render_cache;
+				bool cacheable = (text_ptr == sct.begin) && !(sbegin && send) && !cache.background.invisible();
+				if (cacheable)
+				{
+					auto area = impl_->colored_area.find(text_coord.y);
+					cacheable = !(area && !area->bgcolor.invisible());
+				}
+
+				auto const line_revision = (cacheable ? textbase().revision(text_coord.y) : 0);
+				if (cacheable && cache.draw(graph_, line_revision, text_coord.x, text_len, text_draw_pos, text_area_.area, clr, impl_->keywords.generation))
+					return;
+
+				++cache.drawn;
+				const int text_left = text_draw_pos.x;
+
+				auto const reordered = unicode_reorder(text_ptr, text_len);
+
+				//Parse highlight keywords
+				keyword_parser parser;
+				if (text_ptr == sct.begin)
+					parser.parse(text_coord.y, line_str, text_ptr, text_len, textbase().revision(), impl_->keywords);
+				else
+					parser.parse(text_ptr, text_len, impl_->keywords);
+
+				const auto line_h_pixels = line_height();
+
+				helper_pencil pencil(graph_, *this, parser);
+
+				graph_.palette(true, clr);
+				graph_.palette(false, scheme_->selection.get_color());
+
 				//A text editor feature, it draws an extra block at end of line if the end of line is in range of selection.
 				bool extra_space = false;
 
@@ -3616,6 +4595,9 @@ namespace nana {
 					}
 
 					extra_space = text_selected;
+
+					if (cacheable)
+						cache.store(graph_, line_revision, text_coord.x, text_len, point{ text_left, top }, text_draw_pos.x, line_h_pixels, text_area_.area, clr, impl_->keywords.generation);
 				}
 				else
 				{
@@ -1048,9 +1048,9 @@ namespace nana
 								basis_.graph->palette(true, m.fgcolor.invisible() ? fgcolor : m.fgcolor);
 								nana::paint::text_renderer tr(*basis_.graph);
 
-								std::wstring wtext = to_wstring(item.text);
+								utf::scratch_wstring wtext{ item.text };
 								tr.render({ m.r.x + 24, m.r.y + static_cast<int>(m.r.height - ts.height) / 2 },
-											wtext.c_str(), wtext.length(), basis_.item_pixels - 24 - 18, paint::text_renderer::mode::truncate_with_ellipsis);
+											wtext.data(), wtext.size(), basis_.item_pixels - 24 - 18, paint::text_renderer::mode::truncate_with_ellipsis);
 							}
 						}
 
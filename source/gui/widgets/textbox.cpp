@@ -251,6 +251,24 @@ namespace drawerbase {
 			}
 		}
 
+		void textbox::load_lazily(const std::filesystem::path& file)
+		{
+			internal_scope_guard lock;
+			auto editor = get_drawer_trigger().editor();
+			if (editor && editor->load_lazily(file))
+			{
+				if (editor->try_refresh())
+					API::update_window(handle());
+			}
+		}
+
+		double textbox::load_progress() const
+		{
+			internal_scope_guard lock;
+			auto editor = get_drawer_trigger().editor();
+			return (editor ? editor->load_progress() : 1.0);
+		}
+
 		void textbox::store(const std::filesystem::path& file)
 		{
 			internal_scope_guard lock;
@@ -738,6 +756,56 @@ namespace drawerbase {
 			}
 		}
 
+		bool textbox::find(const std::string& text, bool case_sensitive, bool whole_word, bool forward)
+		{
+			internal_scope_guard lock;
+			auto editor = get_drawer_trigger().editor();
+			if (editor && editor->find(to_wstring(text), case_sensitive, whole_word, forward))
+			{
+				editor->try_refresh();
+				API::update_window(this->handle());
+				return true;
+			}
+			return false;
+		}
+
+		std::vector<upoint> textbox::find_all(const std::string& text, bool case_sensitive, bool whole_word) const
+		{
+			internal_scope_guard lock;
+			auto editor = get_drawer_trigger().editor();
+			if (editor)
+				return editor->find_all(to_wstring(text), case_sensitive, whole_word);
+
+			return{};
+		}
+
+		std::size_t textbox::replace_all(const std::string& text, const std::string& replacement, bool case_sensitive, bool whole_word)
+		{
+			internal_scope_guard lock;
+			auto editor = get_drawer_trigger().editor();
+			if (!editor)
+				return 0;
+
+			auto const count = editor->replace_all(to_wstring(text), to_wstring(replacement), case_sensitive, whole_word);
+			if (count)
+			{
+				editor->try_refresh();
+				API::update_window(this->handle());
+			}
+			return count;
+		}
+
+		void textbox::highlight_matches(const std::string& text, bool case_sensitive, bool whole_word, const ::nana::color& fgcolor, const ::nana::color& bgcolor)
+		{
+			internal_scope_guard lock;
+			auto editor = get_drawer_trigger().editor();
+			if (editor)
+			{
+				editor->highlight_matches(to_wstring(text), case_sensitive, whole_word, fgcolor, bgcolor);
+				API::refresh_window(handle());
+			}
+		}
+
 		textbox& textbox::text_align(::nana::align alignment)
 		{
 			internal_scope_guard lock;
@@ -802,6 +870,14 @@ namespace drawerbase {
 				editor->undo_max_steps(len);
 		}
 
+		void textbox::set_undo_memory_limit(std::size_t bytes)
+		{
+			internal_scope_guard lock;
+			auto editor = get_drawer_trigger().editor();
+			if (editor)
+				editor->undo_max_bytes(bytes);
+		}
+
 		std::size_t textbox::display_line_count() const noexcept
 		{
 			internal_scope_guard lock;
@@ -822,6 +898,16 @@ namespace drawerbase {
 			return 0;
 		}
 
+		widgets::skeletons::text_render_statistics textbox::render_statistics() const
+		{
+			internal_scope_guard lock;
+			auto editor = get_drawer_trigger().editor();
+			if (editor)
+				return editor->render_statistics();
+
+			return{};
+		}
+
 		//Override _m_caption for caption()
 		auto textbox::_m_caption() const noexcept -> native_string_type
 		{
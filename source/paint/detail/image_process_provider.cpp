@@ -2,6 +2,8 @@
 #include <nana/paint/detail/image_process_provider.hpp>
 
 #include "image_processor.hpp"
+#include "image_processor_simd.hpp"
+#include "image_processor_stretch.hpp"
 
 namespace nana
 {
@@ -20,6 +22,18 @@ namespace paint
 		{
 			add<paint::detail::algorithms::bilinear_interoplation>(stretch_, "bilinear interpolation");
 			add<paint::detail::algorithms::proximal_interoplation>(stretch_, "proximal interpolation");
+			add<paint::detail::algorithms::separable_interpolation>(stretch_, "separable interpolation");
+#ifdef NANA_PAINT_SIMD_X86
+			//The first added processor is employed by default, the SIMD versions are preferred
+			//if they are supported by the CPU.
+			if (paint::detail::algorithms::simd::cpu_supports_avx2())
+			{
+				add<paint::detail::algorithms::alpha_blend_avx2>(alpha_blend_, "alpha_blend avx2");
+				add<paint::detail::algorithms::blend_avx2>(blend_, "blend avx2");
+			}
+			add<paint::detail::algorithms::alpha_blend_sse2>(alpha_blend_, "alpha_blend sse2");
+			add<paint::detail::algorithms::blend_sse2>(blend_, "blend sse2");
+#endif
 			add<paint::detail::algorithms::alpha_blend>(alpha_blend_, "alpha_blend");
 			add<paint::detail::algorithms::blend>(blend_, "blend");
 			add<paint::detail::algorithms::bresenham_line>(line_, "bresenham_line");
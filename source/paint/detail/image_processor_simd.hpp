@@ -0,0 +1,423 @@
+/*
+ *	SIMD Image Processor Algorithm Implementation
+ *	Nana C++ Library(http://www.nanapro.org)
+ *	Copyright(C) 2003-2019 Jinhao(cnjinhao@hotmail.com)
+ *
+ *	Distributed under the Boost Software License, Version 1.0.
+ *	(See accompanying file LICENSE_1_0.txt or copy at
+ *	http://www.boost.org/LICENSE_1_0.txt)
+ *
+ *	@file: nana/paint/detail/image_processor_simd.hpp
+ *	@brief: This header file implements the SSE2/AVX2 versions of the blend algorithms.
+ *	The results are bit-exact to the scalar algorithms defined in image_processor.hpp,
+ *	which remain the reference and the fallback on the CPUs without these instruction sets.
+ *
+ *	DON'T INCLUDE THIS HEADER FILE DIRECTLY TO YOUR SOURCE FILE.
+ */
+
+#ifndef NANA_PAINT_DETAIL_IMAGE_PROCESSOR_SIMD_HPP
+#define NANA_PAINT_DETAIL_IMAGE_PROCESSOR_SIMD_HPP
+#include "image_processor.hpp"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#	define NANA_PAINT_SIMD_X86
+#	include <emmintrin.h>
+#	include <immintrin.h>
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#		define NANA_TARGET_AVX2
+#	else
+#		define NANA_TARGET_AVX2 __attribute__((target("avx2")))
+#	endif
+#endif
+
+#ifdef NANA_PAINT_SIMD_X86
+namespace nana
+{
+namespace paint
+{
+namespace detail
+{
+	namespace algorithms
+	{
+		namespace simd
+		{
+			/// Returns true if both the CPU and the OS support the AVX2 instructions.
+			inline bool cpu_supports_avx2()
+			{
+#if defined(_MSC_VER)
+				int info[4];
+				::__cpuid(info, 0);
+				if (info[0] < 7)
+					return false;
+
+				//Requires OSXSAVE and AVX, and the OS saves the YMM registers
+				::__cpuid(info, 1);
+				if (((info[2] & (1 << 27)) == 0) || ((info[2] & (1 << 28)) == 0))
+					return false;
+
+				if ((::_xgetbv(0) & 6) != 6)
+					return false;
+
+				::__cpuidex(info, 7, 0);
+				return (info[1] & (1 << 5)) != 0;
+#else
+				__builtin_cpu_init();
+				return (__builtin_cpu_supports("avx2") != 0);
+#endif
+			}
+
+			/// The blending of a single pixel, it is used for the remaining pixels of a line.
+			inline void alpha_blend_pixel(pixel_argb_t* d, const pixel_argb_t* s)
+			{
+				const unsigned alpha = s->element.alpha_channel;
+				if (alpha)
+				{
+					if (alpha != 255)
+					{
+						d->element.red = unsigned(d->element.red * (255 - alpha) + s->element.red * alpha) / 255;
+						d->element.green = unsigned(d->element.green * (255 - alpha) + s->element.green * alpha) / 255;
+						d->element.blue = unsigned(d->element.blue * (255 - alpha) + s->element.blue * alpha) / 255;
+					}
+					else
+						*d = *s;
+				}
+			}
+
+			/// The fade table is a step function of fade_rate * i. It is expressed by the fixed-point
+			/// formula (i * mul + add) >> 15, so that the table can be evaluated by the SIMD instructions.
+			/// Returns false if there is not a formula which reproduces the fade table exactly.
+			inline bool fade_table_formula(const unsigned char* d_table, double fade_rate, int& mul, int& add)
+			{
+				const long approx = std::lround(fade_rate * 0x8000);
+				for (long m = approx - 2; m <= approx + 2; ++m)
+				{
+					if (m < 0 || m > 0x7FFF)
+						continue;
+
+					//The range of 'add' that maps every i to d_table[i]
+					long add_min = -0x8000;
+					long add_max = 0x7FFF;
+					for (long i = 0; i < 0x100; ++i)
+					{
+						add_min = (std::max)(add_min, long(d_table[i]) * 0x8000 - i * m);
+						add_max = (std::min)(add_max, long(d_table[i] + 1) * 0x8000 - 1 - i * m);
+					}
+
+					if (add_min <= add_max)
+					{
+						mul = static_cast<int>(m);
+						add = static_cast<int>(add_min);
+						return true;
+					}
+				}
+				return false;
+			}
+
+			//SSE2
+
+			/// Blends 4 pixels. d = (d * (255 - alpha) + s * alpha) / 255, the alpha channel of d is kept
+			/// unless the source pixel is opaque.
+			inline __m128i alpha_blend_4px(__m128i d, __m128i s)
+			{
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i c255 = _mm_set1_epi16(255);
+				const __m128i one = _mm_set1_epi16(1);
+				const __m128i alpha_mask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+				__m128i s_lo = _mm_unpacklo_epi8(s, zero);
+				__m128i s_hi = _mm_unpackhi_epi8(s, zero);
+				__m128i d_lo = _mm_unpacklo_epi8(d, zero);
+				__m128i d_hi = _mm_unpackhi_epi8(d, zero);
+
+				__m128i a_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_lo, 0xFF), 0xFF);
+				__m128i a_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_hi, 0xFF), 0xFF);
+
+				__m128i x_lo = _mm_add_epi16(_mm_mullo_epi16(d_lo, _mm_sub_epi16(c255, a_lo)), _mm_mullo_epi16(s_lo, a_lo));
+				__m128i x_hi = _mm_add_epi16(_mm_mullo_epi16(d_hi, _mm_sub_epi16(c255, a_hi)), _mm_mullo_epi16(s_hi, a_hi));
+
+				//Exact division by 255 for x in [0, 255 * 255]: (x + 1 + (x >> 8)) >> 8
+				x_lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x_lo, one), _mm_srli_epi16(x_lo, 8)), 8);
+				x_hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x_hi, one), _mm_srli_epi16(x_hi, 8)), 8);
+
+				__m128i r = _mm_packus_epi16(x_lo, x_hi);
+				r = _mm_or_si128(_mm_andnot_si128(alpha_mask, r), _mm_and_si128(alpha_mask, d));
+
+				__m128i opaque = _mm_cmpeq_epi32(_mm_and_si128(s, alpha_mask), alpha_mask);
+				return _mm_or_si128(_mm_and_si128(opaque, s), _mm_andnot_si128(opaque, r));
+			}
+
+			/// Evaluates the fade table for 8 16-bit channels.
+			inline __m128i fade_8ch(__m128i x, __m128i formula)
+			{
+				const __m128i one = _mm_set1_epi16(1);
+				__m128i lo = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(x, one), formula), 15);
+				__m128i hi = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(x, one), formula), 15);
+				return _mm_packs_epi32(lo, hi);
+			}
+
+			/// Blends 4 pixels. d = d_table[d] + s_table[s], where s_table[s] = s - d_table[s]
+			inline __m128i blend_4px(__m128i d, __m128i s, __m128i formula)
+			{
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i alpha_mask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+				__m128i s_lo = _mm_unpacklo_epi8(s, zero);
+				__m128i s_hi = _mm_unpackhi_epi8(s, zero);
+				__m128i d_lo = _mm_unpacklo_epi8(d, zero);
+				__m128i d_hi = _mm_unpackhi_epi8(d, zero);
+
+				__m128i r_lo = _mm_add_epi16(fade_8ch(d_lo, formula), _mm_sub_epi16(s_lo, fade_8ch(s_lo, formula)));
+				__m128i r_hi = _mm_add_epi16(fade_8ch(d_hi, formula), _mm_sub_epi16(s_hi, fade_8ch(s_hi, formula)));
+
+				__m128i r = _mm_packus_epi16(r_lo, r_hi);
+				return _mm_or_si128(_mm_andnot_si128(alpha_mask, r), _mm_and_si128(alpha_mask, d));
+			}
+
+			//AVX2
+
+			NANA_TARGET_AVX2 inline __m256i alpha_blend_8px(__m256i d, __m256i s)
+			{
+				const __m256i zero = _mm256_setzero_si256();
+				const __m256i c255 = _mm256_set1_epi16(255);
+				const __m256i one = _mm256_set1_epi16(1);
+				const __m256i alpha_mask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+				__m256i s_lo = _mm256_unpacklo_epi8(s, zero);
+				__m256i s_hi = _mm256_unpackhi_epi8(s, zero);
+				__m256i d_lo = _mm256_unpacklo_epi8(d, zero);
+				__m256i d_hi = _mm256_unpackhi_epi8(d, zero);
+
+				__m256i a_lo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_lo, 0xFF), 0xFF);
+				__m256i a_hi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_hi, 0xFF), 0xFF);
+
+				__m256i x_lo = _mm256_add_epi16(_mm256_mullo_epi16(d_lo, _mm256_sub_epi16(c255, a_lo)), _mm256_mullo_epi16(s_lo, a_lo));
+				__m256i x_hi = _mm256_add_epi16(_mm256_mullo_epi16(d_hi, _mm256_sub_epi16(c255, a_hi)), _mm256_mullo_epi16(s_hi, a_hi));
+
+				x_lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(x_lo, one), _mm256_srli_epi16(x_lo, 8)), 8);
+				x_hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(x_hi, one), _mm256_srli_epi16(x_hi, 8)), 8);
+
+				//The unpack and pack instructions work in 128-bit lanes, so the order of pixels is kept
+				__m256i r = _mm256_packus_epi16(x_lo, x_hi);
+				r = _mm256_or_si256(_mm256_andnot_si256(alpha_mask, r), _mm256_and_si256(alpha_mask, d));
+
+				__m256i opaque = _mm256_cmpeq_epi32(_mm256_and_si256(s, alpha_mask), alpha_mask);
+				return _mm256_or_si256(_mm256_and_si256(opaque, s), _mm256_andnot_si256(opaque, r));
+			}
+
+			NANA_TARGET_AVX2 inline __m256i fade_16ch(__m256i x, __m256i formula)
+			{
+				const __m256i one = _mm256_set1_epi16(1);
+				__m256i lo = _mm256_srai_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(x, one), formula), 15);
+				__m256i hi = _mm256_srai_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(x, one), formula), 15);
+				return _mm256_packs_epi32(lo, hi);
+			}
+
+			NANA_TARGET_AVX2 inline __m256i blend_8px(__m256i d, __m256i s, __m256i formula)
+			{
+				const __m256i zero = _mm256_setzero_si256();
+				const __m256i alpha_mask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+				__m256i s_lo = _mm256_unpacklo_epi8(s, zero);
+				__m256i s_hi = _mm256_unpackhi_epi8(s, zero);
+				__m256i d_lo = _mm256_unpacklo_epi8(d, zero);
+				__m256i d_hi = _mm256_unpackhi_epi8(d, zero);
+
+				__m256i r_lo = _mm256_add_epi16(fade_16ch(d_lo, formula), _mm256_sub_epi16(s_lo, fade_16ch(s_lo, formula)));
+				__m256i r_hi = _mm256_add_epi16(fade_16ch(d_hi, formula), _mm256_sub_epi16(s_hi, fade_16ch(s_hi, formula)));
+
+				__m256i r = _mm256_packus_epi16(r_lo, r_hi);
+				return _mm256_or_si256(_mm256_andnot_si256(alpha_mask, r), _mm256_and_si256(alpha_mask, d));
+			}
+		}//end namespace simd
+
+		//alpha_blend_sse2
+		class alpha_blend_sse2
+			: public image_process::alpha_blend_interface
+		{
+			//process
+			virtual void process(const paint::pixel_buffer& s_pixbuf, const nana::rectangle& s_r, paint::pixel_buffer& d_pixbuf, const nana::point& d_pos) const
+			{
+				auto d_rgb = d_pixbuf.at(d_pos);
+				auto s_rgb = s_pixbuf.raw_ptr(s_r.y) + s_r.x;
+				if (!(d_rgb && s_rgb))
+					return;
+
+				const std::size_t d_bytes_pl = d_pixbuf.bytes_per_line();
+				const std::size_t s_bytes_pl = s_pixbuf.bytes_per_line();
+				const unsigned length_align4 = s_r.width & ~3u;
+
+				for (unsigned line = 0; line < s_r.height; ++line)
+				{
+					auto d = pixel_at(d_rgb, line * d_bytes_pl);
+					auto s = pixel_at(s_rgb, line * s_bytes_pl);
+					const auto end = d + length_align4;
+					for (; d < end; d += 4, s += 4)
+					{
+						__m128i s4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+
+						//Skip the 4 pixels if they are transparent completely
+						if (0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_srli_epi32(s4, 24), _mm_setzero_si128())))
+							continue;
+
+						__m128i d4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(d), simd::alpha_blend_4px(d4, s4));
+					}
+
+					for (unsigned i = length_align4; i < s_r.width; ++i, ++d, ++s)
+						simd::alpha_blend_pixel(d, s);
+				}
+			}
+		};
+
+		//alpha_blend_avx2
+		class alpha_blend_avx2
+			: public image_process::alpha_blend_interface
+		{
+			//process
+			NANA_TARGET_AVX2 virtual void process(const paint::pixel_buffer& s_pixbuf, const nana::rectangle& s_r, paint::pixel_buffer& d_pixbuf, const nana::point& d_pos) const
+			{
+				auto d_rgb = d_pixbuf.at(d_pos);
+				auto s_rgb = s_pixbuf.raw_ptr(s_r.y) + s_r.x;
+				if (!(d_rgb && s_rgb))
+					return;
+
+				const std::size_t d_bytes_pl = d_pixbuf.bytes_per_line();
+				const std::size_t s_bytes_pl = s_pixbuf.bytes_per_line();
+				const unsigned length_align8 = s_r.width & ~7u;
+
+				for (unsigned line = 0; line < s_r.height; ++line)
+				{
+					auto d = pixel_at(d_rgb, line * d_bytes_pl);
+					auto s = pixel_at(s_rgb, line * s_bytes_pl);
+					const auto end = d + length_align8;
+					for (; d < end; d += 8, s += 8)
+					{
+						__m256i s8 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+
+						//Skip the 8 pixels if they are transparent completely
+						if (-1 == _mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_srli_epi32(s8, 24), _mm256_setzero_si256())))
+							continue;
+
+						__m256i d8 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(d));
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(d), simd::alpha_blend_8px(d8, s8));
+					}
+
+					for (unsigned i = length_align8; i < s_r.width; ++i, ++d, ++s)
+						simd::alpha_blend_pixel(d, s);
+				}
+			}
+		};
+
+		//blend_sse2
+		class blend_sse2
+			: public image_process::blend_interface
+		{
+			//process
+			virtual void process(const paint::pixel_buffer& s_pixbuf, const nana::rectangle& s_r, paint::pixel_buffer& d_pixbuf, const nana::point& d_pos, double fade_rate) const
+			{
+				auto d_rgb = d_pixbuf.raw_ptr(d_pos.y) + d_pos.x;
+				auto s_rgb = s_pixbuf.raw_ptr(s_r.y) + s_r.x;
+				if (!(d_rgb && s_rgb))
+					return;
+
+				auto ptr = detail::alloc_fade_table(fade_rate);
+				const unsigned char* d_table = ptr.get();
+				const unsigned char* s_table = d_table + 0x100;
+
+				int mul, add;
+				if (!simd::fade_table_formula(d_table, fade_rate, mul, add))
+				{
+					//The fade table can't be evaluated by the SIMD instructions, uses the scalar version.
+					const image_process::blend_interface & scalar = blend{};
+					scalar.process(s_pixbuf, s_r, d_pixbuf, d_pos, fade_rate);
+					return;
+				}
+
+				const __m128i formula = _mm_set1_epi32(static_cast<int>((static_cast<unsigned>(add) << 16) | static_cast<unsigned>(mul)));
+
+				const std::size_t d_bytes_pl = d_pixbuf.bytes_per_line();
+				const std::size_t s_bytes_pl = s_pixbuf.bytes_per_line();
+				const unsigned length_align4 = s_r.width & ~3u;
+
+				for (unsigned line = 0; line < s_r.height; ++line)
+				{
+					auto d = pixel_at(d_rgb, line * d_bytes_pl);
+					auto s = pixel_at(s_rgb, line * s_bytes_pl);
+					const auto end = d + length_align4;
+					for (; d < end; d += 4, s += 4)
+					{
+						__m128i s4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+						__m128i d4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(d), simd::blend_4px(d4, s4, formula));
+					}
+
+					for (unsigned i = length_align4; i < s_r.width; ++i, ++d, ++s)
+					{
+						d->element.red = unsigned(d_table[d->element.red] + s_table[s->element.red]);
+						d->element.green = unsigned(d_table[d->element.green] + s_table[s->element.green]);
+						d->element.blue = unsigned(d_table[d->element.blue] + s_table[s->element.blue]);
+					}
+				}
+			}
+		};
+
+		//blend_avx2
+		class blend_avx2
+			: public image_process::blend_interface
+		{
+			//process
+			NANA_TARGET_AVX2 virtual void process(const paint::pixel_buffer& s_pixbuf, const nana::rectangle& s_r, paint::pixel_buffer& d_pixbuf, const nana::point& d_pos, double fade_rate) const
+			{
+				auto d_rgb = d_pixbuf.raw_ptr(d_pos.y) + d_pos.x;
+				auto s_rgb = s_pixbuf.raw_ptr(s_r.y) + s_r.x;
+				if (!(d_rgb && s_rgb))
+					return;
+
+				auto ptr = detail::alloc_fade_table(fade_rate);
+				const unsigned char* d_table = ptr.get();
+				const unsigned char* s_table = d_table + 0x100;
+
+				int mul, add;
+				if (!simd::fade_table_formula(d_table, fade_rate, mul, add))
+				{
+					const image_process::blend_interface & scalar = blend{};
+					scalar.process(s_pixbuf, s_r, d_pixbuf, d_pos, fade_rate);
+					return;
+				}
+
+				const __m256i formula = _mm256_set1_epi32(static_cast<int>((static_cast<unsigned>(add) << 16) | static_cast<unsigned>(mul)));
+
+				const std::size_t d_bytes_pl = d_pixbuf.bytes_per_line();
+				const std::size_t s_bytes_pl = s_pixbuf.bytes_per_line();
+				const unsigned length_align8 = s_r.width & ~7u;
+
+				for (unsigned line = 0; line < s_r.height; ++line)
+				{
+					auto d = pixel_at(d_rgb, line * d_bytes_pl);
+					auto s = pixel_at(s_rgb, line * s_bytes_pl);
+					const auto end = d + length_align8;
+					for (; d < end; d += 8, s += 8)
+					{
+						__m256i s8 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+						__m256i d8 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(d));
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(d), simd::blend_8px(d8, s8, formula));
+					}
+
+					for (unsigned i = length_align8; i < s_r.width; ++i, ++d, ++s)
+					{
+						d->element.red = unsigned(d_table[d->element.red] + s_table[s->element.red]);
+						d->element.green = unsigned(d_table[d->element.green] + s_table[s->element.green]);
+						d->element.blue = unsigned(d_table[d->element.blue] + s_table[s->element.blue]);
+					}
+				}
+			}
+		};
+	}
+}
+}
+}
+#endif	//NANA_PAINT_SIMD_X86
+
+#endif
@@ -0,0 +1,494 @@
+/*
+ *	Separable Stretch Algorithm Implementation
+ *	Nana C++ Library(http://www.nanapro.org)
+ *	Copyright(C) 2003-2019 Jinhao(cnjinhao@hotmail.com)
+ *
+ *	Distributed under the Boost Software License, Version 1.0.
+ *	(See accompanying file LICENSE_1_0.txt or copy at
+ *	http://www.boost.org/LICENSE_1_0.txt)
+ *
+ *	@file: nana/paint/detail/image_processor_stretch.hpp
+ *	@brief: This header file implements a separable stretch algorithm. The image is
+ *	interpolated horizontally into intermediate rows, and then the intermediate rows
+ *	are interpolated vertically. A box filter is used instead of bilinear interpolation
+ *	when the image is reduced to half or less, and the rows of a large image are split
+ *	into bands which are processed by a thread pool.
+ *
+ *	DON'T INCLUDE THIS HEADER FILE DIRECTLY TO YOUR SOURCE FILE.
+ */
+
+#ifndef NANA_PAINT_DETAIL_IMAGE_PROCESSOR_STRETCH_HPP
+#define NANA_PAINT_DETAIL_IMAGE_PROCESSOR_STRETCH_HPP
+#include "image_processor_simd.hpp"
+#include <nana/threads/pool.hpp>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+namespace nana
+{
+namespace paint
+{
+namespace detail
+{
+	namespace algorithms
+	{
+		class separable_interpolation
+			: public image_process::stretch_interface
+		{
+			//The weights are 7-bit, so that an intermediate channel fits into a signed 16-bit integer.
+			static const int weight_bits = 7;
+			static const int weight_one = 1 << weight_bits;
+
+			//The number of destination pixels that makes a stretch to be processed by the thread pool.
+			static const std::size_t parallel_pixels = 512 * 512;
+			static const std::size_t min_band_lines = 64;
+
+			struct bilinear_column
+			{
+				int x0;
+				int x1;
+				std::int32_t weights;	//The low 16 bits is the weight of x0, the high 16 bits is the weight of x1.
+			};
+
+			struct box_column
+			{
+				int x0;
+				int x1;
+			};
+
+			struct context
+			{
+				const paint::pixel_buffer* s_pixbuf;
+				nana::rectangle r_src;
+				paint::pixel_buffer* d_pixbuf;
+				nana::rectangle r_dst;
+				bool alpha_channel;
+				bool box;
+				std::vector<bilinear_column> bilinear_table;
+				std::vector<box_column> box_table;
+			};
+
+			void process(const paint::pixel_buffer& s_pixbuf, const nana::rectangle& r_src, paint::pixel_buffer& pixbuf, const nana::rectangle& r_dst) const
+			{
+				if (r_src.width == 0 || r_src.height == 0 || r_dst.width == 0 || r_dst.height == 0)
+					return;
+
+				context ctx;
+				ctx.s_pixbuf = &s_pixbuf;
+				ctx.r_src = r_src;
+				ctx.d_pixbuf = &pixbuf;
+				ctx.r_dst = r_dst;
+				ctx.alpha_channel = s_pixbuf.alpha_channel();
+				ctx.box = (r_src.width >= r_dst.width * 2) && (r_src.height >= r_dst.height * 2);
+
+				if (ctx.box)
+				{
+					ctx.box_table.resize(r_dst.width);
+					for (std::size_t x = 0; x < r_dst.width; ++x)
+					{
+						auto & col = ctx.box_table[x];
+						col.x0 = r_src.x + static_cast<int>(x * r_src.width / r_dst.width);
+						col.x1 = r_src.x + static_cast<int>((x + 1) * r_src.width / r_dst.width);
+					}
+				}
+				else
+				{
+					const double rate_x = double(r_src.width) / r_dst.width;
+					const int right_bound = static_cast<int>(r_src.width) - 1 + r_src.x;
+
+					ctx.bilinear_table.resize(r_dst.width);
+					for (std::size_t x = 0; x < r_dst.width; ++x)
+					{
+						auto & col = ctx.bilinear_table[x];
+
+						double u = (int(x) + 0.5) * rate_x - 0.5;
+						col.x0 = r_src.x;
+						if (u < 0)
+							u = 0;
+						else
+						{
+							int ipart = static_cast<int>(u);
+							col.x0 += ipart;
+							u -= ipart;
+						}
+						col.x1 = (col.x0 < right_bound ? col.x0 + 1 : col.x0);
+
+						const int w1 = static_cast<int>(u * weight_one);
+						col.weights = static_cast<std::int32_t>((static_cast<std::uint32_t>(w1) << 16) | static_cast<std::uint32_t>(weight_one - w1));
+					}
+				}
+
+				const std::size_t lines = r_dst.height;
+				std::size_t bands = 1;
+				if (std::size_t(r_dst.width) * lines >= parallel_pixels)
+				{
+#ifndef STD_THREAD_NOT_SUPPORTED
+					bands = (std::min)(std::size_t(std::thread::hardware_concurrency()), lines / min_band_lines);
+#endif
+					if (bands < 1)
+						bands = 1;
+				}
+
+				if (1 == bands)
+				{
+					_m_process_band(ctx, 0, lines);
+					return;
+				}
+
+				//The latch is counted down even if a band throws, the first exception is rethrown by the
+				//calling thread after all the bands are finished, because the bands refer to ctx. Every band
+				//is claimed once, the calling thread processes the bands which are not started by the pool,
+				//so a band which is dropped by the pool doesn't stall the wait. The latch is shared with the
+				//tasks which may be still queued when this function returns, they don't touch ctx then.
+				struct latch_t
+				{
+					std::mutex mutex;
+					std::condition_variable cond;
+					std::size_t remains;
+					std::exception_ptr error;
+					std::unique_ptr<std::atomic<bool>[]> claimed;
+
+					void count_down(std::exception_ptr e)
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						if (e && !error)
+							error = e;
+
+						if (0 == --remains)
+							cond.notify_one();
+					}
+				};
+
+				auto latch = std::make_shared<latch_t>();
+				latch->remains = bands;
+				latch->claimed.reset(new std::atomic<bool>[bands]);
+				for (std::size_t i = 0; i < bands; ++i)
+					latch->claimed[i] = false;
+
+				const std::size_t band_lines = (lines + bands - 1) / bands;
+				const auto ctxptr = &ctx;
+
+				auto process = [this, ctxptr, latch, band_lines, lines](std::size_t band)
+				{
+					if (latch->claimed[band].exchange(true))
+						return;
+
+					const std::size_t begin = band * band_lines;
+					std::exception_ptr e;
+					try
+					{
+						_m_process_band(*ctxptr, begin, (std::min)(begin + band_lines, lines));
+					}
+					catch (...)
+					{
+						e = std::current_exception();
+					}
+					latch->count_down(e);
+				};
+
+				//The last band is processed by the calling thread first.
+				for (std::size_t i = 0; i + 1 < bands; ++i)
+				{
+					try
+					{
+						_m_pool().push([process, i]
+						{
+							process(i);
+						});
+					}
+					catch (...)
+					{
+						//The bands which can't be pushed to the pool are processed by the calling thread below.
+						break;
+					}
+				}
+
+				for (std::size_t i = bands; i > 0; --i)
+					process(i - 1);
+
+				std::unique_lock<std::mutex> lock(latch->mutex);
+				latch->cond.wait(lock, [&latch]{ return (0 == latch->remains); });
+
+				if (latch->error)
+					std::rethrow_exception(latch->error);
+			}
+		private:
+			static threads::pool& _m_pool()
+			{
+				static threads::pool pool;
+				return pool;
+			}
+
+			void _m_process_band(const context& ctx, std::size_t begin, std::size_t end) const
+			{
+				if (begin >= end)
+					return;
+
+				if (ctx.box)
+					_m_box_band(ctx, begin, end);
+				else
+					_m_bilinear_band(ctx, begin, end);
+			}
+
+			void _m_bilinear_band(const context& ctx, std::size_t begin, std::size_t end) const
+			{
+				const auto & r_src = ctx.r_src;
+				const auto & r_dst = ctx.r_dst;
+				const double rate_y = double(r_src.height) / r_dst.height;
+				const int bottom = r_src.y + static_cast<int>(r_src.height - 1);
+				const std::size_t channels = std::size_t(r_dst.width) * 4;
+
+				//The intermediate rows, and the source rows which they are interpolated from.
+				std::vector<std::int16_t> buf0(channels + 8), buf1(channels + 8);
+				std::int16_t* rows[2] = { buf0.data(), buf1.data() };
+				int row_sy[2] = { -1, -1 };
+
+				std::vector<pixel_argb_t> line(r_dst.width);
+
+				for (std::size_t row = begin; row < end; ++row)
+				{
+					double v = (int(row) + 0.5) * rate_y - 0.5;
+					int sy = r_src.y;
+					if (v < 0)
+						v = 0;
+					else
+					{
+						int ipart = static_cast<int>(v);
+						sy += ipart;
+						v -= ipart;
+					}
+					const int sy_next = (sy < bottom ? sy + 1 : sy);
+
+					//Reuses the intermediate rows of the previous line
+					if (row_sy[0] != sy)
+					{
+						if (row_sy[1] == sy)
+						{
+							std::swap(rows[0], rows[1]);
+							std::swap(row_sy[0], row_sy[1]);
+						}
+						else
+						{
+							_m_bilinear_horz(ctx, sy, rows[0]);
+							row_sy[0] = sy;
+						}
+					}
+
+					if (row_sy[1] != sy_next)
+					{
+						_m_bilinear_horz(ctx, sy_next, rows[1]);
+						row_sy[1] = sy_next;
+					}
+
+					const int w1 = static_cast<int>(v * weight_one);
+					_m_vert(rows[0], rows[1], weight_one - w1, w1, line.data(), r_dst.width);
+					_m_write(ctx, row, line.data());
+				}
+			}
+
+			void _m_bilinear_horz(const context& ctx, int sy, std::int16_t* out) const
+			{
+				const pixel_argb_t* s_line = ctx.s_pixbuf->raw_ptr(sy);
+				const auto end = ctx.bilinear_table.data() + ctx.bilinear_table.size();
+#ifdef NANA_PAINT_SIMD_X86
+				const __m128i zero = _mm_setzero_si128();
+				for (auto col = ctx.bilinear_table.data(); col != end; ++col, out += 4)
+				{
+					//b0 b1 g0 g1 r0 r1 a0 a1
+					__m128i px = _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(s_line[col->x0].value)), _mm_cvtsi32_si128(static_cast<int>(s_line[col->x1].value)));
+					__m128i sum = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), _mm_set1_epi32(col->weights));
+					_mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packs_epi32(sum, sum));
+				}
+#else
+				for (auto col = ctx.bilinear_table.data(); col != end; ++col, out += 4)
+				{
+					const int w0 = col->weights & 0xFFFF;
+					const int w1 = col->weights >> 16;
+					auto & p0 = s_line[col->x0].element;
+					auto & p1 = s_line[col->x1].element;
+					out[0] = static_cast<std::int16_t>(p0.blue * w0 + p1.blue * w1);
+					out[1] = static_cast<std::int16_t>(p0.green * w0 + p1.green * w1);
+					out[2] = static_cast<std::int16_t>(p0.red * w0 + p1.red * w1);
+					out[3] = static_cast<std::int16_t>(p0.alpha_channel * w0 + p1.alpha_channel * w1);
+				}
+#endif
+			}
+
+			/// Interpolates two intermediate rows vertically.
+			static void _m_vert(const std::int16_t* row0, const std::int16_t* row1, int w0, int w1, pixel_argb_t* out, std::size_t width)
+			{
+				const int shift = weight_bits * 2;
+				const int round = 1 << (shift - 1);
+
+				std::size_t x = 0;
+#ifdef NANA_PAINT_SIMD_X86
+				const __m128i weights = _mm_set1_epi32(static_cast<int>((static_cast<unsigned>(w1) << 16) | static_cast<unsigned>(w0)));
+				const __m128i rounding = _mm_set1_epi32(round);
+
+				for (; x + 4 <= width; x += 4, row0 += 16, row1 += 16)
+				{
+					__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0));
+					__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1));
+					__m128i s0 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(a, b), weights), rounding), shift);
+					__m128i s1 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(a, b), weights), rounding), shift);
+
+					a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8));
+					b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8));
+					__m128i s2 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(a, b), weights), rounding), shift);
+					__m128i s3 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(a, b), weights), rounding), shift);
+
+					__m128i px = _mm_packus_epi16(_mm_packs_epi32(s0, s1), _mm_packs_epi32(s2, s3));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), px);
+				}
+#endif
+				for (; x < width; ++x, row0 += 4, row1 += 4)
+				{
+					auto & px = out[x].element;
+					px.blue = static_cast<unsigned char>((row0[0] * w0 + row1[0] * w1 + round) >> shift);
+					px.green = static_cast<unsigned char>((row0[1] * w0 + row1[1] * w1 + round) >> shift);
+					px.red = static_cast<unsigned char>((row0[2] * w0 + row1[2] * w1 + round) >> shift);
+					px.alpha_channel = static_cast<unsigned char>((row0[3] * w0 + row1[3] * w1 + round) >> shift);
+				}
+			}
+
+			void _m_box_band(const context& ctx, std::size_t begin, std::size_t end) const
+			{
+				const auto & r_src = ctx.r_src;
+				const auto & r_dst = ctx.r_dst;
+				const std::size_t width = r_dst.width;
+
+				std::vector<std::uint32_t> sums(width * 4);
+				std::vector<pixel_argb_t> line(width);
+
+				for (std::size_t row = begin; row < end; ++row)
+				{
+					const int sy_begin = r_src.y + static_cast<int>(row * r_src.height / r_dst.height);
+					const int sy_end = r_src.y + static_cast<int>((row + 1) * r_src.height / r_dst.height);
+
+					std::fill(sums.begin(), sums.end(), 0);
+					for (int sy = sy_begin; sy < sy_end; ++sy)
+						_m_box_horz(ctx, sy, sums.data());
+
+					const auto lines = static_cast<unsigned>(sy_end - sy_begin);
+					auto sum = sums.data();
+					for (std::size_t x = 0; x < width; ++x, sum += 4)
+					{
+						const auto & col = ctx.box_table[x];
+						const float rate = 1.0f / float(unsigned(col.x1 - col.x0) * lines);
+#ifdef NANA_PAINT_SIMD_X86
+						__m128i px = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sum))), _mm_set1_ps(rate)));
+						px = _mm_packs_epi32(px, px);
+						line[x].value = static_cast<unsigned>(_mm_cvtsi128_si32(_mm_packus_epi16(px, px)));
+#else
+						auto & px = line[x].element;
+						px.blue = static_cast<unsigned char>(sum[0] * rate + 0.5f);
+						px.green = static_cast<unsigned char>(sum[1] * rate + 0.5f);
+						px.red = static_cast<unsigned char>(sum[2] * rate + 0.5f);
+						px.alpha_channel = static_cast<unsigned char>(sum[3] * rate + 0.5f);
+#endif
+					}
+					_m_write(ctx, row, line.data());
+				}
+			}
+
+			/// Accumulates the pixels of a source line into the sums of the destination columns
+			void _m_box_horz(const context& ctx, int sy, std::uint32_t* sums) const
+			{
+				const pixel_argb_t* s_line = ctx.s_pixbuf->raw_ptr(sy);
+				const auto end = ctx.box_table.data() + ctx.box_table.size();
+#ifdef NANA_PAINT_SIMD_X86
+				const __m128i zero = _mm_setzero_si128();
+				for (auto col = ctx.box_table.data(); col != end; ++col, sums += 4)
+				{
+					__m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums));
+					for (auto p = s_line + col->x0, p_end = s_line + col->x1; p != p_end; ++p)
+						acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(p->value)), zero), zero));
+
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(sums), acc);
+				}
+#else
+				for (auto col = ctx.box_table.data(); col != end; ++col, sums += 4)
+				{
+					for (auto p = s_line + col->x0, p_end = s_line + col->x1; p != p_end; ++p)
+					{
+						sums[0] += p->element.blue;
+						sums[1] += p->element.green;
+						sums[2] += p->element.red;
+						sums[3] += p->element.alpha_channel;
+					}
+				}
+#endif
+			}
+
+			/// Writes a stretched line to the destination. The alpha channel of the destination is kept.
+			static void _m_write(const context& ctx, std::size_t row, const pixel_argb_t* line)
+			{
+				pixel_argb_t* i = ctx.d_pixbuf->raw_ptr(row + ctx.r_dst.y) + ctx.r_dst.x;
+				const std::size_t width = ctx.r_dst.width;
+				std::size_t x = 0;
+
+				if (ctx.alpha_channel)
+				{
+#ifdef NANA_PAINT_SIMD_X86
+					const __m128i alpha_mask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+					for (; x + 4 <= width; x += 4)
+					{
+						__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(line + x));
+						__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(i + x));
+						__m128i r = simd::alpha_blend_4px(d, s);
+						r = _mm_or_si128(_mm_andnot_si128(alpha_mask, r), _mm_and_si128(alpha_mask, d));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(i + x), r);
+					}
+#endif
+					for (; x < width; ++x)
+					{
+						const unsigned alpha_chn = line[x].element.alpha_channel;
+						if (alpha_chn)
+						{
+							auto & px = i[x].element;
+							if (alpha_chn != 255)
+							{
+								px.red = unsigned(px.red * (255 - alpha_chn) + line[x].element.red * alpha_chn) / 255;
+								px.green = unsigned(px.green * (255 - alpha_chn) + line[x].element.green * alpha_chn) / 255;
+								px.blue = unsigned(px.blue * (255 - alpha_chn) + line[x].element.blue * alpha_chn) / 255;
+							}
+							else
+							{
+								px.red = line[x].element.red;
+								px.green = line[x].element.green;
+								px.blue = line[x].element.blue;
+							}
+						}
+					}
+				}
+				else
+				{
+#ifdef NANA_PAINT_SIMD_X86
+					const __m128i alpha_mask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+					for (; x + 4 <= width; x += 4)
+					{
+						__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(line + x));
+						__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(i + x));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(i + x), _mm_or_si128(_mm_andnot_si128(alpha_mask, s), _mm_and_si128(alpha_mask, d)));
+					}
+#endif
+					for (; x < width; ++x)
+					{
+						i[x].element.red = line[x].element.red;
+						i[x].element.green = line[x].element.green;
+						i[x].element.blue = line[x].element.blue;
+					}
+				}
+			}
+		};
+	}
+}
+}
+}
+
+#endif
@@ -30,6 +30,9 @@ namespace nana
 	class font_interface;
 	void nana_xft_draw_string(::XftDraw* xftdraw, ::XftColor* xftcolor, font_interface* ft, const nana::point& pos, const wchar_t * str, std::size_t len);
 	nana::size nana_xft_extents(font_interface* ft, const wchar_t* str, std::size_t len);
+
+	void nana_ft_draw_string(paint::drawable_type dw, font_interface* ft, const nana::point& pos, const wchar_t * str, std::size_t len);
+	nana::size nana_ft_extents(font_interface* ft, const wchar_t* str, std::size_t len);
 #endif
 
 namespace paint
@@ -45,6 +48,9 @@ namespace detail
 		::GetObject(dw->pixmap, sizeof bmp, &bmp);
 		return nana::size(bmp.bmWidth, bmp.bmHeight);
 #elif defined(NANA_X11)
+		if (dw->pixbuf_ptr)
+			return dw->pixbuf_size;
+
         nana::detail::platform_spec & spec = nana::detail::platform_spec::instance();
         Window root;
         int x, y;
@@ -154,20 +160,23 @@ namespace detail
 #elif defined(NANA_X11)
 #if defined(NANA_USE_XFT)
 			#if 0
-			std::string utf8text = to_utf8(std::wstring(text, len));
+			utf::scratch_string utf8text{ text, len };
 			XGlyphInfo ext;
 			XftFont * fs = reinterpret_cast<XftFont*>(dw->font->native_handle());
 			::XftTextExtentsUtf8(nana::detail::platform_spec::instance().open_display(), fs,
 				reinterpret_cast<XftChar8*>(const_cast<char*>(utf8text.data())), utf8text.size(), &ext);
 			return nana::size(ext.xOff, fs->ascent + fs->descent);
 			#else
+			if (dw->pixbuf_ptr)
+				return nana_ft_extents(dw->font.get(), text, len);
+
 			return nana_xft_extents(dw->font.get(), text, len);
 			#endif
 #else
-			std::string utf8text = to_utf8(std::wstring(text, len));
+			utf::scratch_string utf8text{ text, len };
 			XRectangle ink;
 			XRectangle logic;
-			::XmbTextExtents(reinterpret_cast<XFontSet>(dw->font->native_handle()), utf8text.c_str(), utf8text.size(), &ink, &logic);
+			::XmbTextExtents(reinterpret_cast<XFontSet>(dw->font->native_handle()), utf8text.data(), utf8text.size(), &ink, &logic);
 			return nana::size(logic.width, logic.height);
 #endif
 #endif
@@ -181,13 +190,9 @@ namespace detail
 		{
 
 #if defined(NANA_WINDOWS)
-#ifdef _nana_std_has_string_view
-			auto wstr = to_wstring(std::string_view(text, len));
-#else
-			auto wstr = to_wstring(std::string(text,len));
-#endif
+			utf::scratch_wstring wstr{ text, len };
 			::SIZE size;
-			if (::GetTextExtentPoint32(dw->context, wstr.c_str(), static_cast<int>(wstr.size()), &size))
+			if (::GetTextExtentPoint32(dw->context, wstr.data(), static_cast<int>(wstr.size()), &size))
 				return nana::size(size.cx, size.cy);
 #elif defined(NANA_X11)
 #if defined(NANA_USE_XFT)
@@ -198,11 +203,10 @@ namespace detail
 				reinterpret_cast<XftChar8*>(const_cast<char*>(text)), len, &ext);
 			return nana::size(ext.xOff, fs->ascent + fs->descent);
 			#else
-#ifdef _nana_std_has_string_view
-			auto wstr = to_wstring(std::string_view(text, len));
-#else
-			auto wstr = to_wstring(std::string(text,len));
-#endif
+			utf::scratch_wstring wstr{ text, len };
+			if (dw->pixbuf_ptr)
+				return nana_ft_extents(dw->font.get(), wstr.data(), wstr.size());
+
 			return nana_xft_extents(dw->font.get(), wstr.data(), wstr.size());
 			#endif
 #else
@@ -261,7 +265,10 @@ namespace detail
 		::TextOut(dw->context, pos.x, pos.y, str, static_cast<int>(len));
 #elif defined(NANA_X11)
 	#if defined(NANA_USE_XFT)
-		nana_xft_draw_string(dw->xftdraw, &(dw->xft_fgcolor), dw->font.get(), pos, str, len);
+		if (dw->pixbuf_ptr)
+			nana_ft_draw_string(dw, dw->font.get(), pos, str, len);
+		else
+			nana_xft_draw_string(dw->xftdraw, &(dw->xft_fgcolor), dw->font.get(), pos, str, len);
 	#else
 		XFontSet fs = reinterpret_cast<XFontSet>(dw->font->native_handle());
 		XFontSetExtents * ext = ::XExtentsOfFontSet(fs);
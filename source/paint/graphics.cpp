@@ -13,6 +13,7 @@
 #include "../detail/platform_spec_selector.hpp"
 #include <nana/gui/detail/bedrock.hpp>
 #include <nana/paint/graphics.hpp>
+#include <nana/paint/text_cache.hpp>
 #include <nana/paint/detail/native_paint_interface.hpp>
 #include <nana/paint/pixel_buffer.hpp>
 #include <nana/gui/layout_utility.hpp>
@@ -22,6 +23,7 @@
 	#include <windows.h>
 #elif defined(NANA_X11)
 	#include <X11/Xlib.h>
+	#include "../detail/posix/headless_surface.hpp"
 #endif
 
 #include "../detail/platform_abstraction.hpp"
@@ -31,6 +33,8 @@ namespace nana
 	//Forward-declarations
 	//These names are defined platform_abstraction.cpp
 	std::unique_ptr<unsigned[]> nana_xft_glyph_pixels(font_interface*, const wchar_t* str, std::size_t len);
+	std::unique_ptr<unsigned[]> nana_ft_glyph_pixels(font_interface*, const wchar_t* str, std::size_t len);
+	void nana_ft_metrics(font_interface*, unsigned& ascent, unsigned& descent);
 
 	namespace detail
 	{
@@ -52,7 +56,13 @@ namespace paint
 #if defined(NANA_WINDOWS)
 				delete p;
 #elif defined(NANA_X11)
-				if(p)
+				if(p && p->pixbuf_ptr)
+				{
+					//A drawable of headless mode
+					nana::detail::headless::release(p);
+					delete p;
+				}
+				else if(p)
 				{
 					Display* disp = reinterpret_cast<Display*>(nana::detail::platform_spec::instance().open_display());
 	#if defined(NANA_USE_XFT)
@@ -364,6 +374,12 @@ namespace paint
 				::ReleaseDC(0, hdc);
 #elif defined(NANA_X11)
 				auto & spec = nana::detail::platform_spec::instance();
+				if (spec.headless())
+				{
+					if (!nana::detail::headless::alloc(dw.get(), sz))
+						throw std::bad_alloc{};
+				}
+				else
 				{
 					nana::detail::platform_scope_guard psg;
 
@@ -500,7 +516,7 @@ namespace paint
 
 		std::unique_ptr<unsigned[]> graphics::glyph_pixels(std::wstring_view text) const
 		{
-			if (nullptr == impl_->handle || nullptr == impl_->handle->context) return {};
+			if (nullptr == impl_->handle) return {};
 
 			auto pxbuf = std::unique_ptr<unsigned[]>{ new unsigned[text.size() ? text.size() : 1] };
 
@@ -520,6 +536,9 @@ namespace paint
 				}
 				delete[] dx;
 #elif defined(NANA_X11) && defined(NANA_USE_XFT)
+				if (impl_->handle->pixbuf_ptr)
+					return nana_ft_glyph_pixels(impl_->handle->font.get(), text.data(), text.size());
+
 				return nana_xft_glyph_pixels(impl_->handle->font.get(), text.data(), text.size());
 #endif
 			}
@@ -528,13 +547,14 @@ namespace paint
 
 		::nana::size graphics::bidi_extent_size(std::string_view utf8str) const
 		{
-			return bidi_extent_size(to_wstring(utf8str));
+			utf::scratch_wstring wstr{ utf8str.data(), utf8str.size() };
+			return bidi_extent_size(std::wstring_view{ wstr.data(), wstr.size() });
 		}
 
 		nana::size	graphics::bidi_extent_size(std::wstring_view text) const
 		{
 			nana::size sz;
-			if (impl_->handle && impl_->handle->context && text.size())
+			if (impl_->handle && text.size())
 			{
 				auto const reordered = unicode_reorder(text.data(), text.size());
 				for (auto & i : reordered)
@@ -555,7 +575,7 @@ namespace paint
 		::nana::size graphics::text_extent_size(const ::std::string& text) const
 		{
 			throw_not_utf8(text);
-			return text_extent_size(to_wstring(text));
+			return text_extent_size(utf::scratch_wstring{ text }.str());
 		}
 
 		::nana::size graphics::text_extent_size(const char* text, std::size_t len) const
@@ -616,7 +636,7 @@ namespace paint
 
 		bool graphics::glyph_pixels(const wchar_t * str, std::size_t len, unsigned* pxbuf) const
 		{
-			if (nullptr == impl_->handle || nullptr == impl_->handle->context || nullptr == str || nullptr == pxbuf) return false;
+			if (nullptr == impl_->handle || nullptr == str || nullptr == pxbuf) return false;
 			if (len == 0) return true;
 
 			unsigned tab_pixels = impl_->handle->string.tab_length * impl_->handle->string.whitespace_pixels;
@@ -633,6 +653,13 @@ namespace paint
 			}
 			delete[] dx;
 #elif defined(NANA_X11) && defined(NANA_USE_XFT)
+			if (impl_->handle->pixbuf_ptr)
+			{
+				auto px = nana_ft_glyph_pixels(impl_->handle->font.get(), str, len);
+				for (std::size_t i = 0; i < len; ++i)
+					pxbuf[i] = (str[i] != '\t' ? px[i] : tab_pixels);
+				return true;
+			}
 
 			auto disp = nana::detail::platform_spec::instance().open_display();
 			auto xft = reinterpret_cast<XftFont*>(impl_->handle->font->native_handle());
@@ -656,7 +683,7 @@ namespace paint
 		nana::size	graphics::bidi_extent_size(const std::wstring& str) const
 		{
 			nana::size sz;
-			if (impl_->handle && impl_->handle->context && str.size())
+			if (impl_->handle && str.size())
 			{
 				auto const reordered = unicode_reorder(str.c_str(), str.size());
 				for (auto & i : reordered)
@@ -676,7 +703,7 @@ namespace paint
 
 		::nana::size graphics::bidi_extent_size(const std::string& str) const
 		{
-			return bidi_extent_size(static_cast<std::wstring>(::nana::charset(str, ::nana::unicode::utf8)));
+			return bidi_extent_size(utf::scratch_wstring{ str }.str());
 		}
 #endif	//end _nana_std_has_string_view
 
@@ -695,6 +722,13 @@ namespace paint
 				if(impl_->handle->font)
 				{
 	#if defined(NANA_USE_XFT)
+					if (impl_->handle->pixbuf_ptr)
+					{
+						nana_ft_metrics(impl_->handle->font.get(), ascent, descent);
+						internal_leading = 0;
+						return true;
+					}
+
 					auto fs = reinterpret_cast<XftFont*>(impl_->handle->font->native_handle());
 					ascent = fs->ascent;
 					descent = fs->descent;
@@ -752,7 +786,9 @@ namespace paint
 				::BitBlt(impl_->handle->context, r_dst.x, r_dst.y, r_dst.width, r_dst.height, dc, 0, 0, SRCCOPY);
 				::ReleaseDC(reinterpret_cast<HWND>(src), dc);
 #elif defined(NANA_X11)
-				::XCopyArea(nana::detail::platform_spec::instance().open_display(),
+				//There is not a window in headless mode.
+				if (nullptr == impl_->handle->pixbuf_ptr)
+					::XCopyArea(nana::detail::platform_spec::instance().open_display(),
 						reinterpret_cast<Window>(src), impl_->handle->pixmap, impl_->handle->context,
 						0, 0, r_dst.width, r_dst.height, r_dst.x, r_dst.y);
 #endif
@@ -769,7 +805,9 @@ namespace paint
 				::BitBlt(impl_->handle->context, r_dst.x, r_dst.y, r_dst.width, r_dst.height, dc, p_src.x, p_src.y, SRCCOPY);
 				::ReleaseDC(reinterpret_cast<HWND>(src), dc);
 #elif defined(NANA_X11)
-				::XCopyArea(nana::detail::platform_spec::instance().open_display(),
+				//There is not a window in headless mode.
+				if (nullptr == impl_->handle->pixbuf_ptr)
+					::XCopyArea(nana::detail::platform_spec::instance().open_display(),
 						reinterpret_cast<Window>(src), impl_->handle->pixmap, impl_->handle->context,
 						p_src.x, p_src.y, r_dst.width, r_dst.height, r_dst.x, r_dst.y);
 #endif
@@ -784,7 +822,10 @@ namespace paint
 #if defined(NANA_WINDOWS)
 				::BitBlt(impl_->handle->context, r_dst.x, r_dst.y, r_dst.width, r_dst.height, src.impl_->handle->context, 0, 0, SRCCOPY);
 #elif defined(NANA_X11)
-				::XCopyArea(nana::detail::platform_spec::instance().open_display(),
+				if (impl_->handle->pixbuf_ptr)
+					nana::detail::headless::copy(impl_->handle, r_dst.position(), src.impl_->handle, nana::rectangle{ r_dst.dimension() });
+				else
+					::XCopyArea(nana::detail::platform_spec::instance().open_display(),
 						src.impl_->handle->pixmap, impl_->handle->pixmap, impl_->handle->context,
 						0, 0, r_dst.width, r_dst.height, r_dst.x, r_dst.y);
 #endif
@@ -799,7 +840,10 @@ namespace paint
 #if defined(NANA_WINDOWS)
 				::BitBlt(impl_->handle->context, r_dst.x, r_dst.y, r_dst.width, r_dst.height, src.impl_->handle->context, p_src.x, p_src.y, SRCCOPY);
 #elif defined(NANA_X11)
-				::XCopyArea(nana::detail::platform_spec::instance().open_display(),
+				if (impl_->handle->pixbuf_ptr)
+					nana::detail::headless::copy(impl_->handle, r_dst.position(), src.impl_->handle, nana::rectangle{ p_src, r_dst.dimension() });
+				else
+					::XCopyArea(nana::detail::platform_spec::instance().open_display(),
 						src.impl_->handle->pixmap, impl_->handle->pixmap, impl_->handle->context,
 						p_src.x, p_src.y, r_dst.width, r_dst.height, r_dst.x, r_dst.y);
 #endif
@@ -908,12 +952,19 @@ namespace paint
 #if defined(NANA_WINDOWS)
 				::BitBlt(dst.impl_->handle->context, x, y, impl_->size.width, impl_->size.height, impl_->handle->context, 0, 0, SRCCOPY);
 #elif defined(NANA_X11)
-				Display* display = nana::detail::platform_spec::instance().open_display();
-				::XCopyArea(display,
-					impl_->handle->pixmap, dst.impl_->handle->pixmap, impl_->handle->context,
-						0, 0, impl_->size.width, impl_->size.height, x, y);
+				if (impl_->handle->pixbuf_ptr)
+				{
+					nana::detail::headless::copy(dst.impl_->handle, point{ x, y }, impl_->handle, nana::rectangle{ impl_->size });
+				}
+				else
+				{
+					Display* display = nana::detail::platform_spec::instance().open_display();
+					::XCopyArea(display,
+						impl_->handle->pixmap, dst.impl_->handle->pixmap, impl_->handle->context,
+							0, 0, impl_->size.width, impl_->size.height, x, y);
 
-				::XFlush(display);
+					::XFlush(display);
+				}
 #endif
 				dst.impl_->changed = true;
 			}
@@ -938,6 +989,10 @@ namespace paint
 #elif defined(NANA_X11)
 				auto & spec = nana::detail::platform_spec::instance();
 
+				//There is not a window in headless mode.
+				if (spec.headless())
+					return;
+
 				Display * display = spec.open_display();
 
 				nana::detail::platform_scope_guard lock;
@@ -964,6 +1019,12 @@ namespace paint
 #if defined (NANA_WINDOWS)
 				::BitBlt(dst->context, x, y, impl_->size.width, impl_->size.height, impl_->handle->context, 0, 0, SRCCOPY);
 #elif defined(NANA_X11)
+				if (impl_->handle->pixbuf_ptr)
+				{
+					nana::detail::headless::copy(dst, point{ x, y }, impl_->handle, nana::rectangle{ impl_->size });
+					return;
+				}
+
 				Display * display = nana::detail::platform_spec::instance().open_display();
 				::XCopyArea(display,
 					impl_->handle->pixmap, dst->pixmap, impl_->handle->context,
@@ -981,6 +1042,12 @@ namespace paint
 #if defined(NANA_WINDOWS)
 				::BitBlt(dst.impl_->handle->context, x, y, r_src.width, r_src.height, impl_->handle->context, r_src.x, r_src.y, SRCCOPY);
 #elif defined(NANA_X11)
+				if (impl_->handle->pixbuf_ptr)
+				{
+					nana::detail::headless::copy(dst.impl_->handle, point{ x, y }, impl_->handle, r_src);
+					return;
+				}
+
 				Display* display = nana::detail::platform_spec::instance().open_display();
 				::XCopyArea(display,
 					impl_->handle->pixmap, dst.impl_->handle->pixmap, impl_->handle->context,
@@ -1123,9 +1190,16 @@ namespace paint
 #if defined(NANA_WINDOWS)
 				::SetPixel(impl_->handle->context, x, y, impl_->handle->bgcolor_native);
 #elif defined(NANA_X11)
-				Display* disp = nana::detail::platform_spec::instance().open_display();
-				impl_->handle->update_color();
-				::XDrawPoint(disp, impl_->handle->pixmap, impl_->handle->context, x, y);
+				if (impl_->handle->pixbuf_ptr)
+				{
+					nana::detail::headless::set_pixel(impl_->handle, x, y, impl_->handle->bgcolor_rgb);
+				}
+				else
+				{
+					Display* disp = nana::detail::platform_spec::instance().open_display();
+					impl_->handle->update_color();
+					::XDrawPoint(disp, impl_->handle->pixmap, impl_->handle->context, x, y);
+				}
 #endif
 				if (impl_->changed == false) impl_->changed = true;
 			}
@@ -1134,7 +1208,8 @@ namespace paint
 #ifdef _nana_std_has_string_view
 		unsigned graphics::bidi_string(const point& pos, std::string_view utf8str)
 		{
-			return bidi_string(pos, to_wstring(utf8str));
+			utf::scratch_wstring wstr{ utf8str.data(), utf8str.size() };
+			return bidi_string(pos, std::wstring_view{ wstr.data(), wstr.size() });
 		}
 
 		unsigned graphics::bidi_string(const nana::point& pos, std::wstring_view str)
@@ -1158,7 +1233,8 @@ namespace paint
 
 		void graphics::string(const point& pos, std::string_view utf8str)
 		{
-			this->string(pos, to_wstring(utf8str));
+			utf::scratch_wstring wstr{ utf8str.data(), utf8str.size() };
+			this->string(pos, std::wstring_view{ wstr.data(), wstr.size() });
 		}
 
 		void graphics::string(const point& pos, std::string_view utf8str, const nana::color& text_color)
@@ -1237,13 +1313,13 @@ namespace paint
 
 		unsigned graphics::bidi_string(const point& pos, const char* str, std::size_t len)
 		{
-			std::wstring wstr = ::nana::charset(std::string(str, str + len), ::nana::unicode::utf8);
+			utf::scratch_wstring wstr{ str, len };
 			return bidi_string(pos, wstr.data(), wstr.size());
 		}
 
 		void graphics::string(const point& pos, const std::string& text_utf8)
 		{
-			string(pos, to_wstring(text_utf8));
+			string(pos, utf::scratch_wstring{ text_utf8 }.str());
 		}
 
 		void graphics::string(const point& pos, const std::string& text_utf8, const color& clr)
@@ -1326,9 +1402,16 @@ namespace paint
 			}
 			::SetPixel(impl_->handle->context, pos2.x, pos2.y, impl_->handle->bgcolor_native);
 #elif defined(NANA_X11)
-			Display* disp = nana::detail::platform_spec::instance().open_display();
-			impl_->handle->update_color();
-			::XDrawLine(disp, impl_->handle->pixmap, impl_->handle->context, pos1.x, pos1.y, pos2.x, pos2.y);
+			if (impl_->handle->pixbuf_ptr)
+			{
+				nana::detail::headless::line(impl_->handle, pos1, pos2, impl_->handle->bgcolor_rgb);
+			}
+			else
+			{
+				Display* disp = nana::detail::platform_spec::instance().open_display();
+				impl_->handle->update_color();
+				::XDrawLine(disp, impl_->handle->pixmap, impl_->handle->context, pos1.x, pos1.y, pos2.x, pos2.y);
+			}
 #endif
 			if (impl_->changed == false) impl_->changed = true;
 		}
@@ -1356,11 +1439,18 @@ namespace paint
 
 			::DeleteObject(::SelectObject(impl_->handle->context, prv_pen));
 #elif defined(NANA_X11)
-			Display* disp = nana::detail::platform_spec::instance().open_display();
-			impl_->handle->update_color();
-			::XDrawLine(disp, impl_->handle->pixmap, impl_->handle->context,
-				impl_->handle->line_begin_pos.x, impl_->handle->line_begin_pos.y,
-				pos.x, pos.y);
+			if (impl_->handle->pixbuf_ptr)
+			{
+				nana::detail::headless::line(impl_->handle, impl_->handle->line_begin_pos, pos, impl_->handle->bgcolor_rgb);
+			}
+			else
+			{
+				Display* disp = nana::detail::platform_spec::instance().open_display();
+				impl_->handle->update_color();
+				::XDrawLine(disp, impl_->handle->pixmap, impl_->handle->context,
+					impl_->handle->line_begin_pos.x, impl_->handle->line_begin_pos.y,
+					pos.x, pos.y);
+			}
 			impl_->handle->line_begin_pos = pos;
 #endif
 			if (impl_->changed == false) impl_->changed = true;
@@ -1391,12 +1481,22 @@ namespace paint
 
 				::DeleteObject(brush);
 #elif defined(NANA_X11)
-				Display* disp = nana::detail::platform_spec::instance().open_display();
-				impl_->handle->update_color();
-				if (solid)
-					::XFillRectangle(disp, impl_->handle->pixmap, impl_->handle->context, r.x, r.y, r.width, r.height);
+				if (impl_->handle->pixbuf_ptr)
+				{
+					if (solid)
+						nana::detail::headless::fill(impl_->handle, r, impl_->handle->bgcolor_rgb);
+					else
+						nana::detail::headless::frame(impl_->handle, ::nana::rectangle{ r.x, r.y, r.width - 1, r.height - 1 }, impl_->handle->bgcolor_rgb);
+				}
 				else
-					::XDrawRectangle(disp, impl_->handle->pixmap, impl_->handle->context, r.x, r.y, r.width - 1, r.height - 1);
+				{
+					Display* disp = nana::detail::platform_spec::instance().open_display();
+					impl_->handle->update_color();
+					if (solid)
+						::XFillRectangle(disp, impl_->handle->pixmap, impl_->handle->context, r.x, r.y, r.width, r.height);
+					else
+						::XDrawRectangle(disp, impl_->handle->pixmap, impl_->handle->context, r.x, r.y, r.width - 1, r.height - 1);
+				}
 #endif
 				if (impl_->changed == false) impl_->changed = true;
 			}
@@ -1453,6 +1553,16 @@ namespace paint
 #elif defined(NANA_X11)
 			if (nullptr == impl_->handle) return;
 
+			if (impl_->handle->pixbuf_ptr)
+			{
+				//The memory surface is accessed directly in headless mode
+				pixel_buffer pxbuf;
+				pxbuf.attach(impl_->handle, ::nana::rectangle{ size() });
+				pxbuf.gradual_rectangle(rct, from, to, 0.0, vertical);
+				if (impl_->changed == false) impl_->changed = true;
+				return;
+			}
+
 			nana::rectangle good_rct;
 			if(!nana::overlap(nana::rectangle{ size() }, rct, good_rct))
 				return;
@@ -1594,5 +1704,19 @@ namespace paint
 		}
 	//end class draw
 
+	glyph_cache_statistics glyph_cache_stats()
+	{
+		return platform_abstraction::glyph_cache_stats();
+	}
+
+	shaped_run_cache_statistics shaped_run_cache_stats()
+	{
+		return platform_abstraction::shaped_run_cache_stats();
+	}
+
+	void shaped_run_cache_capacity(std::size_t bytes)
+	{
+		platform_abstraction::shaped_run_cache_capacity(bytes);
+	}
 }//end namespace paint
 }//end namespace nana
@@ -21,6 +21,20 @@
 #include <cstring>
 #include <cmath>
 
+#if defined(NANA_X11)
+#	include "../detail/posix/headless_surface.hpp"
+#endif
+
+#if defined(NANA_X11) && defined(NANA_ENABLE_XSHM)
+#	include <X11/extensions/XShm.h>
+#	include <sys/ipc.h>
+#	include <sys/shm.h>
+#	include <cstdlib>
+#	include <algorithm>
+#	include <mutex>
+#	include <vector>
+#endif
+
 namespace nana{	namespace paint
 {
 	nana::rectangle valid_rectangle(const size& s, const rectangle& r)
@@ -45,6 +59,196 @@ namespace nana{	namespace paint
 	}
 #endif
 
+#if defined(NANA_X11) && defined(NANA_ENABLE_XSHM)
+	/// A XImage whose pixels are stored in a MIT-SHM segment, the X server reads and writes
+	/// the pixels directly instead of transferring them through the socket.
+	class xshm_image
+		: private nana::noncopyable
+	{
+		struct segment
+		{
+			XShmSegmentInfo info;
+			std::size_t bytes;
+		};
+
+		//The released segments are kept for reuse, because creating and attaching a segment requires
+		//a few system calls and a round trip to the X server.
+		struct segment_pool
+		{
+			static const std::size_t max_segments = 4;
+
+			std::mutex mutex;
+			bool disabled{ false };
+			std::vector<segment*> segments;
+		};
+	public:
+		//The small images are transferred by the XImage, it's cheaper than a shared memory segment.
+		static const std::size_t min_pixels = 128 * 128;
+
+		/// Creates an image in shared memory. Returns nullptr if the MIT-SHM is not available
+		static std::unique_ptr<xshm_image> create(unsigned width, unsigned height)
+		{
+			if ((static_cast<std::size_t>(width) * height < min_pixels) || !_m_supported())
+				return nullptr;
+
+			auto & spec = nana::detail::platform_spec::instance();
+			const int depth = spec.screen_depth();
+			if (24 != depth && 32 != depth)
+				return nullptr;
+
+			nana::detail::platform_scope_guard psg;
+
+			std::unique_ptr<xshm_image> ximg{ new xshm_image };
+			ximg->image_ = ::XShmCreateImage(spec.open_display(), spec.screen_visual(), depth, ZPixmap, nullptr, nullptr, width, height);
+			if (nullptr == ximg->image_)
+				return nullptr;
+
+			//The layout of pixels should be identical to pixel_buffer.
+			if ((32 != ximg->image_->bits_per_pixel) || (ximg->image_->bytes_per_line != static_cast<int>(width * sizeof(pixel_color_t))))
+				return nullptr;
+
+			ximg->segment_ = _m_acquire(static_cast<std::size_t>(ximg->image_->bytes_per_line) * height);
+			if (nullptr == ximg->segment_)
+				return nullptr;
+
+			ximg->image_->data = ximg->segment_->info.shmaddr;
+			ximg->image_->obdata = reinterpret_cast<char*>(&ximg->segment_->info);
+			return ximg;
+		}
+
+		~xshm_image()
+		{
+			if (image_)
+			{
+				image_->data = nullptr;
+				image_->obdata = nullptr;
+				XDestroyImage(image_);
+			}
+
+			if (segment_)
+				_m_release(segment_);
+		}
+
+		XImage* image() const
+		{
+			return image_;
+		}
+	private:
+		xshm_image() = default;
+
+		static segment_pool& _m_pool()
+		{
+			static segment_pool pool;
+			return pool;
+		}
+
+		static bool _m_supported()
+		{
+			//The MIT-SHM can be disabled by the environment variable, e.g. to test the XImage transport under Xvfb.
+			static const bool supported = []
+			{
+				if (std::getenv("NANA_DISABLE_XSHM") || nana::detail::platform_spec::instance().headless())
+					return false;
+
+				nana::detail::platform_scope_guard psg;
+				int major, minor;
+				Bool pixmaps;
+				return (True == ::XShmQueryVersion(nana::detail::platform_spec::instance().open_display(), &major, &minor, &pixmaps));
+			}();
+
+			if (!supported)
+				return false;
+
+			auto & pool = _m_pool();
+			std::lock_guard<std::mutex> lock(pool.mutex);
+			return !pool.disabled;
+		}
+
+		static segment* _m_acquire(std::size_t bytes)
+		{
+			auto & pool = _m_pool();
+			{
+				std::lock_guard<std::mutex> lock(pool.mutex);
+
+				//Picks the smallest segment which is large enough
+				auto fit = pool.segments.end();
+				for (auto i = pool.segments.begin(); i != pool.segments.end(); ++i)
+				{
+					if (((*i)->bytes >= bytes) && ((fit == pool.segments.end()) || ((*i)->bytes < (*fit)->bytes)))
+						fit = i;
+				}
+
+				if (fit != pool.segments.end())
+				{
+					auto seg = *fit;
+					pool.segments.erase(fit);
+					return seg;
+				}
+			}
+
+			std::unique_ptr<segment> seg{ new segment };
+			seg->bytes = bytes;
+			seg->info.shmid = ::shmget(IPC_PRIVATE, bytes, IPC_CREAT | 0600);
+			if (seg->info.shmid < 0)
+				return nullptr;
+
+			seg->info.shmaddr = static_cast<char*>(::shmat(seg->info.shmid, nullptr, 0));
+			if (reinterpret_cast<char*>(-1) == seg->info.shmaddr)
+			{
+				::shmctl(seg->info.shmid, IPC_RMID, nullptr);
+				return nullptr;
+			}
+			seg->info.readOnly = False;
+
+			//The attaching fails if the X server is running on another machine, and the error is reported asynchronously.
+			auto & spec = nana::detail::platform_spec::instance();
+			spec.set_error_handler();
+			const Status attached = ::XShmAttach(spec.open_display(), &seg->info);
+			const bool failed = (!attached || spec.rev_error_handler());
+
+			//The segment is destroyed after the client and the X server detach it, so that it isn't leaked even if the process crashes.
+			::shmctl(seg->info.shmid, IPC_RMID, nullptr);
+
+			if (failed)
+			{
+				::shmdt(seg->info.shmaddr);
+
+				std::lock_guard<std::mutex> lock(pool.mutex);
+				pool.disabled = true;
+				return nullptr;
+			}
+			return seg.release();
+		}
+
+		static void _m_release(segment* seg)
+		{
+			auto & pool = _m_pool();
+			{
+				std::lock_guard<std::mutex> lock(pool.mutex);
+				pool.segments.push_back(seg);
+				if (pool.segments.size() <= segment_pool::max_segments)
+					return;
+
+				//Discards the smallest segment
+				auto smallest = std::min_element(pool.segments.begin(), pool.segments.end(), [](const segment* a, const segment* b)
+				{
+					return a->bytes < b->bytes;
+				});
+				seg = *smallest;
+				pool.segments.erase(smallest);
+			}
+
+			nana::detail::platform_scope_guard psg;
+			::XShmDetach(nana::detail::platform_spec::instance().open_display(), &seg->info);
+			::shmdt(seg->info.shmaddr);
+			delete seg;
+		}
+	private:
+		XImage* image_{ nullptr };
+		segment* segment_{ nullptr };
+	};
+#endif
+
 	struct pixel_buffer::pixel_buffer_storage
 		: private nana::noncopyable
 	{
@@ -56,9 +260,29 @@ namespace nana{	namespace paint
 			if (pixel_size.empty())
 				return false;
 
+#if defined(NANA_X11) && defined(NANA_ENABLE_XSHM)
+			x11.shm = xshm_image::create(pixel_size.width, pixel_size.height);
+			if (x11.shm)
+			{
+				x11.image = x11.shm->image();
+				x11.attached = false;
+				raw_pixel_buffer = reinterpret_cast<pixel_color_t*>(x11.image->data);
+				return true;
+			}
+#endif
+
 			std::unique_ptr<pixel_color_t[]> pxbuf{ new pixel_color_t[pixel_size.width * pixel_size.height] };
 #if defined(NANA_X11)
 			auto & spec = nana::detail::platform_spec::instance();
+			if (spec.headless())
+			{
+				//The XImage is not required, because the pixels are copied to memory surface directly.
+				x11.image = nullptr;
+				x11.attached = false;
+				raw_pixel_buffer = pxbuf.release();
+				return true;
+			}
+
 			x11.image = ::XCreateImage(spec.open_display(), spec.screen_visual(), 32, ZPixmap, 0, reinterpret_cast<char*>(pxbuf.get()), pixel_size.width, pixel_size.height, 32, 0);
 			x11.attached = false;
 			if (!x11.image)
@@ -86,6 +310,9 @@ namespace nana{	namespace paint
 		{
 			bool attached;
 			XImage * image;
+#if defined(NANA_ENABLE_XSHM)
+			std::unique_ptr<xshm_image> shm;	//The image is in shared memory if it is not null
+#endif
 		}x11;
 #endif
 
@@ -135,10 +362,33 @@ namespace nana{	namespace paint
 #endif
 		{
 #if defined(NANA_X11)
+			if (drawable->pixbuf_ptr)
+			{
+				//Copies the pixels of memory surface, they are put back when the storage is destroyed, like the XImage.
+				x11.image = nullptr;
+				x11.attached = true;
+				raw_pixel_buffer = new pixel_color_t[valid_r.width * valid_r.height];
+				nana::detail::headless::blit(raw_pixel_buffer, bytes_per_line, pixel_size, point{},
+					drawable->pixbuf_ptr, drawable->bytes_per_line, drawable->pixbuf_size, valid_r);
+				return;
+			}
+
 			nana::detail::platform_spec & spec = nana::detail::platform_spec::instance();
 
 			//Ensure that the pixmap is updated before we copy its content.
 			::XFlush(spec.open_display());
+
+#if defined(NANA_ENABLE_XSHM)
+			x11.shm = xshm_image::create(valid_r.width, valid_r.height);
+			if (x11.shm && ::XShmGetImage(spec.open_display(), drawable->pixmap, x11.shm->image(), valid_r.x, valid_r.y, AllPlanes))
+			{
+				x11.image = x11.shm->image();
+				x11.attached = true;
+				raw_pixel_buffer = reinterpret_cast<pixel_color_t*>(x11.image->data);
+				return;
+			}
+			x11.shm.reset();
+#endif
 			x11.image = ::XGetImage(spec.open_display(), drawable->pixmap, valid_r.x, valid_r.y, valid_r.width, valid_r.height, AllPlanes, ZPixmap);
 			x11.attached = true;
 			if(nullptr == x11.image)
@@ -170,6 +420,24 @@ namespace nana{	namespace paint
 		~pixel_buffer_storage()
 		{
 #if defined(NANA_X11)
+			if(nullptr == x11.image)
+			{
+				//headless mode
+				if(drawable && x11.attached)
+					put(drawable, 0, 0, valid_r.x, valid_r.y, valid_r.width, valid_r.height);
+
+				delete [] raw_pixel_buffer;
+				return;
+			}
+#	if defined(NANA_ENABLE_XSHM)
+			if(x11.shm)
+			{
+				//The pixels are owned by the shared memory image
+				if(drawable && x11.attached)
+					put(drawable->pixmap, drawable->context, 0, 0, valid_r.x, valid_r.y, valid_r.width, valid_r.height);
+				return;
+			}
+#	endif
 			if(nullptr == drawable) //not attached
 				x11.image->data = nullptr;	//the image data is allocated by pixel_buffer when it is not attached with a drawable
 			else if(x11.attached)	//the image should be uploaded when it is attached.
@@ -341,12 +609,30 @@ namespace nana{	namespace paint
 			x11.attached = false;
 		}
 
+		//Puts the pixels to the memory surface of a headless drawable
+		void put(drawable_type dw, int src_x, int src_y, int x, int y, unsigned width, unsigned height)
+		{
+			nana::detail::headless::blit(dw->pixbuf_ptr, dw->bytes_per_line, dw->pixbuf_size, point{ x, y },
+				raw_pixel_buffer, bytes_per_line, pixel_size, nana::rectangle{ src_x, src_y, width, height });
+		}
+
 		void put(Drawable dw, GC gc, int src_x, int src_y, int x, int y, unsigned width, unsigned height)
 		{
 			auto & spec = nana::detail::platform_spec::instance();
 			Display * disp = spec.open_display();
 			const int depth = spec.screen_depth();
 
+#if defined(NANA_ENABLE_XSHM)
+			if(x11.shm)
+			{
+				::XShmPutImage(disp, dw, gc, x11.image, src_x, src_y, x, y, width, height, False);
+
+				//Waits for the X server to finish reading the pixels, because they may be modified after put().
+				::XSync(disp, False);
+				return;
+			}
+#endif
+
 			XImage* img = ::XCreateImage(disp, spec.screen_visual(), depth, ZPixmap, 0, 0, pixel_size.width, pixel_size.height, (16 == depth ? 16 : 32), 0);
 			if(sizeof(pixel_color_t) * 8 == depth || 24 == depth)
 			{
@@ -512,6 +798,14 @@ namespace nana{	namespace paint
 
 		return (want_r.height == read_lines);
 #elif defined(NANA_X11)
+		if (drawable->pixbuf_ptr)
+		{
+			storage_ = std::make_shared<pixel_buffer_storage>(want_r.width, want_r.height);
+			nana::detail::headless::blit(storage_->raw_pixel_buffer, storage_->bytes_per_line, storage_->pixel_size, point{ r.x - want_r.x, r.y - want_r.y },
+				drawable->pixbuf_ptr, drawable->bytes_per_line, drawable->pixbuf_size, r);
+			return true;
+		}
+
 		nana::detail::platform_spec & spec = nana::detail::platform_spec::instance();
 		Window root;
 		int x, y;
@@ -520,9 +814,16 @@ namespace nana{	namespace paint
 		nana::detail::platform_scope_guard psg;
 		::XFlush(spec.open_display());
 		::XGetGeometry(spec.open_display(), drawable->pixmap, &root, &x, &y, &width, &height, &border, &depth);
-		XImage * image = ::XGetImage(spec.open_display(), drawable->pixmap, r.x, r.y, r.width, r.height, AllPlanes, ZPixmap);
 
 		storage_ = std::make_shared<pixel_buffer_storage>(want_r.width, want_r.height);
+
+#if defined(NANA_ENABLE_XSHM)
+		//Reads the pixels into the shared memory of pixel buffer directly
+		if(storage_->x11.shm && (r == want_r) && ::XShmGetImage(spec.open_display(), drawable->pixmap, storage_->x11.image, r.x, r.y, AllPlanes))
+			return true;
+#endif
+
+		XImage * image = ::XGetImage(spec.open_display(), drawable->pixmap, r.x, r.y, r.width, r.height, AllPlanes, ZPixmap);
 		auto pixbuf = storage_->raw_pixel_buffer;
 		if(image->depth == 32 || (image->depth == 24 && image->bitmap_pad == 32))
 		{
@@ -779,7 +1080,10 @@ namespace nana{	namespace paint
 				src_r.x, static_cast<int>(sp->pixel_size.height) - src_r.y - src_r.height, 0, sp->pixel_size.height,
 				sp->raw_pixel_buffer, &bi, DIB_RGB_COLORS);
 #elif defined(NANA_X11)
-			sp->put(drawable->pixmap, drawable->context, src_r.x, src_r.y, p_dst.x, p_dst.y, src_r.width, src_r.height);
+			if (drawable->pixbuf_ptr)
+				sp->put(drawable, src_r.x, src_r.y, p_dst.x, p_dst.y, src_r.width, src_r.height);
+			else
+				sp->put(drawable->pixmap, drawable->context, src_r.x, src_r.y, p_dst.x, p_dst.y, src_r.width, src_r.height);
 #endif
 		}
 	}
@@ -804,6 +1108,11 @@ namespace nana{	namespace paint
 		}
 #elif defined(NANA_X11)
 		auto & spec = nana::detail::platform_spec::instance();
+
+		//There is not a window in headless mode.
+		if (spec.headless())
+			return;
+
 		Display * disp = spec.open_display();
 		sp->put(reinterpret_cast<Window>(wd), XDefaultGC(disp, XDefaultScreen(disp)), 0, 0, p_dst.x, p_dst.y, sp->pixel_size.width, sp->pixel_size.height);
 #endif
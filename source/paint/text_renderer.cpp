@@ -580,7 +580,7 @@ namespace nana
 		// Draws a text with specified text alignment.
 		void aligner::draw(const std::string& text, point pos, unsigned width)
 		{
-			draw(to_wstring(text), pos, width);
+			draw(utf::scratch_wstring{ text }.str(), pos, width);
 		}
 
 		void aligner::draw(const std::wstring& text, point pos, unsigned width)